@@ -6,7 +6,10 @@ adventure game data between the Python editor and C engine.
 """
 
 import json
-from typing import Dict, List, Any, Optional
+import os
+import struct
+from concurrent.futures import ProcessPoolExecutor
+from typing import Dict, List, Any, Optional, Tuple
 from pathlib import Path
 
 
@@ -16,6 +19,30 @@ class AdvGPTFormat:
     for creating, validating, and manipulating game data.
     """
     
+    # Compiled bundle constants, kept in sync with engine/src/bundle.h
+    BUNDLE_MAGIC = b"AGPB"
+    BUNDLE_VERSION = 1
+    BUNDLE_NONE = 0xFFFFFFFF
+    BUNDLE_ITEM_TAKEABLE = 1
+    BUNDLE_ITEM_USEABLE = 2
+    BUNDLE_HEADER_FORMAT = "<4s29I"
+    BUNDLE_LOCATION_FORMAT = "<14I"
+    BUNDLE_EXIT_FORMAT = "<3I"
+    BUNDLE_ITEM_FORMAT = "<5I"
+    BUNDLE_FLAG_VALUE_FORMAT = "<2I"
+    
+    # Pre-converted image pack constants, kept in sync with engine/src/image_pack.h
+    IMAGE_PACK_MAGIC = b"AGIM"
+    IMAGE_PACK_VERSION = 1
+    IMAGE_PACK_EXTENSION = ".agimg"
+    IMAGE_PACK_XRGB8888 = 0
+    IMAGE_PACK_RGB565 = 1
+    IMAGE_PACK_HEADER_FORMAT = "<4s2I"
+    IMAGE_PACK_LEVEL_FORMAT = "<4I"
+    # The engine's image area, and how many halvings of it a pack carries
+    IMAGE_PACK_SIZE = (1024, 568)
+    IMAGE_PACK_LEVELS = 3
+    
     @staticmethod
     def create_empty_game() -> Dict[str, Any]:
         """Create an empty game structure with default values."""
@@ -146,6 +173,93 @@ class AdvGPTFormat:
         
         return errors
     
+    @staticmethod
+    def validate_regions(manifest_path: str, max_workers: Optional[int] = None) -> List[str]:
+        """
+        Validate a manifest and the region files its "regions" list names,
+        checking each region in a worker process and then everything that spans
+        regions: exits, item references and the start location. Per-region
+        results are cached against each file's size and modification time, so
+        validating again after an edit only re-reads the regions that changed.
+        Returns an empty list if the whole world is valid.
+        """
+        try:
+            manifest_file = Path(manifest_path)
+            with open(manifest_file, 'r', encoding='utf-8') as f:
+                manifest = json.load(f)
+        except Exception as e:
+            return [f"Could not read manifest '{manifest_path}': {e}"]
+        
+        errors = []
+        for key in ["meta", "start_location", "player", "regions"]:
+            if key not in manifest:
+                errors.append(f"Missing required key: {key}")
+        if errors:
+            return errors
+        
+        # Region paths are relative to the manifest, which counts as the first region
+        paths = [str(manifest_file)]
+        paths += [str(manifest_file.parent / region) for region in manifest["regions"]]
+        
+        stale = []
+        for path in paths:
+            try:
+                stat = os.stat(path)
+            except OSError as e:
+                errors.append(f"Could not read region '{path}': {e}")
+                continue
+            cached = _region_cache.get(path)
+            if cached is None or cached[0] != (stat.st_size, stat.st_mtime_ns):
+                stale.append((path, (stat.st_size, stat.st_mtime_ns)))
+        if errors:
+            return errors
+        
+        if len(stale) > 1:
+            with ProcessPoolExecutor(max_workers=max_workers) as pool:
+                summaries = list(pool.map(_summarize_region, [path for path, _ in stale]))
+        else:
+            summaries = [_summarize_region(path) for path, _ in stale]
+        for (path, version), summary in zip(stale, summaries):
+            _region_cache[path] = (version, summary)
+        
+        # Merge in list order like the engine: the first definition of an id wins
+        locations = set()
+        items = set()
+        for path in paths:
+            summary = _region_cache[path][1]
+            errors.extend(summary["errors"])
+            locations.update(summary["locations"])
+            items.update(summary["items"])
+        
+        for path in paths:
+            summary = _region_cache[path][1]
+            for loc_id, direction, target in summary["exits"]:
+                if target not in locations:
+                    errors.append(f"Location '{loc_id}' exit '{direction}' points to non-existent location '{target}'")
+            for loc_id, item_id in summary["item_refs"]:
+                if item_id not in items:
+                    errors.append(f"Location '{loc_id}' lists non-existent item '{item_id}'")
+        
+        meta = manifest["meta"]
+        for key in ["title", "author", "version"]:
+            if key not in meta:
+                errors.append(f"Missing meta key: {key}")
+        
+        if manifest["start_location"] not in locations:
+            errors.append(f"Start location '{manifest['start_location']}' not found in locations")
+        
+        player = manifest["player"]
+        for key in ["inventory", "current_location", "flags"]:
+            if key not in player:
+                errors.append(f"Missing player key: {key}")
+        if "current_location" in player and player["current_location"] not in locations:
+            errors.append(f"Player current_location '{player['current_location']}' not found in locations")
+        for item_id in player.get("inventory", []):
+            if item_id not in items:
+                errors.append(f"Player inventory lists non-existent item '{item_id}'")
+        
+        return errors
+    
     @staticmethod
     def _validate_location(loc_id: str, location: Dict[str, Any], all_locations: Dict[str, Any]) -> List[str]:
         """Validate a single location."""
@@ -165,6 +279,56 @@ class AdvGPTFormat:
         
         return errors
     
+    @staticmethod
+    def find_unreachable_locations(game_data: Dict[str, Any]) -> List[str]:
+        """
+        Return the ids of locations no sequence of moves from the start can reach.
+        A location whose flags_required asks for a value no default, location or
+        item effect ever gives that flag is treated as closed; every other
+        requirement is assumed satisfiable.
+        """
+        locations = game_data.get("locations", {})
+        start = game_data.get("player", {}).get("current_location") or game_data.get("start_location")
+        if start not in locations:
+            return []
+        
+        # Every value each flag can ever hold
+        possible: Dict[str, set] = {}
+        initial = dict(game_data.get("game_flags", {}))
+        initial.update(game_data.get("player", {}).get("flags", {}))
+        effects = [location.get("flags_set", {}) for location in locations.values()]
+        effects += [item.get("use_flags_set", {}) for item in game_data.get("inventory_items", {}).values()]
+        for flags in [initial] + effects:
+            for flag, value in flags.items():
+                possible.setdefault(flag, set()).add(bool(value))
+        
+        def can_enter(location: Dict[str, Any]) -> bool:
+            return all(bool(value) in possible.get(flag, {False})
+                       for flag, value in location.get("flags_required", {}).items())
+        
+        reached = {start}
+        frontier = [start]
+        while frontier:
+            location = locations[frontier.pop()]
+            for target in location.get("exits", {}).values():
+                if target in locations and target not in reached and can_enter(locations[target]):
+                    reached.add(target)
+                    frontier.append(target)
+        
+        return [loc_id for loc_id in locations if loc_id not in reached]
+    
+    @staticmethod
+    def replace_file(file_path: str, data: bytes) -> None:
+        """
+        Write a file by renaming a finished copy over it. An engine running with
+        --watch maps bundles and lazily loaded games, so the file it has open
+        must never be rewritten in place.
+        """
+        temp_path = f"{file_path}.tmp"
+        with open(temp_path, 'wb') as f:
+            f.write(data)
+        os.replace(temp_path, file_path)
+    
     @staticmethod
     def save_to_file(game_data: Dict[str, Any], file_path: str) -> bool:
         """Save game data to .advgpt file. Returns True on success."""
@@ -175,8 +339,8 @@ class AdvGPTFormat:
                 print(f"Validation errors: {errors}")
                 return False
             
-            with open(file_path, 'w', encoding='utf-8') as f:
-                json.dump(game_data, f, indent=2, ensure_ascii=False)
+            text = json.dumps(game_data, indent=2, ensure_ascii=False)
+            AdvGPTFormat.replace_file(file_path, text.encode('utf-8'))
             return True
         except Exception as e:
             print(f"Error saving game data: {e}")
@@ -200,6 +364,216 @@ class AdvGPTFormat:
             print(f"Error loading game data: {e}")
             return None
     
+    @staticmethod
+    def compile_bundle(game_data: Dict[str, Any]) -> bytes:
+        """
+        Compile game data into the binary .advgptb bundle the engine maps
+        directly. Identifiers are resolved to dense indices here, in the same
+        order the engine's JSON loader interns them, so loading needs no parsing.
+        """
+        strings: Dict[str, int] = {}
+        pool = bytearray()
+        
+        def string(value: Any) -> int:
+            value = value if isinstance(value, str) else ""
+            if value not in strings:
+                strings[value] = len(pool)
+                pool.extend(value.encode("utf-8") + b"\0")
+            return strings[value]
+        
+        string("")  # Offset 0 is the empty string
+        
+        def interner(names: List[str]):
+            index = {name: i for i, name in enumerate(names)}
+            def intern(name: str) -> int:
+                if name not in index:
+                    index[name] = len(names)
+                    names.append(name)
+                return index[name]
+            return intern
+        
+        locations = game_data.get("locations", {})
+        location_index = {location_id: i for i, location_id in enumerate(locations)}
+        item_names = list(game_data.get("inventory_items", {}))
+        item_symbol = interner(item_names)
+        flag_names: List[str] = []
+        flag_symbol = interner(flag_names)
+        
+        flag_values: List[tuple] = []
+        item_refs: List[int] = []
+        
+        def flag_range(flags: Any) -> tuple:
+            first = len(flag_values)
+            if isinstance(flags, dict):
+                for name, value in flags.items():
+                    flag_values.append((flag_symbol(name), 1 if value is True else 0))
+            return first, len(flag_values) - first
+        
+        def item_range(items: Any) -> tuple:
+            first = len(item_refs)
+            if isinstance(items, list):
+                item_refs.extend(item_symbol(item) for item in items if isinstance(item, str))
+            return first, len(item_refs) - first
+        
+        game_flags = flag_range(game_data.get("game_flags", {}))
+        
+        location_records = bytearray()
+        exit_records = bytearray()
+        exits_count = 0
+        for location_id, location in locations.items():
+            exits = {direction: target for direction, target in location.get("exits", {}).items()
+                     if isinstance(target, str)}
+            for direction, target in exits.items():
+                exit_records += struct.pack(
+                    AdvGPTFormat.BUNDLE_EXIT_FORMAT, string(direction), string(target),
+                    location_index.get(target, AdvGPTFormat.BUNDLE_NONE))
+            
+            items = item_range(location.get("items", []))
+            # Conditions intern their flags in key order, as the JSON loader reads them
+            conditions = {key: flag_range(value) for key, value in location.items()
+                          if key in ("flags_required", "flags_set")}
+            flags_required = conditions.get("flags_required", (len(flag_values), 0))
+            flags_set = conditions.get("flags_set", (len(flag_values), 0))
+            location_records += struct.pack(
+                AdvGPTFormat.BUNDLE_LOCATION_FORMAT,
+                string(location_id), string(location.get("title")), string(location.get("description")),
+                string(location.get("image")), string(location.get("first_visit_text")),
+                1 if location.get("visited") is True else 0,
+                exits_count, len(exits), *items, *flags_required, *flags_set)
+            exits_count += len(exits)
+        
+        player = game_data.get("player", {})
+        player_inventory = item_range(player.get("inventory", []))
+        player_flags = flag_range(player.get("flags", {}))
+        player_location = location_index.get(player.get("current_location"), AdvGPTFormat.BUNDLE_NONE)
+        
+        item_records = bytearray()
+        for item_id, item in game_data.get("inventory_items", {}).items():
+            attributes = ((AdvGPTFormat.BUNDLE_ITEM_TAKEABLE if item.get("takeable") is True else 0) |
+                          (AdvGPTFormat.BUNDLE_ITEM_USEABLE if item.get("useable") is True else 0))
+            item_records += struct.pack(
+                AdvGPTFormat.BUNDLE_ITEM_FORMAT, string(item_id), string(item.get("name")),
+                string(item.get("description")), string(item.get("use_text")), attributes)
+        
+        item_name_table = struct.pack(f"<{len(item_names)}I", *(string(name) for name in item_names))
+        flag_name_table = struct.pack(f"<{len(flag_names)}I", *(string(name) for name in flag_names))
+        flag_value_table = b"".join(struct.pack(AdvGPTFormat.BUNDLE_FLAG_VALUE_FORMAT, *value)
+                                    for value in flag_values)
+        item_ref_table = struct.pack(f"<{len(item_refs)}I", *item_refs)
+        
+        meta = game_data.get("meta", {})
+        meta_strings = (string(meta.get("title")), string(meta.get("author")),
+                        string(meta.get("description")), string(meta.get("version")),
+                        string(game_data.get("start_location")))
+        
+        # Tables follow the header in a fixed order; the string pool comes last
+        offset = struct.calcsize(AdvGPTFormat.BUNDLE_HEADER_FORMAT)
+        tables = []
+        for data, count in ((location_records, len(locations)), (exit_records, exits_count),
+                            (item_ref_table, len(item_refs)), (item_records, len(game_data.get("inventory_items", {}))),
+                            (item_name_table, len(item_names)), (flag_name_table, len(flag_names)),
+                            (flag_value_table, len(flag_values))):
+            tables.append((offset, count))
+            offset += len(data)
+        
+        header = struct.pack(
+            AdvGPTFormat.BUNDLE_HEADER_FORMAT,
+            AdvGPTFormat.BUNDLE_MAGIC, AdvGPTFormat.BUNDLE_VERSION,
+            offset, len(pool),
+            *(field for table in tables for field in table),
+            *meta_strings,
+            *game_flags, player_location, *player_inventory, *player_flags)
+        
+        return b"".join((header, location_records, exit_records, item_ref_table, item_records,
+                         item_name_table, flag_name_table, flag_value_table, bytes(pool)))
+    
+    @staticmethod
+    def save_bundle(game_data: Dict[str, Any], file_path: str) -> bool:
+        """Compile game data and save it as a .advgptb bundle. Returns True on success."""
+        try:
+            errors = AdvGPTFormat.validate_game_data(game_data)
+            if errors:
+                print(f"Validation errors: {errors}")
+                return False
+            
+            AdvGPTFormat.replace_file(file_path, AdvGPTFormat.compile_bundle(game_data))
+            return True
+        except Exception as e:
+            print(f"Error saving game bundle: {e}")
+            return False
+    
+    @staticmethod
+    def encode_pixels(image, low_color: bool = False) -> bytes:
+        """Raw rows of an RGB Pillow image in the engine's upload format."""
+        if not low_color:
+            # XRGB8888 as little-endian words is B, G, R, X in memory
+            return image.tobytes("raw", "BGRX")
+        
+        # RGB565 as little-endian halfwords, packed per channel in Pillow
+        from PIL import Image, ImageChops
+        red, green, blue = image.split()
+        low = ImageChops.add(green.point(lambda v: ((v >> 2) & 7) << 5), blue.point(lambda v: v >> 3))
+        high = ImageChops.add(red.point(lambda v: v & 0xF8), green.point(lambda v: v >> 5))
+        return Image.merge("LA", (low, high)).tobytes()
+    
+    @staticmethod
+    def compile_image_pack(image_path: str, low_color: bool = False, size=None, levels: Optional[int] = None) -> bytes:
+        """
+        Compile art into an .agimg pack: the image cropped to fill the engine's
+        image area, then halved for each further level, stored as raw pixels
+        so the engine reads them without decoding or converting.
+        """
+        from PIL import Image, ImageOps
+        width, height = size or AdvGPTFormat.IMAGE_PACK_SIZE
+        levels = levels or AdvGPTFormat.IMAGE_PACK_LEVELS
+        pixel_format = AdvGPTFormat.IMAGE_PACK_RGB565 if low_color else AdvGPTFormat.IMAGE_PACK_XRGB8888
+        
+        with Image.open(image_path) as source:
+            image = ImageOps.fit(source.convert("RGB"), (width, height), Image.LANCZOS)
+        
+        pixels = []
+        for _ in range(levels):
+            pixels.append((image.width, image.height, AdvGPTFormat.encode_pixels(image, low_color)))
+            if image.width < 2 or image.height < 2:
+                break
+            image = image.resize((image.width // 2, image.height // 2), Image.LANCZOS)
+        
+        header = struct.pack(AdvGPTFormat.IMAGE_PACK_HEADER_FORMAT, AdvGPTFormat.IMAGE_PACK_MAGIC,
+                             AdvGPTFormat.IMAGE_PACK_VERSION, len(pixels))
+        offset = len(header) + len(pixels) * struct.calcsize(AdvGPTFormat.IMAGE_PACK_LEVEL_FORMAT)
+        table = []
+        for level_width, level_height, data in pixels:
+            table.append(struct.pack(AdvGPTFormat.IMAGE_PACK_LEVEL_FORMAT, level_width, level_height, pixel_format, offset))
+            offset += len(data)
+        return b"".join([header, *table, *(data for _, _, data in pixels)])
+    
+    @staticmethod
+    def export_images(game_data: Dict[str, Any], export_dir: str, base_dir: str = ".",
+                      low_color: bool = False) -> Tuple[Dict[str, Any], List[str]]:
+        """
+        Compile every location's art into export_dir/images/<location id>.agimg.
+        Returns a copy of game_data pointing at the packs, for both the exported
+        .advgpt and the bundle, and a list of errors; a location whose art
+        cannot be read keeps its original image path.
+        """
+        exported = json.loads(json.dumps(game_data))
+        images_dir = Path(export_dir) / "images"
+        errors = []
+        for loc_id, location in exported.get("locations", {}).items():
+            image = location.get("image", "")
+            if not image:
+                continue
+            source = Path(image) if Path(image).is_absolute() else Path(base_dir) / image
+            pack_path = (Path("images") / f"{loc_id}{AdvGPTFormat.IMAGE_PACK_EXTENSION}").as_posix()
+            try:
+                data = AdvGPTFormat.compile_image_pack(str(source), low_color)
+                images_dir.mkdir(parents=True, exist_ok=True)
+                AdvGPTFormat.replace_file(str(Path(export_dir) / pack_path), data)
+                location["image"] = pack_path
+            except Exception as e:
+                errors.append(f"Could not convert image for location '{loc_id}': {e}")
+        return exported, errors
+    
     @staticmethod
     def get_format_specification() -> str:
         """Return a human-readable format specification."""
@@ -262,9 +636,42 @@ Key Concepts:
 - Items can be placed in locations and picked up by the player
 - Flags control game state and can gate access to locations or enable actions
 - Images are referenced by path and should be included in the game package
+- Exports also ship a compiled .advgptb bundle (see compile_bundle) that the
+  engine maps directly; .advgpt stays the authoring format
 """
 
 
+# Per-region validation results by path: ((size, mtime_ns), summary)
+_region_cache: Dict[str, Any] = {}
+
+
+def _summarize_region(path: str) -> Dict[str, Any]:
+    """
+    Check what one region file can check on its own and collect the ids it
+    defines and the references it makes, for validate_regions to resolve
+    across every region. Module level so worker processes can run it.
+    """
+    summary: Dict[str, Any] = {"errors": [], "locations": [], "items": [], "exits": [], "item_refs": []}
+    try:
+        with open(path, 'r', encoding='utf-8') as f:
+            region = json.load(f)
+    except Exception as e:
+        summary["errors"].append(f"Could not read region '{path}': {e}")
+        return summary
+    
+    summary["items"] = list(region.get("inventory_items", {}))
+    for loc_id, location in region.get("locations", {}).items():
+        summary["locations"].append(loc_id)
+        for key in ["title", "description", "exits"]:
+            if key not in location:
+                summary["errors"].append(f"Location '{loc_id}' missing required key: {key}")
+        for direction, target in location.get("exits", {}).items():
+            summary["exits"].append((loc_id, direction, target))
+        for item_id in location.get("items", []):
+            summary["item_refs"].append((loc_id, item_id))
+    return summary
+
+
 # Example usage and testing
 if __name__ == "__main__":
     # Create a sample game
@@ -319,4 +726,6 @@ if __name__ == "__main__":
             print(f"  - {error}")
     else:
         print("Game data is valid!")
+        for loc_id in AdvGPTFormat.find_unreachable_locations(game):
+            print(f"Warning: location '{loc_id}' cannot be reached from the start")
         print(json.dumps(game, indent=2)) 
\ No newline at end of file
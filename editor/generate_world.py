@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+"""
+AdventureGPT Synthetic World Generator
+
+Builds large, deterministic .advgpt worlds for scale testing the engine's
+loader and runtime. Every world is a ring of locations (so every room is
+reachable from the start) with extra random exits, items and flags layered
+on top.
+"""
+
+import argparse
+import random
+import sys
+from pathlib import Path
+from typing import Any, Dict, List
+
+from advgpt_format import AdvGPTFormat
+
+
+DIRECTIONS = [
+    "east", "west", "up", "down", "northeast", "northwest",
+    "southeast", "southwest", "in", "out"
+]
+
+WORDS = [
+    "ancient", "stone", "corridor", "shadow", "lantern", "moss", "arch", "silent",
+    "river", "tower", "dusty", "glimmering", "iron", "door", "window", "cold",
+    "wind", "echo", "carved", "pillar", "faded", "tapestry", "damp", "stair",
+    "hollow", "bright", "crystal", "broken", "wooden", "bridge", "distant", "bell"
+]
+
+
+def generate_description(rng: random.Random, word_count: int) -> str:
+    """Word salad of roughly word_count words, split into sentences."""
+    sentences = []
+    remaining = word_count
+    while remaining > 0:
+        length = min(remaining, rng.randint(6, 14))
+        words = [rng.choice(WORDS) for _ in range(length)]
+        sentences.append(" ".join(words).capitalize() + ".")
+        remaining -= length
+    return " ".join(sentences)
+
+
+def generate_world(
+    locations: int,
+    fanout: int = 4,
+    item_density: float = 0.2,
+    flags: int = 16,
+    flag_density: float = 0.05,
+    description_words: int = 40,
+    seed: int = 1
+) -> Dict[str, Any]:
+    """
+    Generate a world with the given shape. The same parameters and seed
+    always produce the same world.
+
+    fanout is the number of exits per location, including the north/south
+    ring links; item_density is the expected number of items per location;
+    flag_density is the chance that a location sets or requires a flag.
+    """
+    if locations < 1:
+        raise ValueError("a world needs at least one location")
+
+    rng = random.Random(seed)
+    game = AdvGPTFormat.create_empty_game()
+    game["meta"]["title"] = f"Generated World ({locations} locations)"
+    game["meta"]["author"] = "generate_world.py"
+    game["meta"]["description"] = f"Synthetic world, seed {seed}."
+
+    location_ids = [f"loc_{i}" for i in range(locations)]
+    flag_names = [f"flag_{i}" for i in range(flags)]
+    game["game_flags"] = {name: False for name in flag_names}
+
+    # Flags are set somewhere before they're required further along the ring,
+    # so walking the ring from the start can always reach every room
+    flag_setters = {}
+
+    game["locations"] = {}
+    game["inventory_items"] = {}
+    for i, location_id in enumerate(location_ids):
+        exits = {}
+        if locations > 1:
+            exits["north"] = location_ids[(i + 1) % locations]
+            exits["south"] = location_ids[(i - 1) % locations]
+
+        extra_exits = max(0, fanout - len(exits))
+        for e in range(extra_exits):
+            direction = DIRECTIONS[e] if e < len(DIRECTIONS) else f"passage_{e}"
+            exits[direction] = rng.choice(location_ids)
+
+        items: List[str] = []
+        item_count = int(item_density) + (1 if rng.random() < item_density % 1 else 0)
+        for _ in range(item_count):
+            item_id = f"item_{len(game['inventory_items'])}"
+            game["inventory_items"][item_id] = AdvGPTFormat.create_item(
+                item_id,
+                f"{rng.choice(WORDS).capitalize()} {rng.choice(WORDS)}",
+                generate_description(rng, max(1, description_words // 4)),
+                takeable=rng.random() < 0.8
+            )
+            items.append(item_id)
+
+        flags_set = {}
+        flags_required = {}
+        if flag_names and rng.random() < flag_density:
+            flag = rng.choice(flag_names)
+            flags_set[flag] = True
+            flag_setters.setdefault(flag, i)
+        if flag_names and i > 0 and rng.random() < flag_density:
+            flag = rng.choice(flag_names)
+            if flag_setters.get(flag, i) < i:
+                flags_required[flag] = True
+
+        game["locations"][location_id] = AdvGPTFormat.create_location(
+            location_id,
+            f"Room {i}",
+            generate_description(rng, description_words),
+            exits=exits,
+            items=items,
+            flags_required=flags_required,
+            flags_set=flags_set
+        )
+
+    game["start_location"] = location_ids[0]
+    game["player"]["current_location"] = location_ids[0]
+    return game
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Generate a synthetic .advgpt world for scale testing.")
+    parser.add_argument("--locations", type=int, default=1000, help="number of locations (default 1000)")
+    parser.add_argument("--fanout", type=int, default=4, help="exits per location (default 4)")
+    parser.add_argument("--item-density", type=float, default=0.2, help="items per location (default 0.2)")
+    parser.add_argument("--flags", type=int, default=16, help="number of game flags (default 16)")
+    parser.add_argument("--flag-density", type=float, default=0.05,
+                        help="chance a location sets or requires a flag (default 0.05)")
+    parser.add_argument("--description-words", type=int, default=40,
+                        help="words per location description (default 40)")
+    parser.add_argument("--seed", type=int, default=1, help="random seed (default 1)")
+    parser.add_argument("--bundle", action="store_true", help="also write a compiled .advgptb next to the output")
+    parser.add_argument("--output", required=True, help="path of the .advgpt file to write")
+    args = parser.parse_args()
+
+    try:
+        game = generate_world(
+            args.locations,
+            fanout=args.fanout,
+            item_density=args.item_density,
+            flags=args.flags,
+            flag_density=args.flag_density,
+            description_words=args.description_words,
+            seed=args.seed
+        )
+    except ValueError as e:
+        print(f"Error: {e}")
+        return 1
+
+    output = Path(args.output)
+    output.parent.mkdir(parents=True, exist_ok=True)
+    if not AdvGPTFormat.save_to_file(game, str(output)):
+        return 1
+
+    if args.bundle and not AdvGPTFormat.save_bundle(game, str(output.with_suffix(".advgptb"))):
+        return 1
+
+    exits = sum(len(location["exits"]) for location in game["locations"].values())
+    print(f"Generated {output}: {len(game['locations'])} locations, {exits} exits, "
+          f"{len(game['inventory_items'])} items, {len(game['game_flags'])} flags "
+          f"({output.stat().st_size} bytes)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,362 @@
+#!/usr/bin/env python3
+"""
+Batch AI image generation for AdventureGPT locations.
+
+Requests go through a bounded-concurrency asyncio queue. A rate-limited
+response pauses every worker until the server's Retry-After has passed, and
+other transient failures are retried with exponential backoff. Finished images
+are cropped to the engine's image area and stored in a content-addressed cache
+keyed by prompt and settings, so regenerating an unchanged room costs nothing.
+The module has no Qt dependency; the editor runs batches on a worker thread.
+"""
+
+import argparse
+import asyncio
+import base64
+import hashlib
+import io
+import json
+import os
+import random
+import sys
+import threading
+import time
+import urllib.error
+import urllib.request
+from concurrent.futures import ThreadPoolExecutor
+from dataclasses import asdict, dataclass
+from pathlib import Path
+from typing import Callable, Dict, List, Optional
+
+from PIL import Image, ImageOps
+
+from advgpt_format import AdvGPTFormat
+
+# The engine's image area (WINDOW_WIDTH by WINDOW_HEIGHT - TEXT_AREA_HEIGHT in
+# engine/src/main.c); art at exactly this size is never rescaled at runtime
+ENGINE_IMAGE_WIDTH = 1024
+ENGINE_IMAGE_HEIGHT = 568
+
+DEFAULT_API_URL = "https://api.openai.com/v1/images/generations"
+
+
+@dataclass(frozen=True)
+class ImageSettings:
+    """Everything besides the prompt that changes the generated image."""
+    model: str = "dall-e-3"
+    request_size: str = "1792x1024"  # Closest landscape size the service offers
+    style: str = "Atmospheric digital painting of a text adventure location"
+    width: int = ENGINE_IMAGE_WIDTH
+    height: int = ENGINE_IMAGE_HEIGHT
+
+
+@dataclass
+class ImageJob:
+    location_id: str
+    prompt: str
+    output_path: str  # Where the image is written
+    image_path: str  # What the location's "image" field should say
+
+
+@dataclass
+class ImageResult:
+    location_id: str
+    path: Optional[str]  # The job's image_path once written, None if generation failed or was cancelled
+    cached: bool = False
+    error: Optional[str] = None
+
+
+class RateLimitedError(Exception):
+    """The service asked us to slow down; retry_after is in seconds."""
+    def __init__(self, retry_after: float):
+        super().__init__(f"rate limited, retry after {retry_after:.1f}s")
+        self.retry_after = retry_after
+
+
+class TransientError(Exception):
+    """A failure worth retrying: server errors, timeouts, dropped connections."""
+
+
+class HttpImageBackend:
+    """
+    Client for OpenAI-compatible image generation endpoints. Blocking; the
+    batch generator calls it from a thread pool.
+    """
+
+    def __init__(self, api_url: str = DEFAULT_API_URL, api_key: Optional[str] = None, timeout: float = 120.0):
+        self.api_url = api_url
+        self.api_key = api_key
+        self.timeout = timeout
+
+    @staticmethod
+    def from_environment() -> "HttpImageBackend":
+        """Endpoint and key from ADVGPT_IMAGE_API_URL and ADVGPT_IMAGE_API_KEY."""
+        return HttpImageBackend(os.environ.get("ADVGPT_IMAGE_API_URL", DEFAULT_API_URL),
+                                os.environ.get("ADVGPT_IMAGE_API_KEY"))
+
+    def generate(self, prompt: str, settings: ImageSettings) -> bytes:
+        """Return the encoded image the service generated for the prompt."""
+        body = json.dumps({
+            "model": settings.model,
+            "prompt": prompt,
+            "size": settings.request_size,
+            "n": 1,
+            "response_format": "b64_json"
+        }).encode('utf-8')
+        headers = {"Content-Type": "application/json"}
+        if self.api_key:
+            headers["Authorization"] = f"Bearer {self.api_key}"
+
+        try:
+            request = urllib.request.Request(self.api_url, data=body, headers=headers, method="POST")
+            with urllib.request.urlopen(request, timeout=self.timeout) as response:
+                reply = json.loads(response.read())
+        except urllib.error.HTTPError as e:
+            if e.code == 429:
+                raise RateLimitedError(_retry_after(e.headers.get("Retry-After")))
+            if e.code >= 500:
+                raise TransientError(f"server error {e.code}")
+            raise RuntimeError(f"request rejected: HTTP {e.code} {e.read()[:200]!r}")
+        except (urllib.error.URLError, TimeoutError, ConnectionError) as e:
+            raise TransientError(str(e))
+
+        data = reply.get("data") or [{}]
+        if "b64_json" in data[0]:
+            return base64.b64decode(data[0]["b64_json"])
+        if "url" in data[0]:
+            try:
+                with urllib.request.urlopen(data[0]["url"], timeout=self.timeout) as response:
+                    return response.read()
+            except (urllib.error.URLError, TimeoutError, ConnectionError) as e:
+                raise TransientError(str(e))
+        raise RuntimeError("response holds no image")
+
+
+def _retry_after(value: Optional[str]) -> float:
+    try:
+        return max(float(value), 0.0)
+    except (TypeError, ValueError):
+        return 5.0
+
+
+class ImageCache:
+    """
+    Finished images on disk, named by the SHA-256 of their prompt and settings
+    and fanned out over 256 subdirectories.
+    """
+
+    def __init__(self, directory: Optional[str] = None):
+        if directory is None:
+            base = os.environ.get("XDG_CACHE_HOME") or os.path.join(Path.home(), ".cache")
+            directory = os.path.join(base, "adventuregpt", "images")
+        self.directory = Path(directory)
+
+    @staticmethod
+    def key(prompt: str, settings: ImageSettings) -> str:
+        text = json.dumps({"prompt": prompt, "settings": asdict(settings)}, sort_keys=True)
+        return hashlib.sha256(text.encode('utf-8')).hexdigest()
+
+    def path(self, key: str) -> Path:
+        return self.directory / key[:2] / f"{key}.png"
+
+    def get(self, key: str) -> Optional[Path]:
+        path = self.path(key)
+        return path if path.is_file() else None
+
+    def put(self, key: str, data: bytes) -> Path:
+        path = self.path(key)
+        path.parent.mkdir(parents=True, exist_ok=True)
+        AdvGPTFormat.replace_file(str(path), data)
+        return path
+
+
+def fit_to_engine(data: bytes, settings: ImageSettings) -> bytes:
+    """Scale and centre-crop an image to fill the engine's image area, as PNG."""
+    with Image.open(io.BytesIO(data)) as image:
+        fitted = ImageOps.fit(image.convert("RGB"), (settings.width, settings.height), Image.LANCZOS)
+    output = io.BytesIO()
+    fitted.save(output, format="PNG", optimize=True)
+    return output.getvalue()
+
+
+def location_prompt(location: Dict, settings: ImageSettings) -> str:
+    """The prompt a location's art is generated from."""
+    parts = [settings.style, location.get("title", ""), location.get("description", "")]
+    return ". ".join(part.strip().rstrip(".") for part in parts if part and part.strip()) + "."
+
+
+class BatchImageGenerator:
+    """
+    Runs image jobs with at most `concurrency` requests in flight. Jobs whose
+    prompt and settings match run once however often they appear in a batch.
+    """
+
+    def __init__(self, backend, cache: ImageCache, settings: ImageSettings = ImageSettings(),
+                 concurrency: int = 4, max_retries: int = 5, base_delay: float = 1.0):
+        self.backend = backend
+        self.cache = cache
+        self.settings = settings
+        self.concurrency = max(1, concurrency)
+        self.max_retries = max_retries
+        self.base_delay = base_delay
+        self._cancelled = threading.Event()
+        self._resume_at = 0.0  # Monotonic time before which no request may start
+
+    def cancel(self):
+        """Stop starting requests; safe to call from any thread."""
+        self._cancelled.set()
+
+    def run(self, jobs: List[ImageJob], on_result: Optional[Callable[[ImageResult], None]] = None) -> List[ImageResult]:
+        """
+        Generate every job's image and write it to the job's output path.
+        on_result is called on the calling thread as each job finishes.
+        """
+        return asyncio.run(self._run(jobs, on_result))
+
+    async def _run(self, jobs, on_result):
+        queue: asyncio.Queue = asyncio.Queue()
+        for job in jobs:
+            queue.put_nowait(job)
+        results: List[ImageResult] = []
+        generating: Dict[str, asyncio.Future] = {}
+
+        # Enough threads for every request in flight plus the image work behind them
+        with ThreadPoolExecutor(max_workers=self.concurrency + 1) as executor:
+            async def worker():
+                while True:
+                    try:
+                        job = queue.get_nowait()
+                    except asyncio.QueueEmpty:
+                        return
+                    result = await self._process(job, generating, executor)
+                    results.append(result)
+                    if on_result:
+                        on_result(result)
+
+            await asyncio.gather(*(worker() for _ in range(min(self.concurrency, len(jobs)) or 1)))
+        return results
+
+    async def _process(self, job: ImageJob, generating, executor) -> ImageResult:
+        loop = asyncio.get_running_loop()
+        key = ImageCache.key(job.prompt, self.settings)
+        cached = self.cache.get(key)
+        try:
+            if cached is None:
+                if self._cancelled.is_set():
+                    return ImageResult(job.location_id, None, error="cancelled")
+                future = generating.get(key)
+                if future is None:
+                    future = generating[key] = loop.create_future()
+                    try:
+                        future.set_result(await self._generate(job.prompt, key, executor))
+                    except Exception as e:
+                        # Jobs already waiting share the failure; later ones try again
+                        future.set_exception(e)
+                        future.exception()
+                        generating.pop(key)
+                        raise
+                path = await future
+            else:
+                path = cached
+            await loop.run_in_executor(executor, _copy_if_changed, path, job.output_path)
+            return ImageResult(job.location_id, job.image_path, cached=cached is not None)
+        except Exception as e:
+            return ImageResult(job.location_id, None, error=str(e))
+
+    async def _generate(self, prompt: str, key: str, executor) -> Path:
+        loop = asyncio.get_running_loop()
+        for attempt in range(self.max_retries + 1):
+            # Every worker holds off while the service is rate limiting us
+            delay = self._resume_at - time.monotonic()
+            if delay > 0:
+                await asyncio.sleep(delay)
+            if self._cancelled.is_set():
+                raise RuntimeError("cancelled")
+
+            try:
+                data = await loop.run_in_executor(executor, self.backend.generate, prompt, self.settings)
+                fitted = await loop.run_in_executor(executor, fit_to_engine, data, self.settings)
+                return self.cache.put(key, fitted)
+            except RateLimitedError as e:
+                if attempt == self.max_retries:
+                    raise
+                self._resume_at = max(self._resume_at, time.monotonic() + e.retry_after)
+            except TransientError:
+                if attempt == self.max_retries:
+                    raise
+                # Full jitter keeps workers that failed together from retrying together
+                await asyncio.sleep(random.uniform(0, self.base_delay * 2 ** attempt))
+        raise RuntimeError("unreachable")
+
+
+def _copy_if_changed(source: Path, destination: str):
+    data = Path(source).read_bytes()
+    target = Path(destination)
+    if target.is_file() and target.read_bytes() == data:
+        return
+    target.parent.mkdir(parents=True, exist_ok=True)
+    AdvGPTFormat.replace_file(str(target), data)
+
+
+def location_jobs(game_data: Dict, images_dir: str, settings: ImageSettings, base_dir: str = ".") -> List[ImageJob]:
+    """
+    A job per location whose art is missing or was generated into images_dir
+    before; images the author chose by hand are left alone. Image paths are
+    recorded as images_dir/<location id>.png and written under base_dir.
+    """
+    jobs = []
+    for loc_id, location in game_data.get("locations", {}).items():
+        image = location.get("image", "")
+        image_path = (Path(images_dir) / f"{loc_id}.png").as_posix()
+        if image and Path(image) != Path(image_path):
+            continue
+        jobs.append(ImageJob(loc_id, location_prompt(location, settings), str(Path(base_dir) / image_path), image_path))
+    return jobs
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate location art for an .advgpt game.")
+    parser.add_argument("game", help="Game file; each location's image is set to its generated art")
+    parser.add_argument("--images-dir", default="images",
+                        help="Where images are written, as the engine will find them from its working directory "
+                             "(default: images)")
+    parser.add_argument("--cache-dir", help="Image cache (default: ~/.cache/adventuregpt/images)")
+    parser.add_argument("--concurrency", type=int, default=4, help="Requests in flight at once (default: 4)")
+    parser.add_argument("--retries", type=int, default=5, help="Retries per image (default: 5)")
+    parser.add_argument("--model", default=ImageSettings.model)
+    parser.add_argument("--style", default=ImageSettings.style, help="Prepended to every prompt")
+    args = parser.parse_args()
+
+    game_data = AdvGPTFormat.load_from_file(args.game)
+    if game_data is None:
+        return 1
+
+    settings = ImageSettings(model=args.model, style=args.style)
+    generator = BatchImageGenerator(HttpImageBackend.from_environment(), ImageCache(args.cache_dir), settings,
+                                    args.concurrency, args.retries)
+    jobs = location_jobs(game_data, args.images_dir, settings)
+
+    done = 0
+
+    def report(result: ImageResult):
+        nonlocal done
+        done += 1
+        status = "cached" if result.cached else "generated" if result.path else f"failed: {result.error}"
+        print(f"[{done}/{len(jobs)}] {result.location_id}: {status}")
+
+    started = time.monotonic()
+    results = generator.run(jobs, report)
+    for result in results:
+        if result.path:
+            game_data["locations"][result.location_id]["image"] = result.path
+    failed = sum(1 for result in results if not result.path)
+    print(f"{len(results) - failed} of {len(results)} images in {time.monotonic() - started:.1f}s, "
+          f"{sum(1 for result in results if result.cached)} from cache")
+
+    if not AdvGPTFormat.save_to_file(game_data, args.game):
+        return 1
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -12,17 +12,47 @@ from PySide6.QtWidgets import (
     QApplication, QMainWindow, QTabWidget, QVBoxLayout, QHBoxLayout,
     QWidget, QLabel, QLineEdit, QTextEdit, QPushButton, QFileDialog,
     QMessageBox, QSplitter, QListWidget, QListWidgetItem, QFormLayout,
-    QGroupBox, QScrollArea, QFrame
+    QGroupBox, QScrollArea, QFrame, QProgressDialog, QCheckBox
 )
-from PySide6.QtCore import Qt, QSettings
+from PySide6.QtCore import Qt, QSettings, QThread, Signal
 from PySide6.QtGui import QPixmap, QIcon, QAction
 
+from advgpt_format import AdvGPTFormat
+from image_generation import (
+    BatchImageGenerator, HttpImageBackend, ImageCache, ImageSettings, location_jobs
+)
+
+
+class ImageGenerationThread(QThread):
+    """Runs an image batch off the UI thread, reporting each image as it finishes."""
+    
+    image_finished = Signal(object)  # ImageResult, delivered on the UI thread
+    
+    def __init__(self, jobs, parent=None):
+        super().__init__(parent)
+        self.jobs = jobs
+        self.results = []
+        # Endpoint and key come from ADVGPT_IMAGE_API_URL and ADVGPT_IMAGE_API_KEY
+        self.generator = BatchImageGenerator(HttpImageBackend.from_environment(), ImageCache())
+        
+    def run(self):
+        self.results = self.generator.run(self.jobs, self.image_finished.emit)
+        
+    def cancel(self):
+        """Finish the requests in flight and start no more."""
+        self.generator.cancel()
+
 
 class LocationEditor(QWidget):
     """Widget for editing game locations."""
     
-    def __init__(self):
+    def __init__(self, get_project_dir=None):
         super().__init__()
+        # Callable returning the directory image paths are relative to
+        self.get_project_dir = get_project_dir
+        self.location_image = ""  # The edited location's "image" field
+        self.image_thread = None
+        self.image_job = None
         self.setup_ui()
         
     def setup_ui(self):
@@ -141,15 +171,60 @@ class LocationEditor(QWidget):
             "Image Files (*.png *.jpg *.jpeg *.bmp *.gif)"
         )
         if file_path:
-            pixmap = QPixmap(file_path)
-            scaled_pixmap = pixmap.scaled(
-                self.image_label.size(), Qt.KeepAspectRatio, Qt.SmoothTransformation
-            )
-            self.image_label.setPixmap(scaled_pixmap)
+            # Art inside the project is recorded relative to it, so the game can move
+            try:
+                relative = os.path.relpath(file_path, self.project_dir())
+            except ValueError:  # Another drive on Windows
+                relative = os.pardir
+            self.location_image = file_path if relative.startswith(os.pardir) else Path(relative).as_posix()
+            self.show_image(file_path)
+            
+    def project_dir(self):
+        return self.get_project_dir() if self.get_project_dir else "."
+        
+    def show_image(self, file_path):
+        """Show an image in the preview, scaled to fit."""
+        pixmap = QPixmap(file_path)
+        scaled_pixmap = pixmap.scaled(
+            self.image_label.size(), Qt.KeepAspectRatio, Qt.SmoothTransformation
+        )
+        self.image_label.setPixmap(scaled_pixmap)
             
     def generate_image(self):
-        """Generate an AI image for the current location."""
-        QMessageBox.information(self, "AI Generation", "AI image generation will be implemented in a future version.")
+        """Generate an AI image for the current location in the background."""
+        if self.image_thread and self.image_thread.isRunning():
+            return
+        location_id = self.location_id_edit.text().strip()
+        if not location_id:
+            QMessageBox.information(self, "AI Generation", "Give the location an ID first.")
+            return
+        
+        location = {
+            "title": self.location_title_edit.text(),
+            "description": self.location_description_edit.toPlainText()
+        }
+        # Written under the project directory, as the batch generation does
+        self.image_job = location_jobs({"locations": {location_id: location}}, "images", ImageSettings(),
+                                       self.project_dir())[0]
+        
+        self.image_thread = ImageGenerationThread([self.image_job], self)
+        self.image_thread.image_finished.connect(self.on_image_generated)
+        self.image_thread.finished.connect(self.on_generation_finished)
+        self.generate_image_btn.setEnabled(False)
+        self.generate_image_btn.setText("Generating...")
+        self.image_thread.start()
+        
+    def on_image_generated(self, result):
+        """Show generated art, or why there is none."""
+        if result.path:
+            self.location_image = result.path
+            self.show_image(self.image_job.output_path)
+        else:
+            QMessageBox.warning(self, "AI Generation", f"Could not generate an image: {result.error}")
+            
+    def on_generation_finished(self):
+        self.generate_image_btn.setEnabled(True)
+        self.generate_image_btn.setText("Generate with AI")
         
     def add_exit(self):
         """Add a new exit to the current location."""
@@ -268,8 +343,12 @@ class StoryEditor(QWidget):
 class ExportTab(QWidget):
     """Widget for exporting games."""
     
-    def __init__(self):
+    def __init__(self, get_project_data=None, get_project_dir=None):
         super().__init__()
+        # Callable returning the current project as .advgpt game data
+        self.get_project_data = get_project_data
+        # Callable returning the directory image paths are relative to
+        self.get_project_dir = get_project_dir
         self.setup_ui()
         
     def setup_ui(self):
@@ -290,6 +369,12 @@ class ExportTab(QWidget):
         self.browse_btn.clicked.connect(self.browse_export_path)
         browse_layout.addWidget(self.browse_btn)
         
+        # Art is pre-converted for the engine so room changes skip PNG decoding
+        self.convert_images_check = QCheckBox("Pre-convert location art for the engine")
+        self.convert_images_check.setChecked(True)
+        self.low_color_check = QCheckBox("16-bit art (RGB565) for low-memory targets")
+        self.convert_images_check.toggled.connect(self.low_color_check.setEnabled)
+        
         # Export buttons
         button_layout = QVBoxLayout()
         
@@ -309,6 +394,8 @@ class ExportTab(QWidget):
         button_layout.addWidget(self.export_linux_btn)
         
         export_layout.addLayout(browse_layout)
+        export_layout.addWidget(self.convert_images_check)
+        export_layout.addWidget(self.low_color_check)
         export_layout.addLayout(button_layout)
         export_layout.addStretch()
         export_group.setLayout(export_layout)
@@ -334,9 +421,50 @@ class ExportTab(QWidget):
             self.export_path_edit.setText(directory)
             
     def export_project(self):
-        """Export the current project as .advgpt format."""
+        """Export the current project as .advgpt source plus a compiled .advgptb bundle."""
         self.export_log.append("Exporting .advgpt project...")
-        # Implementation would save the project in the defined JSON format
+        
+        export_dir = self.export_path_edit.text().strip()
+        if not export_dir:
+            self.export_log.append("Error: Select an export directory first.")
+            return
+        if not self.get_project_data:
+            self.export_log.append("Error: No project data available to export.")
+            return
+        
+        game_data = self.get_project_data()
+        errors = AdvGPTFormat.validate_game_data(game_data)
+        if errors:
+            for error in errors:
+                self.export_log.append(f"Error: {error}")
+            return
+        
+        # Unreachable rooms are usually unfinished wiring, so they warn rather than block
+        for loc_id in AdvGPTFormat.find_unreachable_locations(game_data):
+            self.export_log.append(f"Warning: Location '{loc_id}' cannot be reached from the start")
+        
+        base_name = "".join(c if c.isalnum() else "_" for c in game_data["meta"]["title"].lower()) or "game"
+        project_path = Path(export_dir) / f"{base_name}.advgpt"
+        bundle_path = Path(export_dir) / f"{base_name}.advgptb"
+        
+        if self.convert_images_check.isChecked():
+            base_dir = self.get_project_dir() if self.get_project_dir else "."
+            game_data, image_errors = AdvGPTFormat.export_images(game_data, export_dir, base_dir,
+                                                                 self.low_color_check.isChecked())
+            for error in image_errors:
+                self.export_log.append(f"Warning: {error}")
+        
+        if not AdvGPTFormat.save_to_file(game_data, str(project_path)):
+            self.export_log.append(f"Error: Failed to write {project_path}")
+            return
+        self.export_log.append(f"Wrote {project_path}")
+        
+        # The compiled bundle is what the engine should ship with; it loads without parsing
+        if not AdvGPTFormat.save_bundle(game_data, str(bundle_path)):
+            self.export_log.append(f"Error: Failed to write {bundle_path}")
+            return
+        self.export_log.append(f"Wrote {bundle_path}")
+        
         self.export_log.append("Export completed successfully!")
         
     def export_windows(self):
@@ -361,6 +489,7 @@ class AdventureGPTEditor(QMainWindow):
     def __init__(self):
         super().__init__()
         self.current_project_path = None
+        self.art_thread = None
         self.setup_ui()
         self.setup_menu()
         
@@ -379,9 +508,9 @@ class AdventureGPTEditor(QMainWindow):
         self.tab_widget = QTabWidget()
         
         # Add tabs
-        self.location_editor = LocationEditor()
+        self.location_editor = LocationEditor(self.get_project_dir)
         self.story_editor = StoryEditor()
-        self.export_tab = ExportTab()
+        self.export_tab = ExportTab(self.get_project_data, self.get_project_dir)
         
         self.tab_widget.addTab(self.location_editor, "Map Editor")
         self.tab_widget.addTab(self.story_editor, "Story Editor")
@@ -423,6 +552,13 @@ class AdventureGPTEditor(QMainWindow):
         exit_action.triggered.connect(self.close)
         file_menu.addAction(exit_action)
         
+        # Tools menu
+        tools_menu = menubar.addMenu("Tools")
+        
+        art_action = QAction("Generate Location Art...", self)
+        art_action.triggered.connect(self.generate_location_art)
+        tools_menu.addAction(art_action)
+        
         # Help menu
         help_menu = menubar.addMenu("Help")
         
@@ -475,8 +611,7 @@ class AdventureGPTEditor(QMainWindow):
         """Save project data to specified path."""
         try:
             project_data = self.get_project_data()
-            with open(file_path, 'w') as f:
-                json.dump(project_data, f, indent=2)
+            AdvGPTFormat.replace_file(file_path, json.dumps(project_data, indent=2).encode('utf-8'))
             QMessageBox.information(self, "Success", "Project saved successfully!")
         except Exception as e:
             QMessageBox.critical(self, "Error", f"Failed to save project: {str(e)}")
@@ -484,17 +619,15 @@ class AdventureGPTEditor(QMainWindow):
     def get_project_data(self):
         """Get current project data as dictionary."""
         # This would collect data from all the editors
-        return {
-            "meta": {
-                "title": self.story_editor.game_title_edit.text() or "Untitled Adventure",
-                "author": self.story_editor.game_author_edit.text() or "Unknown",
-                "description": self.story_editor.game_description_edit.toPlainText()
-            },
-            "start_location": "start",
-            "locations": {},
-            "inventory_items": [],
-            "flags": {}
-        }
+        game_data = AdvGPTFormat.create_empty_game()
+        game_data["meta"]["title"] = self.story_editor.game_title_edit.text() or "Untitled Adventure"
+        game_data["meta"]["author"] = self.story_editor.game_author_edit.text() or "Unknown"
+        game_data["meta"]["description"] = self.story_editor.game_description_edit.toPlainText()
+        return game_data
+        
+    def get_project_dir(self):
+        """Directory the project's image paths are relative to."""
+        return str(Path(self.current_project_path).parent) if self.current_project_path else "."
         
     def load_project_data(self, data):
         """Load project data into the editors."""
@@ -505,6 +638,70 @@ class AdventureGPTEditor(QMainWindow):
             self.story_editor.game_author_edit.setText(meta.get("author", ""))
             self.story_editor.game_description_edit.setPlainText(meta.get("description", ""))
             
+    def generate_location_art(self):
+        """
+        Generate art for every location of a game file that has none, or only
+        art generated before, on a worker thread. Unchanged rooms come from
+        the image cache, and the game file is updated once the batch is done.
+        """
+        if self.art_thread and self.art_thread.isRunning():
+            return
+        file_path = self.current_project_path
+        if not file_path:
+            file_path, _ = QFileDialog.getOpenFileName(
+                self, "Generate Art for Game", "", "AdventureGPT Projects (*.advgpt)"
+            )
+        if not file_path:
+            return
+        game_data = AdvGPTFormat.load_from_file(file_path)
+        if game_data is None:
+            QMessageBox.critical(self, "Error", f"Failed to open {file_path}")
+            return
+        
+        # Images sit next to the game, where the engine finds them when run from its directory
+        jobs = location_jobs(game_data, "images", ImageSettings(), str(Path(file_path).parent))
+        if not jobs:
+            QMessageBox.information(self, "AI Generation", "Every location already has hand-picked art.")
+            return
+        
+        progress = QProgressDialog(f"Generating art for {len(jobs)} locations...", "Cancel", 0, len(jobs), self)
+        progress.setWindowModality(Qt.WindowModal)
+        progress.setMinimumDuration(0)
+        
+        self.art_thread = ImageGenerationThread(jobs, self)
+        self.art_thread.image_finished.connect(lambda result: progress.setValue(progress.value() + 1))
+        progress.canceled.connect(self.art_thread.cancel)
+        self.art_thread.finished.connect(lambda: self.on_location_art_finished(file_path, game_data, progress))
+        progress.setValue(0)
+        self.art_thread.start()
+        
+    def on_location_art_finished(self, file_path, game_data, progress):
+        """Point each location at its new art and save the game file."""
+        progress.close()
+        results = self.art_thread.results
+        for result in results:
+            if result.path:
+                game_data["locations"][result.location_id]["image"] = result.path
+        generated = [result for result in results if result.path]
+        cached = sum(1 for result in generated if result.cached)
+        
+        if generated and not AdvGPTFormat.save_to_file(game_data, file_path):
+            QMessageBox.critical(self, "Error", f"Failed to save {file_path}")
+            return
+        message = f"{len(generated)} of {len(results)} locations have art ({cached} from the cache)."
+        failures = [f"{result.location_id}: {result.error}" for result in results if not result.path]
+        if failures:
+            message += "\n\nFailed:\n" + "\n".join(failures[:10])
+        QMessageBox.information(self, "AI Generation", message)
+        
+    def closeEvent(self, event):
+        """Let image batches finish their requests in flight before quitting."""
+        for thread in (self.art_thread, self.location_editor.image_thread):
+            if thread and thread.isRunning():
+                thread.cancel()
+                thread.wait()
+        super().closeEvent(event)
+        
     def show_about(self):
         """Show about dialog."""
         QMessageBox.about(
@@ -1,379 +1,1215 @@
 #include "adventure_engine.h"
-#include <json-c/json.h>
+#include "bundle.h"
+#include "json_stream.h"
+#include "location_text.h"
+#include "profiler.h"
+#include "world_graph.h"
+#include "world_regions.h"
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-// Helper function to safely copy strings
-void safe_strcpy(char* dest, const char* src, size_t dest_size) {
-    if (!src) {
-        dest[0] = '\0';
-        return;
+// Player-facing output; errors still go straight to stdout
+static void game_message(const GameState* game, const char* format, ...) {
+    if (game->quiet) return;
+    
+    va_list args;
+    va_start(args, format);
+    if (game->output) {
+        char text[GAME_MESSAGE_LENGTH];
+        vsnprintf(text, sizeof(text), format, args);
+        game->output(game->output_context, text);
+    } else {
+        vprintf(format, args);
     }
-    strncpy(dest, src, dest_size - 1);
-    dest[dest_size - 1] = '\0';
+    va_end(args);
 }
 
-// Helper function to read file contents
-char* read_file(const char* filename) {
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        printf("Error: Could not open file %s\n", filename);
+// FNV-1a hash used by the symbol tables
+static unsigned int hash_string(const char* str) {
+    unsigned int hash = 2166136261u;
+    while (*str) {
+        hash ^= (unsigned char)*str++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Smallest power of two slot count that keeps the table at most half full
+static unsigned int symbol_slot_count(int capacity) {
+    unsigned int slots = 16;
+    while (slots < (unsigned int)capacity * 2) {
+        slots <<= 1;
+    }
+    return slots;
+}
+
+size_t symbol_table_size(int capacity) {
+    return ARENA_ALIGN(capacity * sizeof(const char*)) + ARENA_ALIGN(symbol_slot_count(capacity) * sizeof(int));
+}
+
+bool symbol_table_init(SymbolTable* table, Arena* arena, int capacity) {
+    unsigned int slots = symbol_slot_count(capacity);
+    
+    table->names = arena_alloc(arena, capacity * sizeof(const char*));
+    table->slots = arena_alloc(arena, slots * sizeof(int));
+    table->count = 0;
+    table->capacity = capacity;
+    table->slot_mask = slots - 1;
+    
+    return table->names && table->slots;
+}
+
+// Find the slot holding name, or the empty slot where it would go
+static unsigned int symbol_find_slot(const SymbolTable* table, const char* name) {
+    unsigned int slot = hash_string(name) & table->slot_mask;
+    
+    // Linear probing; the table is at most half full so an empty slot always exists
+    while (table->slots[slot] != 0) {
+        if (strcmp(table->names[table->slots[slot] - 1], name) == 0) {
+            break;
+        }
+        slot = (slot + 1) & table->slot_mask;
+    }
+    
+    return slot;
+}
+
+int symbol_lookup(const SymbolTable* table, const char* name) {
+    if (!table || !table->slots || !name) return INVALID_SYMBOL;
+    
+    return table->slots[symbol_find_slot(table, name)] - 1;
+}
+
+// Intern name, storing it through the arena copy or directly when arena is NULL
+static int symbol_insert(SymbolTable* table, Arena* arena, const char* name) {
+    if (!table || !table->slots || !name) return INVALID_SYMBOL;
+    
+    unsigned int slot = symbol_find_slot(table, name);
+    if (table->slots[slot] != 0) {
+        return table->slots[slot] - 1;
+    }
+    
+    if (table->count >= table->capacity) {
+        return INVALID_SYMBOL;
+    }
+    
+    const char* stored = arena ? arena_strdup(arena, name) : name;
+    if (!stored) {
+        return INVALID_SYMBOL;
+    }
+    
+    int symbol = table->count++;
+    table->names[symbol] = stored;
+    table->slots[slot] = symbol + 1;
+    return symbol;
+}
+
+int symbol_intern(SymbolTable* table, Arena* arena, const char* name) {
+    if (!arena) return INVALID_SYMBOL;
+    return symbol_insert(table, arena, name);
+}
+
+// Intern a name that outlives the table (e.g. one inside a mapped bundle) without copying it
+int symbol_intern_static(SymbolTable* table, const char* name) {
+    return symbol_insert(table, NULL, name);
+}
+
+const char* symbol_name(const SymbolTable* table, int symbol) {
+    if (!table || symbol < 0 || symbol >= table->count) return NULL;
+    return table->names[symbol];
+}
+
+// Add the allocations every loader shares: the world itself, its record arrays,
+// symbol tables and the starting player's bitsets
+void world_sizes_finish(WorldSizes* sizes) {
+    sizes->bytes += ARENA_ALIGN(sizeof(World));
+    sizes->bytes += ARENA_ALIGN(sizes->locations * sizeof(Location));
+    sizes->bytes += ARENA_ALIGN(sizes->inventory_items * sizeof(InventoryItem));
+    
+    sizes->bytes += symbol_table_size(sizes->locations);
+    sizes->bytes += symbol_table_size(sizes->item_names);
+    sizes->bytes += symbol_table_size(sizes->flag_names);
+    
+    // Game flag defaults, starting player flags and the starting inventory bitmap
+    sizes->bytes += 2 * ARENA_ALIGN(BITSET_WORDS(sizes->flag_names) * sizeof(unsigned int));
+    sizes->bytes += ARENA_ALIGN(BITSET_WORDS(sizes->item_names) * sizeof(unsigned int));
+    
+    if (!sizes->records_only) {
+        sizes->bytes += world_graph_size(sizes);
+        sizes->bytes += name_index_size(sizes->locations, sizes->exits + 2 * sizes->item_refs);
+    }
+}
+
+// Resolve every exit to its target location index and direction id
+void resolve_exits(World* world) {
+    for (int i = 0; i < world->locations_count; i++) {
+        Location* location = &world->locations[i];
+        for (int j = 0; j < location->exits_count; j++) {
+            location->exits[j].target_index = symbol_lookup(&world->location_symbols,
+                                                            location->exits[j].target_location);
+            location->exits[j].direction_id = parse_direction(location->exits[j].direction);
+        }
+    }
+}
+
+// Each name is hashed with its terminator and each table ends with an extra
+// zero byte, so moving a name between tables or splitting one changes the hash
+static unsigned int hash_symbols(unsigned int hash, const SymbolTable* table) {
+    for (int i = 0; i < table->count; i++) {
+        for (const char* c = table->names[i]; ; c++) {
+            hash = (hash ^ (unsigned char)*c) * 16777619u;
+            if (!*c) break;
+        }
+    }
+    return hash * 16777619u;
+}
+
+unsigned int world_fingerprint(const World* world) {
+    unsigned int hash = hash_symbols(2166136261u, &world->location_symbols);
+    hash = hash_symbols(hash, &world->item_symbols);
+    return hash_symbols(hash, &world->flag_symbols);
+}
+
+// Key every location's exit directions, then the id and display name of each
+// entry of its item list; items without a definition go by their id twice
+static bool build_name_index(World* world) {
+    NameIndex* index = &world->names;
+    int keys = 0;
+    
+    for (int i = 0; i < world->locations_count; i++) {
+        const Location* location = &world->locations[i];
+        index->offsets[i] = keys;
+        if (keys + location->exits_count + 2 * location->items_count > index->keys_capacity) return false;
+        
+        for (int j = 0; j < location->exits_count; j++) {
+            name_key_init(&index->keys[keys++], location->exits[j].direction);
+        }
+        for (int j = 0; j < location->items_count; j++) {
+            int symbol = location->items[j];
+            const char* id = symbol_name(&world->item_symbols, symbol);
+            const char* name = symbol < world->inventory_items_count ? world->inventory_items[symbol].name : NULL;
+            name_key_init(&index->keys[keys++], id);
+            name_key_init(&index->keys[keys++], name ? name : id);
+        }
+    }
+    index->offsets[world->locations_count] = keys;
+    index->keys_count = keys;
+    return true;
+}
+
+// Carve the fixed-size parts of a world out of a freshly sized arena
+World* allocate_world(const WorldSizes* sizes) {
+    Arena arena;
+    if (!arena_init(&arena, sizes->bytes)) {
         return NULL;
     }
     
-    // Get file size
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
+    // The arena's first allocation is the world, which then owns the arena
+    World* world = arena_alloc(&arena, sizeof(World));
+    world->arena = arena;
+    
+    Arena* world_arena = &world->arena;
+    world->locations = arena_alloc(world_arena, sizes->locations * sizeof(Location));
+    world->inventory_items = arena_alloc(world_arena, sizes->inventory_items * sizeof(InventoryItem));
     
-    // Allocate buffer
-    char* buffer = malloc(file_size + 1);
-    if (!buffer) {
-        printf("Error: Could not allocate memory for file\n");
-        fclose(file);
+    symbol_table_init(&world->location_symbols, world_arena, sizes->locations);
+    symbol_table_init(&world->item_symbols, world_arena, sizes->item_names);
+    symbol_table_init(&world->flag_symbols, world_arena, sizes->flag_names);
+    
+    world->flag_words = BITSET_WORDS(sizes->flag_names);
+    world->item_words = BITSET_WORDS(sizes->item_names);
+    world->game_flags = arena_alloc(world_arena, world->flag_words * sizeof(unsigned int));
+    world->start.flags = arena_alloc(world_arena, world->flag_words * sizeof(unsigned int));
+    world->start.inventory = arena_alloc(world_arena, world->item_words * sizeof(unsigned int));
+    if (!sizes->records_only) {
+        world_graph_init(&world->graph, world_arena, sizes);
+        name_index_init(&world->names, world_arena, sizes->locations, sizes->exits + 2 * sizes->item_refs);
+    }
+    
+    return world;
+}
+
+// Top-level sections, in the order the fill pass reads them
+enum {
+    SECTION_META,
+    SECTION_START_LOCATION,
+    SECTION_INVENTORY_ITEMS,
+    SECTION_GAME_FLAGS,
+    SECTION_LOCATIONS,
+    SECTION_PLAYER,
+    SECTION_REGIONS, // Manifests only: read before the world is allocated, never filled
+    SECTION_COUNT
+};
+
+// Streaming loader state. The file is read twice: a measuring pass (world ==
+// NULL) totals every allocation and records where each section starts, then
+// the fill pass seeks to the sections in dependency order and builds the world.
+typedef struct {
+    JsonStream stream;
+    World* world;
+    WorldSizes sizes;
+    bool lazy_text; // Leave location text in the file, recording where each location starts
+    bool region; // Loading one region of a manifest, whose own "regions" list is ignored
+    int regions_count; // Region files a manifest lists
+    int exits_count; // Totals that size the shared exit, location item and condition arrays
+    int location_items_count;
+    int flag_terms_count; // Flags named by every flags_required and flags_set, an upper bound on terms
+    Exit* next_exit; // Fill pass cursors into those arrays
+    int* next_item;
+    FlagTerm* next_flag_term;
+    int exits_used; // Cursor positions, checked against the totals in case the file grew
+    int items_used;
+    int flag_terms_used;
+    long sections[SECTION_COUNT]; // File offset of each section's value, -1 if absent
+} JsonLoader;
+
+static JsonToken next_token(JsonLoader* loader) {
+    return json_stream_next(&loader->stream);
+}
+
+static bool skip_value(JsonLoader* loader, JsonToken token) {
+    return json_stream_skip(&loader->stream, token);
+}
+
+// Copy the current token text into the arena, or count its size while measuring
+static const char* loader_strdup(JsonLoader* loader) {
+    if (!loader->world) {
+        loader->sizes.bytes += ARENA_ALIGN(loader->stream.text_length + 1);
         return NULL;
     }
+    return arena_strdup(&loader->world->arena, loader->stream.text);
+}
+
+// Read a string value; other value types are skipped and leave *out unchanged
+static bool read_string_value(JsonLoader* loader, JsonToken token, const char** out) {
+    if (token != JSON_TOKEN_STRING) {
+        return skip_value(loader, token);
+    }
     
-    // Read file
-    size_t bytes_read = fread(buffer, 1, file_size, file);
-    buffer[bytes_read] = '\0';
+    const char* str = loader_strdup(loader);
+    if (loader->world) {
+        if (!str) return false;
+        *out = str;
+    }
+    return true;
+}
+
+// Read a boolean value; anything other than true reads as false
+static bool read_bool_value(JsonLoader* loader, JsonToken token, bool* out) {
+    *out = token == JSON_TOKEN_TRUE;
+    return skip_value(loader, token);
+}
+
+// Intern the current token text, or count it as a possible new symbol while measuring
+static int loader_intern(JsonLoader* loader, SymbolTable* table, int* name_count) {
+    if (!loader->world) {
+        loader->sizes.bytes += ARENA_ALIGN(loader->stream.text_length + 1);
+        (*name_count)++;
+        return INVALID_SYMBOL;
+    }
+    return symbol_intern(table, &loader->world->arena, loader->stream.text);
+}
+
+// Parse a {"flag_name": bool} object into a flag bitset, interning each flag
+static bool parse_flag_values(JsonLoader* loader, JsonToken token, unsigned int* values) {
+    if (token != JSON_TOKEN_OBJECT_BEGIN) return skip_value(loader, token);
     
-    fclose(file);
-    return buffer;
+    World* world = loader->world;
+    while ((token = next_token(loader)) == JSON_TOKEN_KEY) {
+        int flag = loader_intern(loader, world ? &world->flag_symbols : NULL, &loader->sizes.flag_names);
+        
+        bool value;
+        if (!read_bool_value(loader, next_token(loader), &value)) return false;
+        if (flag == INVALID_SYMBOL) continue;
+        
+        if (value) {
+            BIT_SET(values, flag);
+        } else {
+            BIT_CLEAR(values, flag);
+        }
+    }
+    return token == JSON_TOKEN_OBJECT_END;
 }
 
-// Helper function to get string from json object
-const char* get_json_string(json_object* obj, const char* key) {
-    json_object* value;
-    if (json_object_object_get_ex(obj, key, &value)) {
-        if (json_object_is_type(value, json_type_string)) {
-            return json_object_get_string(value);
+// Parse a {"flag_name": bool} condition into flag terms taken from the shared
+// array; terms stays NULL if the condition names no flags
+static bool parse_flag_condition(JsonLoader* loader, JsonToken token, FlagTerm** terms, int* count) {
+    if (token != JSON_TOKEN_OBJECT_BEGIN) return skip_value(loader, token);
+    
+    World* world = loader->world;
+    if (terms) {
+        *terms = NULL;
+        *count = 0;
+    }
+    while ((token = next_token(loader)) == JSON_TOKEN_KEY) {
+        int flag = loader_intern(loader, world ? &world->flag_symbols : NULL, &loader->sizes.flag_names);
+        
+        bool value;
+        if (!read_bool_value(loader, next_token(loader), &value)) return false;
+        if (!world) {
+            loader->flag_terms_count++;
+            continue;
         }
+        if (flag == INVALID_SYMBOL || !terms) continue;
+        
+        // Conditions are parsed one at a time, so this one's terms end the used part
+        if (!*terms) *terms = loader->next_flag_term;
+        
+        // A flag in a word with no term yet needs room before one is written
+        int i = 0;
+        while (i < *count && (*terms)[i].word != flag >> 5) i++;
+        if (i == *count && loader->flag_terms_used == loader->flag_terms_count) return false;
+        
+        int added = add_flag_term(*terms, *count, flag, value) - *count;
+        *count += added;
+        loader->flag_terms_used += added;
+        loader->next_flag_term += added;
     }
-    return NULL;
+    if (terms && *count == 0) *terms = NULL;
+    return token == JSON_TOKEN_OBJECT_END;
 }
 
-// Helper function to get boolean from json object
-bool get_json_bool(json_object* obj, const char* key) {
-    json_object* value;
-    if (json_object_object_get_ex(obj, key, &value)) {
-        if (json_object_is_type(value, json_type_boolean)) {
-            return json_object_get_boolean(value);
+// Parse a ["item_id", ...] array, calling add for each interned item symbol
+static bool parse_item_list(JsonLoader* loader, JsonToken token, bool (*add)(JsonLoader*, int, void*), void* context) {
+    if (token != JSON_TOKEN_ARRAY_BEGIN) return skip_value(loader, token);
+    
+    World* world = loader->world;
+    while ((token = next_token(loader)) != JSON_TOKEN_ARRAY_END) {
+        if (token != JSON_TOKEN_STRING) {
+            if (!skip_value(loader, token)) return false;
+            continue;
         }
+        
+        int item_symbol = loader_intern(loader, world ? &world->item_symbols : NULL, &loader->sizes.item_names);
+        if (!add(loader, item_symbol, context)) return false;
     }
-    return false;
+    return true;
+}
+
+static bool add_location_item(JsonLoader* loader, int item_symbol, void* context) {
+    Location* location = context;
+    if (!loader->world) {
+        loader->location_items_count++;
+    } else if (item_symbol != INVALID_SYMBOL) {
+        if (loader->items_used == loader->location_items_count) return false;
+        *loader->next_item++ = item_symbol;
+        loader->items_used++;
+        location->items_count++;
+    }
+    return true;
+}
+
+static bool add_inventory_item(JsonLoader* loader, int item_symbol, void* context) {
+    Player* player = context;
+    if (loader->world && item_symbol != INVALID_SYMBOL && !BIT_TEST(player->inventory, item_symbol)) {
+        BIT_SET(player->inventory, item_symbol);
+        player->inventory_count++;
+    }
+    return true;
 }
 
-// Parse location from JSON
-bool parse_location(json_object* location_json, Location* location, const char* location_id) {
-    if (!location_json || !location) return false;
+static bool parse_exits(JsonLoader* loader, JsonToken token, Location* location) {
+    if (token != JSON_TOKEN_OBJECT_BEGIN) return skip_value(loader, token);
     
-    // Set location ID
-    safe_strcpy(location->id, location_id, sizeof(location->id));
+    if (location) {
+        location->exits = loader->next_exit;
+        location->exits_count = 0;
+    }
     
-    // Parse basic properties
-    const char* title = get_json_string(location_json, "title");
-    if (title) {
-        safe_strcpy(location->title, title, sizeof(location->title));
+    while ((token = next_token(loader)) == JSON_TOKEN_KEY) {
+        const char* direction = loader_strdup(loader);
+        
+        token = next_token(loader);
+        if (token != JSON_TOKEN_STRING) {
+            if (!skip_value(loader, token)) return false;
+            continue;
+        }
+        
+        const char* target = loader_strdup(loader);
+        if (!location) {
+            loader->exits_count++;
+            continue;
+        }
+        
+        // The fill pass re-reads the file, which may have grown since it was measured
+        if (!direction || !target || loader->exits_used == loader->exits_count) return false;
+        loader->exits_used++;
+        Exit* exit = loader->next_exit++;
+        exit->direction = direction;
+        exit->target_location = target;
+        exit->target_index = INVALID_LOCATION;
+        exit->direction_id = DIRECTION_NONE;
+        location->exits_count++;
     }
+    return token == JSON_TOKEN_OBJECT_END;
+}
+
+// Parse location from the stream (location is NULL while measuring)
+static bool parse_location(JsonLoader* loader, JsonToken token, Location* location) {
+    if (token != JSON_TOKEN_OBJECT_BEGIN) return skip_value(loader, token);
     
-    const char* description = get_json_string(location_json, "description");
-    if (description) {
-        safe_strcpy(location->description, description, sizeof(location->description));
+    while ((token = next_token(loader)) == JSON_TOKEN_KEY) {
+        const char* key = loader->stream.text;
+        bool ok;
+        bool visited;
+        
+        if (loader->lazy_text && location_text_field(key) != LOCATION_TEXT_NONE) {
+            ok = json_stream_skip_next(&loader->stream); // Decoded on first access instead
+        } else if (strcmp(key, "title") == 0) {
+            ok = read_string_value(loader, next_token(loader), location ? &location->title : NULL);
+        } else if (strcmp(key, "description") == 0) {
+            ok = read_string_value(loader, next_token(loader), location ? &location->description : NULL);
+        } else if (strcmp(key, "image") == 0) {
+            ok = read_string_value(loader, next_token(loader), location ? &location->image_path : NULL);
+        } else if (strcmp(key, "first_visit_text") == 0) {
+            ok = read_string_value(loader, next_token(loader), location ? &location->first_visit_text : NULL);
+        } else if (strcmp(key, "visited") == 0) {
+            ok = read_bool_value(loader, next_token(loader), &visited);
+            if (location) location->visited = visited;
+        } else if (strcmp(key, "exits") == 0) {
+            ok = parse_exits(loader, next_token(loader), location);
+        } else if (strcmp(key, "flags_required") == 0) {
+            ok = parse_flag_condition(loader, next_token(loader), location ? &location->flags_required : NULL,
+                                      location ? &location->flags_required_count : NULL);
+        } else if (strcmp(key, "flags_set") == 0) {
+            ok = parse_flag_condition(loader, next_token(loader), location ? &location->flags_set : NULL,
+                                      location ? &location->flags_set_count : NULL);
+        } else if (strcmp(key, "items") == 0) {
+            if (location) {
+                location->items = loader->next_item;
+                location->items_count = 0;
+            }
+            ok = parse_item_list(loader, next_token(loader), add_location_item, location);
+        } else {
+            ok = skip_value(loader, next_token(loader));
+        }
+        
+        if (!ok) return false;
     }
+    return token == JSON_TOKEN_OBJECT_END;
+}
+
+static bool parse_locations(JsonLoader* loader, JsonToken token) {
+    if (token != JSON_TOKEN_OBJECT_BEGIN) return skip_value(loader, token);
     
-    const char* image = get_json_string(location_json, "image");
-    if (image) {
-        safe_strcpy(location->image_path, image, sizeof(location->image_path));
+    World* world = loader->world;
+    while ((token = next_token(loader)) == JSON_TOKEN_KEY) {
+        Location* location = NULL;
+        
+        if (!world) {
+            loader->sizes.locations++;
+            loader_strdup(loader);
+        } else if (symbol_intern(&world->location_symbols, &world->arena, loader->stream.text) == world->locations_count) {
+            location = &world->locations[world->locations_count++];
+            location->id = symbol_name(&world->location_symbols, world->locations_count - 1);
+            location->title = location->description = location->image_path = location->first_visit_text = "";
+        } else {
+            // Duplicate id, keep the first definition
+            if (!skip_value(loader, next_token(loader))) return false;
+            continue;
+        }
+        
+        token = next_token(loader);
+        if (location && world->text_offsets) {
+            world->text_offsets[world->locations_count - 1] = loader->stream.token_offset;
+        }
+        long long start = profile_begin();
+        bool parsed = parse_location(loader, token, location);
+        profile_end(PROFILE_PARSE_LOCATION, start);
+        if (!parsed) return false;
     }
+    return token == JSON_TOKEN_OBJECT_END;
+}
+
+// Parse inventory item from the stream (item is NULL while measuring)
+static bool parse_inventory_item(JsonLoader* loader, JsonToken token, InventoryItem* item) {
+    if (token != JSON_TOKEN_OBJECT_BEGIN) return skip_value(loader, token);
     
-    const char* first_visit = get_json_string(location_json, "first_visit_text");
-    if (first_visit) {
-        safe_strcpy(location->first_visit_text, first_visit, sizeof(location->first_visit_text));
+    while ((token = next_token(loader)) == JSON_TOKEN_KEY) {
+        const char* key = loader->stream.text;
+        bool ok;
+        bool value;
+        
+        if (strcmp(key, "name") == 0) {
+            ok = read_string_value(loader, next_token(loader), item ? &item->name : NULL);
+        } else if (strcmp(key, "description") == 0) {
+            ok = read_string_value(loader, next_token(loader), item ? &item->description : NULL);
+        } else if (strcmp(key, "use_text") == 0) {
+            ok = read_string_value(loader, next_token(loader), item ? &item->use_text : NULL);
+        } else if (strcmp(key, "takeable") == 0) {
+            ok = read_bool_value(loader, next_token(loader), &value);
+            if (item) item->takeable = value;
+        } else if (strcmp(key, "useable") == 0) {
+            ok = read_bool_value(loader, next_token(loader), &value);
+            if (item) item->useable = value;
+        } else {
+            ok = skip_value(loader, next_token(loader));
+        }
+        
+        if (!ok) return false;
     }
+    return token == JSON_TOKEN_OBJECT_END;
+}
+
+static bool parse_inventory_items(JsonLoader* loader, JsonToken token) {
+    if (token != JSON_TOKEN_OBJECT_BEGIN) return skip_value(loader, token);
     
-    location->visited = get_json_bool(location_json, "visited");
+    World* world = loader->world;
+    while ((token = next_token(loader)) == JSON_TOKEN_KEY) {
+        InventoryItem* item = NULL;
+        
+        if (!world) {
+            loader->sizes.inventory_items++;
+            loader_intern(loader, NULL, &loader->sizes.item_names);
+        } else if (symbol_intern(&world->item_symbols, &world->arena, loader->stream.text) == world->inventory_items_count) {
+            // Defined items are interned first so their symbols match their indices
+            item = &world->inventory_items[world->inventory_items_count++];
+            item->id = symbol_name(&world->item_symbols, world->inventory_items_count - 1);
+            item->name = item->description = item->use_text = "";
+        } else {
+            if (!skip_value(loader, next_token(loader))) return false;
+            continue;
+        }
+        
+        if (!parse_inventory_item(loader, next_token(loader), item)) return false;
+    }
+    return token == JSON_TOKEN_OBJECT_END;
+}
+
+static bool parse_meta(JsonLoader* loader, JsonToken token) {
+    if (token != JSON_TOKEN_OBJECT_BEGIN) return skip_value(loader, token);
     
-    // Parse exits
-    json_object* exits;
-    if (json_object_object_get_ex(location_json, "exits", &exits)) {
-        if (json_object_is_type(exits, json_type_object)) {
-            location->exits_count = 0;
-            
-            // Iterate through exits object
-            json_object_object_foreach(exits, direction, target_obj) {
-                if (location->exits_count >= MAX_EXITS) break;
-                
-                if (json_object_is_type(target_obj, json_type_string)) {
-                    safe_strcpy(location->exits[location->exits_count].direction, 
-                               direction, sizeof(location->exits[location->exits_count].direction));
-                    safe_strcpy(location->exits[location->exits_count].target_location, 
-                               json_object_get_string(target_obj), 
-                               sizeof(location->exits[location->exits_count].target_location));
-                    location->exits_count++;
-                }
-            }
+    GameMeta* meta = loader->world ? &loader->world->meta : NULL;
+    while ((token = next_token(loader)) == JSON_TOKEN_KEY) {
+        const char* key = loader->stream.text;
+        const char** field = NULL;
+        
+        if (strcmp(key, "title") == 0) field = meta ? &meta->title : NULL;
+        else if (strcmp(key, "author") == 0) field = meta ? &meta->author : NULL;
+        else if (strcmp(key, "description") == 0) field = meta ? &meta->description : NULL;
+        else if (strcmp(key, "version") == 0) field = meta ? &meta->version : NULL;
+        else {
+            if (!skip_value(loader, next_token(loader))) return false;
+            continue;
         }
+        
+        if (!read_string_value(loader, next_token(loader), field)) return false;
     }
+    return token == JSON_TOKEN_OBJECT_END;
+}
+
+static bool parse_start_location(JsonLoader* loader, JsonToken token) {
+    return read_string_value(loader, token, loader->world ? &loader->world->start_location : NULL);
+}
+
+static bool parse_game_flags(JsonLoader* loader, JsonToken token) {
+    World* world = loader->world;
+    if (!parse_flag_values(loader, token, world ? world->game_flags : NULL)) return false;
     
-    // Parse items
-    json_object* items;
-    if (json_object_object_get_ex(location_json, "items", &items)) {
-        if (json_object_is_type(items, json_type_array)) {
-            location->items_count = 0;
-            int array_len = json_object_array_length(items);
-            
-            for (int i = 0; i < array_len && location->items_count < MAX_ITEMS; i++) {
-                json_object* item = json_object_array_get_idx(items, i);
-                if (json_object_is_type(item, json_type_string)) {
-                    safe_strcpy(location->items[location->items_count], 
-                               json_object_get_string(item), 
-                               sizeof(location->items[location->items_count]));
-                    location->items_count++;
-                }
+    if (world) {
+        memcpy(world->start.flags, world->game_flags, world->flag_words * sizeof(unsigned int));
+    }
+    return true;
+}
+
+static bool parse_player(JsonLoader* loader, JsonToken token) {
+    if (token != JSON_TOKEN_OBJECT_BEGIN) return skip_value(loader, token);
+    
+    World* world = loader->world;
+    while ((token = next_token(loader)) == JSON_TOKEN_KEY) {
+        const char* key = loader->stream.text;
+        bool ok;
+        
+        if (strcmp(key, "current_location") == 0) {
+            token = next_token(loader);
+            if (world && token == JSON_TOKEN_STRING) {
+                world->start.current_location_index = symbol_lookup(&world->location_symbols, loader->stream.text);
             }
+            ok = skip_value(loader, token);
+        } else if (strcmp(key, "inventory") == 0) {
+            ok = parse_item_list(loader, next_token(loader), add_inventory_item, world ? &world->start : NULL);
+        } else if (strcmp(key, "flags") == 0) {
+            // Player flags override the game flag defaults
+            ok = parse_flag_values(loader, next_token(loader), world ? world->start.flags : NULL);
+        } else {
+            ok = skip_value(loader, next_token(loader));
         }
+        
+        if (!ok) return false;
     }
+    return token == JSON_TOKEN_OBJECT_END;
+}
+
+// Count a manifest's ["region.advgpt", ...] list; read_region_paths reads it
+static bool parse_regions(JsonLoader* loader, JsonToken token) {
+    if (token != JSON_TOKEN_ARRAY_BEGIN) return skip_value(loader, token);
     
+    while ((token = next_token(loader)) != JSON_TOKEN_ARRAY_END) {
+        if (token == JSON_TOKEN_STRING) loader->regions_count++;
+        if (!skip_value(loader, token)) return false;
+    }
     return true;
 }
 
-// Parse inventory item from JSON
-bool parse_inventory_item(json_object* item_json, InventoryItem* item, const char* item_id) {
-    if (!item_json || !item) return false;
+static const struct {
+    const char* key;
+    bool (*parse)(JsonLoader* loader, JsonToken token);
+} section_parsers[SECTION_COUNT] = {
+    [SECTION_META] = {"meta", parse_meta},
+    [SECTION_START_LOCATION] = {"start_location", parse_start_location},
+    [SECTION_INVENTORY_ITEMS] = {"inventory_items", parse_inventory_items},
+    [SECTION_GAME_FLAGS] = {"game_flags", parse_game_flags},
+    [SECTION_LOCATIONS] = {"locations", parse_locations},
+    [SECTION_PLAYER] = {"player", parse_player},
+    [SECTION_REGIONS] = {"regions", parse_regions},
+};
+
+// First pass: walk the whole file in order, totalling allocations and
+// remembering where each known section starts
+static bool measure_world(JsonLoader* loader) {
+    JsonToken token = next_token(loader);
+    if (token != JSON_TOKEN_OBJECT_BEGIN) return false;
+    
+    for (int i = 0; i < SECTION_COUNT; i++) {
+        loader->sections[i] = -1;
+    }
     
-    safe_strcpy(item->id, item_id, sizeof(item->id));
+    while ((token = next_token(loader)) == JSON_TOKEN_KEY) {
+        int section = 0;
+        while (section < SECTION_COUNT && strcmp(section_parsers[section].key, loader->stream.text) != 0) {
+            section++;
+        }
+        
+        token = next_token(loader);
+        if (section == SECTION_COUNT) {
+            if (!skip_value(loader, token)) return false;
+            continue;
+        }
+        
+        loader->sections[section] = loader->stream.token_offset;
+        if (!section_parsers[section].parse(loader, token)) return false;
+    }
+    if (token != JSON_TOKEN_OBJECT_END || next_token(loader) != JSON_TOKEN_END) return false;
     
-    const char* name = get_json_string(item_json, "name");
-    if (name) {
-        safe_strcpy(item->name, name, sizeof(item->name));
+    loader->sizes.bytes += ARENA_ALIGN(loader->exits_count * sizeof(Exit));
+    loader->sizes.bytes += ARENA_ALIGN(loader->location_items_count * sizeof(int));
+    loader->sizes.bytes += ARENA_ALIGN(loader->flag_terms_count * sizeof(FlagTerm));
+    if (loader->lazy_text) {
+        loader->sizes.bytes += ARENA_ALIGN(loader->sizes.locations * sizeof(long));
+    }
+    loader->sizes.exits = loader->exits_count;
+    loader->sizes.item_refs = loader->location_items_count;
+    loader->sizes.records_only = loader->region;
+    world_sizes_finish(&loader->sizes);
+    return true;
+}
+
+// Second pass: read each section in dependency order into the allocated world
+static bool fill_world(JsonLoader* loader) {
+    World* world = loader->world;
+    world->meta.title = world->meta.author = world->meta.description = world->meta.version = "";
+    world->start_location = "";
+    world->start.current_location_index = INVALID_LOCATION;
+    bool has_current_location = false;
+    
+    loader->next_exit = arena_alloc(&world->arena, loader->exits_count * sizeof(Exit));
+    loader->next_item = arena_alloc(&world->arena, loader->location_items_count * sizeof(int));
+    loader->next_flag_term = arena_alloc(&world->arena, loader->flag_terms_count * sizeof(FlagTerm));
+    if (loader->lazy_text) {
+        world->text_offsets = arena_alloc(&world->arena, loader->sizes.locations * sizeof(long));
     }
     
-    const char* description = get_json_string(item_json, "description");
-    if (description) {
-        safe_strcpy(item->description, description, sizeof(item->description));
+    for (int section = 0; section < SECTION_COUNT; section++) {
+        if (loader->sections[section] < 0 || section == SECTION_REGIONS) continue;
+        
+        if (section == SECTION_PLAYER) {
+            // Exits can point forward, so resolve them once every location exists
+            resolve_exits(world);
+        }
+        
+        if (!json_stream_seek(&loader->stream, loader->sections[section]) ||
+            !section_parsers[section].parse(loader, next_token(loader))) {
+            return false;
+        }
+        
+        if (section == SECTION_PLAYER) {
+            has_current_location = world->start.current_location_index != INVALID_LOCATION;
+        }
     }
     
-    item->takeable = get_json_bool(item_json, "takeable");
-    item->useable = get_json_bool(item_json, "useable");
+    if (loader->sections[SECTION_PLAYER] < 0) {
+        resolve_exits(world);
+    }
     
-    const char* use_text = get_json_string(item_json, "use_text");
-    if (use_text) {
-        safe_strcpy(item->use_text, use_text, sizeof(item->use_text));
+    // Default player to start location
+    if (!has_current_location) {
+        world->start.current_location_index = symbol_lookup(&world->location_symbols, world->start_location);
     }
     
     return true;
 }
 
-GameState* load_game(const char* filename) {
-    char* file_content = read_file(filename);
-    if (!file_content) {
+static void free_region_paths(char** paths, int count) {
+    for (int i = 0; i < count && paths; i++) {
+        free(paths[i]);
+    }
+    free(paths);
+}
+
+// Region paths of a measured manifest, relative to the manifest's directory
+// unless absolute; NULL after printing an error
+static char** read_region_paths(JsonLoader* loader, const char* manifest) {
+    const char* slash = strrchr(manifest, '/');
+    const char* backslash = strrchr(manifest, '\\');
+    if (backslash > slash) slash = backslash;
+    size_t directory_length = slash ? (size_t)(slash - manifest) + 1 : 0;
+    
+    char** paths = calloc(loader->regions_count, sizeof(char*));
+    if (!paths || !json_stream_seek(&loader->stream, loader->sections[SECTION_REGIONS])) {
+        free(paths);
+        printf("Error: Could not read the region list of %s\n", manifest);
         return NULL;
     }
     
-    json_object* json = json_tokener_parse(file_content);
-    free(file_content);
+    JsonToken token = next_token(loader); // The array the measuring pass counted
+    int count = 0;
+    while (token != JSON_TOKEN_ERROR && (token = next_token(loader)) != JSON_TOKEN_ARRAY_END) {
+        if (token != JSON_TOKEN_STRING || count == loader->regions_count) {
+            if (!skip_value(loader, token)) break;
+            continue;
+        }
+        
+        const char* name = loader->stream.text;
+        bool absolute = name[0] == '/' || name[0] == '\\' || (name[0] && name[1] == ':');
+        size_t prefix = absolute ? 0 : directory_length;
+        char* path = malloc(prefix + loader->stream.text_length + 1);
+        if (!path) break;
+        memcpy(path, manifest, prefix);
+        memcpy(path + prefix, name, loader->stream.text_length + 1);
+        paths[count++] = path;
+    }
     
-    if (!json) {
-        printf("Error: Invalid JSON in game file\n");
+    if (count < loader->regions_count) {
+        printf("Error: Could not read the region list of %s\n", manifest);
+        free_region_paths(paths, count);
+        return NULL;
+    }
+    return paths;
+}
+
+static World* read_json_world(const char* filename, bool lazy_text, bool region) {
+    JsonLoader loader;
+    memset(&loader, 0, sizeof(loader));
+    loader.lazy_text = lazy_text;
+    loader.region = region;
+    if (!json_stream_open(&loader.stream, filename)) {
+        printf("Error: Could not open file %s\n", filename);
         return NULL;
     }
     
-    GameState* game = calloc(1, sizeof(GameState));
-    if (!game) {
-        printf("Error: Could not allocate memory for game state\n");
-        json_object_put(json);
+    if (!measure_world(&loader)) {
+        printf("Error: Invalid JSON in game file (at byte %ld)\n", loader.stream.token_offset);
+        json_stream_close(&loader.stream);
         return NULL;
     }
     
-    // Parse metadata
-    json_object* meta;
-    if (json_object_object_get_ex(json, "meta", &meta)) {
-        const char* title = get_json_string(meta, "title");
-        if (title) {
-            safe_strcpy(game->meta.title, title, sizeof(game->meta.title));
-        }
+    // A manifest is loaded as its own first region followed by the files it
+    // lists; every region is read eagerly, so lazy text does not apply
+    if (!region && loader.regions_count > 0) {
+        char** paths = read_region_paths(&loader, filename);
+        json_stream_close(&loader.stream);
+        if (!paths) return NULL;
         
-        const char* author = get_json_string(meta, "author");
-        if (author) {
-            safe_strcpy(game->meta.author, author, sizeof(game->meta.author));
+        World* world = load_world_regions(filename, (const char* const*)paths, loader.regions_count);
+        free_region_paths(paths, loader.regions_count);
+        return world;
+    }
+    
+    loader.world = allocate_world(&loader.sizes);
+    if (!loader.world) {
+        printf("Error: Could not allocate memory for game world\n");
+        json_stream_close(&loader.stream);
+        return NULL;
+    }
+    
+    bool loaded = fill_world(&loader);
+    // The tokenizer's buffers were held throughout, and its text buffer only grows
+    loader.world->load_peak = loader.world->arena.size + JSON_STREAM_CHUNK_SIZE + loader.stream.text_capacity;
+    json_stream_close(&loader.stream);
+    
+    if (!loaded) {
+        printf("Error: Game file changed while loading\n");
+        cleanup_world(loader.world);
+        return NULL;
+    }
+    
+    // Lazy text is decoded straight out of the mapped file
+    if (lazy_text) {
+        loader.world->mapping = map_file(filename, &loader.world->mapping_size);
+        if (!loader.world->mapping) {
+            printf("Error: Could not map game file %s\n", filename);
+            cleanup_world(loader.world);
+            return NULL;
         }
-        
-        const char* description = get_json_string(meta, "description");
-        if (description) {
-            safe_strcpy(game->meta.description, description, sizeof(game->meta.description));
+    }
+    
+    return loader.world;
+}
+
+static World* load_json_world(const char* filename, bool lazy_text) {
+    return read_json_world(filename, lazy_text, false);
+}
+
+World* load_region_world(const char* filename) {
+    return read_json_world(filename, false, true);
+}
+
+static World* open_world(const char* filename, bool lazy_text) {
+    // Compiled bundles are mapped directly instead of parsed, so their text is
+    // only paged in when read either way
+    long long start = profile_begin();
+    World* world = is_bundle_file(filename) ? load_bundle(filename) : load_json_world(filename, lazy_text);
+    if (world && (!build_world_graph(world) || !build_name_index(world))) {
+        printf("Error: Game file %s has overlapping exit tables\n", filename);
+        cleanup_world(world);
+        world = NULL;
+    }
+    if (world) world->fingerprint = world_fingerprint(world);
+    profile_end(PROFILE_LOAD_WORLD, start);
+    return world;
+}
+
+World* load_world(const char* filename) {
+    return open_world(filename, false);
+}
+
+// Load ids, exits, items and flags only; location text is decoded when a
+// session first looks the location up (see location_text.h)
+World* load_world_lazy(const char* filename) {
+    return open_world(filename, true);
+}
+
+void cleanup_world(World* world) {
+    if (world) {
+        if (world->mapping) {
+            unmap_file(world->mapping, world->mapping_size);
         }
-        
-        const char* version = get_json_string(meta, "version");
-        if (version) {
-            safe_strcpy(game->meta.version, version, sizeof(game->meta.version));
+        for (int i = 0; i < world->regions_count; i++) {
+            cleanup_world(world->regions[i]);
         }
+        
+        // The world lives inside its own arena
+        Arena arena = world->arena;
+        arena_free(&arena);
     }
+}
+
+// A new session is one allocation: the struct followed by the player's bitsets.
+// Location deltas are allocated as the player touches locations.
+size_t session_size(const World* world) {
+    size_t words = world->item_words + world->flag_words;
+    return sizeof(GameState) + words * sizeof(unsigned int);
+}
+
+GameState* create_session(const World* world) {
+    if (!world) return NULL;
     
-    // Parse start location
-    const char* start_location = get_json_string(json, "start_location");
-    if (start_location) {
-        safe_strcpy(game->start_location, start_location, sizeof(game->start_location));
+    GameState* game = calloc(1, session_size(world));
+    if (!game) {
+        printf("Error: Could not allocate memory for game session\n");
+        return NULL;
     }
     
-    // Parse locations
-    json_object* locations;
-    if (json_object_object_get_ex(json, "locations", &locations)) {
-        if (json_object_is_type(locations, json_type_object)) {
-            game->locations_count = 0;
-            
-            // Iterate through locations object
-            json_object_object_foreach(locations, location_id, location_obj) {
-                if (game->locations_count >= MAX_LOCATIONS) break;
-                
-                if (parse_location(location_obj, &game->locations[game->locations_count], location_id)) {
-                    game->locations_count++;
-                }
-            }
-        }
+    unsigned int* words = (unsigned int*)(game + 1);
+    game->world = world;
+    game->player.inventory = words;
+    game->player.flags = game->player.inventory + world->item_words;
+    
+    // Start from the authored player; locations start out as authored with no deltas
+    game->player.inventory_count = world->start.inventory_count;
+    game->player.current_location_index = world->start.current_location_index;
+    memcpy(game->player.inventory, world->start.inventory, world->item_words * sizeof(unsigned int));
+    memcpy(game->player.flags, world->start.flags, world->flag_words * sizeof(unsigned int));
+    
+    return game;
+}
+
+void cleanup_session(GameState* game) {
+    if (!game) return;
+    
+    LocationOverlay* overlay = &game->overlay;
+    for (int i = 0; i < overlay->capacity; i++) {
+        free(overlay->deltas[i].taken);
     }
+    free(overlay->deltas);
+    free_route_cache(game->routes);
+    free_location_text_cache(game->text);
+    free(game);
+}
+
+// Overlay slots come from the low bits, so mix until every input bit affects them
+static unsigned int hash_location(int location_index) {
+    unsigned int hash = (unsigned int)location_index;
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+LocationDelta* find_location_delta(const GameState* game, int location_index) {
+    const LocationOverlay* overlay = &game->overlay;
+    if (overlay->capacity == 0) return NULL;
     
-    // Parse inventory items
-    json_object* inventory_items;
-    if (json_object_object_get_ex(json, "inventory_items", &inventory_items)) {
-        if (json_object_is_type(inventory_items, json_type_object)) {
-            game->inventory_items_count = 0;
-            
-            // Iterate through inventory items object
-            json_object_object_foreach(inventory_items, item_id, item_obj) {
-                if (game->inventory_items_count >= MAX_INVENTORY_ITEMS) break;
-                
-                if (parse_inventory_item(item_obj, &game->inventory_items[game->inventory_items_count], item_id)) {
-                    game->inventory_items_count++;
-                }
-            }
-        }
+    unsigned int mask = (unsigned int)overlay->capacity - 1;
+    for (unsigned int slot = hash_location(location_index) & mask;; slot = (slot + 1) & mask) {
+        LocationDelta* delta = &overlay->deltas[slot];
+        if (delta->location == location_index) return delta;
+        if (delta->location == INVALID_LOCATION) return NULL;
     }
+}
+
+static LocationDelta* insert_delta(LocationDelta* deltas, int capacity, int location_index) {
+    unsigned int mask = (unsigned int)capacity - 1;
+    unsigned int slot = hash_location(location_index) & mask;
+    while (deltas[slot].location != INVALID_LOCATION) {
+        slot = (slot + 1) & mask;
+    }
+    deltas[slot].location = location_index;
+    return &deltas[slot];
+}
+
+// Make room for count deltas in total, keeping the table under 3/4 load so probes stay short
+bool reserve_location_deltas(GameState* game, int count) {
+    LocationOverlay* overlay = &game->overlay;
+    if (count * 4 <= overlay->capacity * 3) return true;
     
-    // Parse player data
-    json_object* player;
-    if (json_object_object_get_ex(json, "player", &player)) {
-        const char* current_location = get_json_string(player, "current_location");
-        if (current_location) {
-            safe_strcpy(game->player.current_location, current_location, 
-                       sizeof(game->player.current_location));
-        } else {
-            // Default to start location
-            safe_strcpy(game->player.current_location, game->start_location, 
-                       sizeof(game->player.current_location));
-        }
-        
-        // Parse player inventory
-        json_object* inventory;
-        if (json_object_object_get_ex(player, "inventory", &inventory)) {
-            if (json_object_is_type(inventory, json_type_array)) {
-                game->player.inventory_count = 0;
-                int array_len = json_object_array_length(inventory);
-                
-                for (int i = 0; i < array_len && game->player.inventory_count < MAX_INVENTORY_ITEMS; i++) {
-                    json_object* item = json_object_array_get_idx(inventory, i);
-                    if (json_object_is_type(item, json_type_string)) {
-                        safe_strcpy(game->player.inventory[game->player.inventory_count], 
-                                   json_object_get_string(item), 
-                                   sizeof(game->player.inventory[game->player.inventory_count]));
-                        game->player.inventory_count++;
-                    }
-                }
-            }
+    int capacity = overlay->capacity ? overlay->capacity : 8;
+    while (count * 4 > capacity * 3) capacity *= 2;
+    
+    LocationDelta* deltas = malloc(capacity * sizeof(LocationDelta));
+    if (!deltas) {
+        printf("Error: Could not allocate location state\n");
+        return false;
+    }
+    for (int i = 0; i < capacity; i++) {
+        deltas[i].location = INVALID_LOCATION;
+        deltas[i].state = 0;
+        deltas[i].taken = NULL;
+    }
+    for (int i = 0; i < overlay->capacity; i++) {
+        const LocationDelta* old = &overlay->deltas[i];
+        if (old->location != INVALID_LOCATION) {
+            *insert_delta(deltas, capacity, old->location) = *old;
         }
-    } else {
-        // Default player to start location
-        safe_strcpy(game->player.current_location, game->start_location, 
-                   sizeof(game->player.current_location));
+    }
+    free(overlay->deltas);
+    overlay->deltas = deltas;
+    overlay->capacity = capacity;
+    return true;
+}
+
+// Delta for a location the session is about to change, created on first write
+LocationDelta* touch_location(GameState* game, int location_index) {
+    LocationDelta* delta = find_location_delta(game, location_index);
+    if (delta) return delta;
+    
+    LocationOverlay* overlay = &game->overlay;
+    if (!reserve_location_deltas(game, overlay->count + 1)) return NULL;
+    
+    overlay->count++;
+    return insert_delta(overlay->deltas, overlay->capacity, location_index);
+}
+
+// The authored value, unless this session has been there since
+bool location_visited(GameState* game, int location_index) {
+    if (!game || location_index < 0 || location_index >= game->world->locations_count) return false;
+    if (game->world->locations[location_index].visited) return true;
+    
+    const LocationDelta* delta = find_location_delta(game, location_index);
+    return delta && (delta->state & LOCATION_VISITED);
+}
+
+static GameState* own_world_session(World* world) {
+    if (!world) return NULL;
+    
+    GameState* game = create_session(world);
+    if (!game) {
+        cleanup_world(world);
+        return NULL;
     }
     
-    json_object_put(json);
+    game->owns_world = true;
     return game;
 }
 
+GameState* load_game(const char* filename) {
+    return own_world_session(load_world(filename));
+}
+
+GameState* load_game_lazy(const char* filename) {
+    return own_world_session(load_world_lazy(filename));
+}
+
 void cleanup_game(GameState* game) {
     if (game) {
-        free(game);
+        World* world = game->owns_world ? (World*)game->world : NULL;
+        cleanup_session(game);
+        cleanup_world(world);
     }
 }
 
-Location* get_location_by_id(GameState* game, const char* location_id) {
-    if (!game || !location_id) return NULL;
+int get_location_index(GameState* game, const char* location_id) {
+    if (!game || !location_id) return INVALID_LOCATION;
+    return symbol_lookup(&game->world->location_symbols, location_id);
+}
+
+// The location with its text. In a lazily loaded world the text is decoded
+// into the session's cache, and the result is only valid until the session
+// looks up another location.
+static const Location* session_location(GameState* game, int index) {
+    const World* world = game->world;
+    if (!world->text_offsets) return &world->locations[index];
     
-    for (int i = 0; i < game->locations_count; i++) {
-        if (strcmp(game->locations[i].id, location_id) == 0) {
-            return &game->locations[i];
-        }
+    if (!game->text) {
+        game->text = create_location_text_cache(LOCATION_TEXT_CACHE_ROOMS, LOCATION_TEXT_CACHE_BYTES);
+        if (!game->text) return &world->locations[index]; // Structure without text
     }
+    return location_text(game->text, world, index);
+}
+
+const Location* get_location_by_id(GameState* game, const char* location_id) {
+    int index = get_location_index(game, location_id);
+    if (index == INVALID_LOCATION) return NULL;
     
-    return NULL;
+    return session_location(game, index);
 }
 
-Location* get_current_location(GameState* game) {
+const Location* get_current_location(GameState* game) {
     if (!game) return NULL;
-    return get_location_by_id(game, game->player.current_location);
+    
+    int index = game->player.current_location_index;
+    if (index < 0 || index >= game->world->locations_count) return NULL;
+    
+    return session_location(game, index);
 }
 
-bool move_player(GameState* game, const char* direction) {
-    if (!game || !direction) return false;
+// The plain world record of the current location: exits, items and flags but
+// not necessarily text, which commands have no use for
+static const Location* current_record(GameState* game) {
+    int index = game->player.current_location_index;
+    if (index < 0 || index >= game->world->locations_count) return NULL;
     
-    Location* current_location = get_current_location(game);
+    return &game->world->locations[index];
+}
+
+// The current location's exit for a direction. Known directions and their
+// aliases compare by id; anything else by key, across all the exits at once.
+static int find_exit(GameState* game, const Location* location, Direction direction_id, const char* direction) {
+    if (direction_id != DIRECTION_NONE) {
+        for (int i = 0; i < location->exits_count; i++) {
+            if (location->exits[i].direction_id == direction_id) return i;
+        }
+        return -1;
+    }
+    
+    const NameIndex* names = &game->world->names;
+    int first = names->offsets[game->player.current_location_index];
+    NameToken token;
+    name_token_init(&token, direction);
+    for (int i = 0; (i = find_name_key(names->keys + first, i, location->exits_count, &token)) >= 0; i++) {
+        const Exit* exit = &location->exits[i];
+        if (exit->direction_id == DIRECTION_NONE && name_matches_token(exit->direction, &token)) return i;
+    }
+    return -1;
+}
+
+// Entering a location assigns its flags_set in one masked write per term
+static void apply_location_flags(GameState* game, const Location* location) {
+    const World* world = game->world;
+    unsigned int gates_changed = 0;
+    for (int i = 0; i < location->flags_set_count; i++) {
+        const FlagTerm* term = &location->flags_set[i];
+        unsigned int flags = (game->player.flags[term->word] & ~term->mask) | term->values;
+        gates_changed |= (flags ^ game->player.flags[term->word]) & world->graph.gate_flags[term->word];
+        game->player.flags[term->word] = flags;
+    }
+    if (gates_changed) game->gate_version++;
+}
+
+// Move through the exit named by direction, whose id the caller already resolved
+static bool move_in_direction(GameState* game, Direction direction_id, const char* direction) {
+    const Location* current_location = current_record(game);
     if (!current_location) return false;
     
     // Find the exit in the specified direction
-    for (int i = 0; i < current_location->exits_count; i++) {
-        if (strcasecmp(current_location->exits[i].direction, direction) == 0) {
-            // Check if target location exists
-            Location* target_location = get_location_by_id(game, current_location->exits[i].target_location);
-            if (target_location) {
-                // Move player
-                safe_strcpy(game->player.current_location, current_location->exits[i].target_location,
-                           sizeof(game->player.current_location));
-                
-                // Mark new location as visited
-                target_location->visited = true;
-                
-                printf("You go %s.\n", direction);
-                return true;
-            } else {
-                printf("Error: Exit leads to non-existent location!\n");
+    int i = find_exit(game, current_location, direction_id, direction);
+    if (i >= 0) {
+        // Check if target location exists (resolved once at load time)
+        int target_index = current_location->exits[i].target_index;
+        if (target_index != INVALID_LOCATION) {
+            const Location* target = &game->world->locations[target_index];
+            if (!check_location_requirements(game, target)) {
+                game_message(game, "You can't go %s yet.\n", current_location->exits[i].direction);
                 return false;
             }
+            
+            // Move player
+            game->player.current_location_index = target_index;
+            apply_location_flags(game, target);
+            
+            // Mark new location as visited; authored-visited locations need no delta
+            if (!location_visited(game, target_index)) {
+                LocationDelta* delta = touch_location(game, target_index);
+                if (delta) delta->state |= LOCATION_VISITED;
+            }
+            
+            game_message(game, "You go %s.\n", current_location->exits[i].direction);
+            return true;
+        } else {
+            printf("Error: Exit leads to non-existent location!\n");
+            return false;
         }
     }
     
-    printf("You can't go %s from here.\n", direction);
+    game_message(game, "You can't go %s from here.\n", direction);
     return false;
 }
 
+bool move_player(GameState* game, const char* direction) {
+    if (!game || !direction) return false;
+    return move_in_direction(game, parse_direction(direction), direction);
+}
+
 bool has_item(GameState* game, const char* item_id) {
     if (!game || !item_id) return false;
-    
-    for (int i = 0; i < game->player.inventory_count; i++) {
-        if (strcmp(game->player.inventory[i], item_id) == 0) {
-            return true;
-        }
-    }
-    
-    return false;
+    return has_item_symbol(game, symbol_lookup(&game->world->item_symbols, item_id));
+}
+
+bool has_item_symbol(GameState* game, int item_symbol) {
+    if (!game || item_symbol < 0 || item_symbol >= game->world->item_symbols.count) return false;
+    return BIT_TEST(game->player.inventory, item_symbol);
 }
 
 bool add_item_to_inventory(GameState* game, const char* item_id) {
     if (!game || !item_id) return false;
     
-    if (game->player.inventory_count >= MAX_INVENTORY_ITEMS) {
-        printf("Your inventory is full!\n");
+    // The world is shared, so only items it already names can be carried
+    int item_symbol = symbol_lookup(&game->world->item_symbols, item_id);
+    if (item_symbol == INVALID_SYMBOL) {
+        printf("Error: Unknown item %s\n", item_id);
         return false;
     }
     
-    if (has_item(game, item_id)) {
-        printf("You already have that item.\n");
+    if (BIT_TEST(game->player.inventory, item_symbol)) {
+        game_message(game, "You already have that item.\n");
         return false;
     }
     
-    safe_strcpy(game->player.inventory[game->player.inventory_count], item_id,
-               sizeof(game->player.inventory[game->player.inventory_count]));
+    BIT_SET(game->player.inventory, item_symbol);
     game->player.inventory_count++;
     
     return true;
@@ -382,78 +1218,344 @@ bool add_item_to_inventory(GameState* game, const char* item_id) {
 bool remove_item_from_inventory(GameState* game, const char* item_id) {
     if (!game || !item_id) return false;
     
-    for (int i = 0; i < game->player.inventory_count; i++) {
-        if (strcmp(game->player.inventory[i], item_id) == 0) {
-            // Shift remaining items down
-            for (int j = i; j < game->player.inventory_count - 1; j++) {
-                strcpy(game->player.inventory[j], game->player.inventory[j + 1]);
-            }
-            game->player.inventory_count--;
-            return true;
-        }
-    }
+    int item_symbol = symbol_lookup(&game->world->item_symbols, item_id);
+    if (!has_item_symbol(game, item_symbol)) return false;
     
-    return false;
+    BIT_CLEAR(game->player.inventory, item_symbol);
+    game->player.inventory_count--;
+    return true;
 }
 
 bool get_flag(GameState* game, const char* flag_name) {
     if (!game || !flag_name) return false;
+    return get_flag_symbol(game, symbol_lookup(&game->world->flag_symbols, flag_name));
+}
+
+bool get_flag_symbol(GameState* game, int flag_symbol) {
+    if (!game || flag_symbol < 0 || flag_symbol >= game->world->flag_symbols.count) {
+        return false; // Default to false if flag not found
+    }
+    return BIT_TEST(game->player.flags, flag_symbol);
+}
+
+void set_flag(GameState* game, const char* flag_name, bool value) {
+    if (!game || !flag_name) return;
     
-    // Check player flags first
-    for (int i = 0; i < game->player.flags_count; i++) {
-        if (strcmp(game->player.flags[i], flag_name) == 0) {
-            return game->player.flag_values[i];
-        }
+    int flag_symbol = symbol_lookup(&game->world->flag_symbols, flag_name);
+    if (flag_symbol == INVALID_SYMBOL) {
+        printf("Error: Unknown flag %s\n", flag_name);
+        return;
     }
+    set_flag_symbol(game, flag_symbol, value);
+}
+
+void set_flag_symbol(GameState* game, int flag_symbol, bool value) {
+    if (!game || flag_symbol < 0 || flag_symbol >= game->world->flag_symbols.count) return;
     
-    // Check game flags
-    for (int i = 0; i < game->game_flags_count; i++) {
-        if (strcmp(game->game_flags[i], flag_name) == 0) {
-            return game->game_flag_values[i];
-        }
+    // Cached routes assumed the old value of a flag that gates a location
+    if (BIT_TEST(game->world->graph.gate_flags, flag_symbol) && BIT_TEST(game->player.flags, flag_symbol) != value) {
+        game->gate_version++;
+    }
+    
+    if (value) {
+        BIT_SET(game->player.flags, flag_symbol);
+    } else {
+        BIT_CLEAR(game->player.flags, flag_symbol);
     }
+}
+
+// Add one flag's value to a condition, merging it into the term for its word.
+// Returns the new term count; terms needs room for one more.
+int add_flag_term(FlagTerm* terms, int count, int flag_symbol, bool value) {
+    int word = flag_symbol >> 5;
+    unsigned int bit = 1u << (flag_symbol & 31);
     
-    return false; // Default to false if flag not found
+    int i = 0;
+    while (i < count && terms[i].word != word) i++;
+    if (i == count) {
+        terms[i].word = word;
+        terms[i].mask = terms[i].values = 0;
+        count++;
+    }
+    
+    terms[i].mask |= bit;
+    if (value) {
+        terms[i].values |= bit;
+    } else {
+        terms[i].values &= ~bit;
+    }
+    return count;
 }
 
-void set_flag(GameState* game, const char* flag_name, bool value) {
-    if (!game || !flag_name) return;
+bool check_location_requirements(GameState* game, const Location* location) {
+    if (!game || !location) return true;
     
-    // Try to update existing player flag first
-    for (int i = 0; i < game->player.flags_count; i++) {
-        if (strcmp(game->player.flags[i], flag_name) == 0) {
-            game->player.flag_values[i] = value;
-            return;
+    // A requirement fails where a named flag differs from its required value
+    for (int i = 0; i < location->flags_required_count; i++) {
+        const FlagTerm* term = &location->flags_required[i];
+        if ((game->player.flags[term->word] ^ term->values) & term->mask) {
+            return false; // Requirement not met
         }
     }
     
-    // Try to update existing game flag
-    for (int i = 0; i < game->game_flags_count; i++) {
-        if (strcmp(game->game_flags[i], flag_name) == 0) {
-            game->game_flag_values[i] = value;
-            return;
+    return true; // All requirements met (or there are none)
+}
+
+// Pick up an item lying in the current location, matched by id or display name
+bool take_item(GameState* game, const char* item_name) {
+    if (!game || !item_name) return false;
+    
+    const Location* location = current_record(game);
+    if (!location) return false;
+    
+    const World* world = game->world;
+    const LocationDelta* delta = find_location_delta(game, game->player.current_location_index);
+    
+    // Entry i of the item list has its id key at keys[2 * i] and its name key next
+    const NameKey* keys = world->names.keys + world->names.offsets[game->player.current_location_index] +
+                          location->exits_count;
+    NameToken token;
+    name_token_init(&token, item_name);
+    for (int k = 0; (k = find_name_key(keys, k, 2 * location->items_count, &token)) >= 0; k++) {
+        int i = k / 2;
+        if (delta && delta->taken && BIT_TEST(delta->taken, i)) continue;
+        
+        int item_symbol = location->items[i];
+        const char* item_id = symbol_name(&world->item_symbols, item_symbol);
+        const InventoryItem* item = item_symbol < world->inventory_items_count ? &world->inventory_items[item_symbol] : NULL;
+        
+        const char* matched = k % 2 && item && item->name ? item->name : item_id;
+        if (!name_matches_token(matched, &token)) continue;
+        
+        if (!item || !item->takeable) {
+            game_message(game, "You can't take that.\n");
+            return false;
         }
+        // The item leaves the room for this session only
+        LocationDelta* changed = touch_location(game, game->player.current_location_index);
+        if (!changed) return false;
+        if (!changed->taken) {
+            changed->taken = calloc(BITSET_WORDS(location->items_count), sizeof(unsigned int));
+            if (!changed->taken) {
+                printf("Error: Could not allocate location state\n");
+                return false;
+            }
+        }
+        if (!add_item_to_inventory(game, item_id)) return false;
+        BIT_SET(changed->taken, i);
+        
+        game_message(game, "You take the %s.\n", item->name);
+        return true;
     }
     
-    // Add new player flag if there's space
-    if (game->player.flags_count < MAX_FLAGS) {
-        safe_strcpy(game->player.flags[game->player.flags_count], flag_name,
-                   sizeof(game->player.flags[game->player.flags_count]));
-        game->player.flag_values[game->player.flags_count] = value;
-        game->player.flags_count++;
+    game_message(game, "There is no %s here.\n", item_name);
+    return false;
+}
+
+void describe_inventory(GameState* game) {
+    if (!game) return;
+    
+    if (game->player.inventory_count == 0) {
+        game_message(game, "You are carrying nothing.\n");
+        return;
+    }
+    
+    const World* world = game->world;
+    game_message(game, "You are carrying:\n");
+    for (int symbol = 0; symbol < world->item_symbols.count; symbol++) {
+        if (!BIT_TEST(game->player.inventory, symbol)) continue;
+        
+        // Items picked up by id alone have no definition to name them
+        const char* name = symbol < world->inventory_items_count ? world->inventory_items[symbol].name
+                                                                 : symbol_name(&world->item_symbols, symbol);
+        game_message(game, "  %s\n", name);
     }
 }
 
-bool check_location_requirements(GameState* game, Location* location) {
-    if (!game || !location) return true; // No requirements means accessible
+// Title, description and exits of the current location, for text frontends
+void describe_location(GameState* game) {
+    const Location* location = get_current_location(game);
+    if (!location) return;
     
-    // Check all required flags
-    for (int i = 0; i < location->flags_required_count; i++) {
-        bool flag_value = get_flag(game, location->flags_required[i]);
-        if (flag_value != location->flags_required_values[i]) {
-            return false; // Requirement not met
+    game_message(game, "%s\n", location->title);
+    // Descriptions can outgrow GAME_MESSAGE_LENGTH, so send them in pieces
+    const char* description = location->description ? location->description : "";
+    size_t length = strlen(description);
+    for (size_t offset = 0; offset < length; offset += GAME_MESSAGE_LENGTH - 1) {
+        game_message(game, "%.*s", GAME_MESSAGE_LENGTH - 1, description + offset);
+    }
+    game_message(game, "\n");
+    
+    if (location->exits_count > 0) {
+        game_message(game, "Exits:");
+        for (int i = 0; i < location->exits_count; i++) {
+            game_message(game, "%s %s", i > 0 ? "," : "", location->exits[i].direction);
         }
+        game_message(game, "\n");
+    }
+}
+
+// Verb handlers, dispatched by execute_command through command_handlers
+typedef CommandResult (*CommandHandler)(GameState* game, const ParsedCommand* command);
+
+static CommandResult run_unknown(GameState* game, const ParsedCommand* command) {
+    game_message(game, "Unknown command: %s\n", command->text);
+    return (CommandResult){COMMAND_UNKNOWN, false};
+}
+
+static CommandResult run_go(GameState* game, const ParsedCommand* command) {
+    if (command->object[0] == '\0') {
+        game_message(game, "Go where?\n");
+        return (CommandResult){COMMAND_MOVE, false};
     }
+    return (CommandResult){COMMAND_MOVE, move_in_direction(game, command->direction, command->object)};
+}
+
+static CommandResult run_take(GameState* game, const ParsedCommand* command) {
+    if (command->object[0] == '\0') {
+        game_message(game, "Take what?\n");
+        return (CommandResult){COMMAND_TAKE, false};
+    }
+    return (CommandResult){COMMAND_TAKE, take_item(game, command->object)};
+}
+
+static CommandResult run_look(GameState* game, const ParsedCommand* command) {
+    (void)game;
+    (void)command;
+    return (CommandResult){COMMAND_LOOK, false};
+}
+
+static CommandResult run_inventory(GameState* game, const ParsedCommand* command) {
+    (void)command;
+    describe_inventory(game);
+    return (CommandResult){COMMAND_INVENTORY, false};
+}
+
+static CommandResult run_help(GameState* game, const ParsedCommand* command) {
+    (void)command;
+    game_message(game, "Available commands: go <direction>, take <item>, look, inventory, help, quit\n");
+    game_message(game, "Directions can be shortened (n, s, e, w, ne, nw, se, sw, u, d) and typed on their own.\n");
+    return (CommandResult){COMMAND_HELP, false};
+}
+
+static CommandResult run_quit(GameState* game, const ParsedCommand* command) {
+    (void)game;
+    (void)command;
+    return (CommandResult){COMMAND_QUIT, false};
+}
+
+static const CommandHandler command_handlers[VERB_COUNT] = {
+    [VERB_NONE] = run_unknown,
+    [VERB_GO] = run_go,
+    [VERB_TAKE] = run_take,
+    [VERB_LOOK] = run_look,
+    [VERB_INVENTORY] = run_inventory,
+    [VERB_HELP] = run_help,
+    [VERB_QUIT] = run_quit,
+};
+
+// Parse and run one line of player input
+CommandResult execute_command(GameState* game, const char* input) {
+    CommandResult result = {COMMAND_UNKNOWN, false};
+    if (!game || !input) return result;
+    game->tick++;
+    
+    long long start = profile_begin();
+    ParsedCommand command;
+    parse_command(input, &command);
+    result = command_handlers[command.verb](game, &command);
+    profile_end(PROFILE_EXECUTE_COMMAND, start);
+    return result;
+}
+
+// Where a session's bytes go, for sizing deployments and checking the arena's fit
+EngineMemoryStats engine_memory_stats(const GameState* game) {
+    EngineMemoryStats stats;
+    memset(&stats, 0, sizeof(stats));
+    if (!game) return stats;
     
-    return true; // All requirements met
-} 
\ No newline at end of file
+    // Mirrors allocate_world and the loaders; the symbol tables keep the capacities the arena was sized for
+    const World* world = game->world;
+    int location_capacity = world->location_symbols.capacity;
+    stats.locations = ARENA_ALIGN(location_capacity * sizeof(Location));
+    for (int i = 0; i < world->locations_count; i++) {
+        // A merged world's exits and item lists stay in its regions' arenas
+        const Location* location = &world->locations[i];
+        stats.locations += (location->flags_required_count + location->flags_set_count) * sizeof(FlagTerm);
+        if (world->regions_count == 0) {
+            stats.locations += location->exits_count * sizeof(Exit) + location->items_count * sizeof(int);
+        }
+    }
+    if (world->text_offsets) stats.locations += ARENA_ALIGN(location_capacity * sizeof(long));
+    
+    stats.items = ARENA_ALIGN(world->inventory_items_count * sizeof(InventoryItem));
+    stats.flags = symbol_table_size(world->flag_symbols.capacity) +
+                  2 * ARENA_ALIGN(world->flag_words * sizeof(unsigned int));
+    stats.symbols = symbol_table_size(location_capacity) + symbol_table_size(world->item_symbols.capacity) +
+                    ARENA_ALIGN(world->item_words * sizeof(unsigned int));
+    
+    WorldSizes graph_sizes = {0};
+    graph_sizes.locations = location_capacity;
+    graph_sizes.flag_names = world->flag_symbols.capacity;
+    graph_sizes.exits = world->graph.edges_capacity;
+    stats.graph = world_graph_size(&graph_sizes);
+    stats.names = name_index_size(location_capacity, world->names.keys_capacity);
+    
+    stats.arena_used = world->arena.used;
+    stats.arena_reserved = world->arena.size;
+    size_t records = stats.locations + stats.items + stats.flags + stats.symbols + stats.graph + stats.names;
+    stats.strings = stats.arena_used > records ? stats.arena_used - records : 0;
+    stats.mapped = world->mapping_size;
+    stats.load_peak = world->load_peak;
+    for (int i = 0; i < world->regions_count; i++) {
+        stats.regions += world->regions[i]->arena.size;
+    }
+    
+    stats.session = session_size(world);
+    const LocationOverlay* overlay = &game->overlay;
+    stats.overlay = overlay->capacity * sizeof(LocationDelta);
+    for (int i = 0; i < overlay->capacity; i++) {
+        const LocationDelta* delta = &overlay->deltas[i];
+        if (delta->location == INVALID_LOCATION || !delta->taken) continue;
+        stats.overlay += BITSET_WORDS(world->locations[delta->location].items_count) * sizeof(unsigned int);
+    }
+    stats.route_cache = route_cache_bytes(game->routes, world);
+    stats.text_cache = location_text_cache_bytes(game->text);
+    
+    stats.total = stats.arena_reserved + stats.regions + stats.session + stats.overlay + stats.route_cache + stats.text_cache;
+    return stats;
+}
+
+static const char* format_bytes(char* text, size_t size, size_t bytes) {
+    if (bytes < 1024) {
+        snprintf(text, size, "%zu bytes", bytes);
+    } else if (bytes < 1024 * 1024) {
+        snprintf(text, size, "%.1f KiB", bytes / 1024.0);
+    } else {
+        snprintf(text, size, "%.1f MiB", bytes / (1024.0 * 1024.0));
+    }
+    return text;
+}
+
+void print_memory_stats(const EngineMemoryStats* stats) {
+    char a[32], b[32], c[32], d[32], e[32], f[32], g[32];
+    printf("Memory: %s on the heap, load peak %s\n", format_bytes(a, sizeof(a), stats->total),
+           format_bytes(b, sizeof(b), stats->load_peak));
+    printf("  World arena: %s used of %s reserved\n", format_bytes(a, sizeof(a), stats->arena_used),
+           format_bytes(b, sizeof(b), stats->arena_reserved));
+    printf("  Locations %s, items %s, flags %s, symbols %s, graph %s, names %s, strings %s\n",
+           format_bytes(a, sizeof(a), stats->locations), format_bytes(b, sizeof(b), stats->items),
+           format_bytes(c, sizeof(c), stats->flags), format_bytes(d, sizeof(d), stats->symbols),
+           format_bytes(e, sizeof(e), stats->graph), format_bytes(f, sizeof(f), stats->names),
+           format_bytes(g, sizeof(g), stats->strings));
+    if (stats->regions > 0) {
+        printf("  Region arenas: %s, holding the merged world's strings, exits and item lists\n",
+               format_bytes(a, sizeof(a), stats->regions));
+    }
+    if (stats->mapped > 0) {
+        printf("  Game file mapping: %s, file-backed\n", format_bytes(a, sizeof(a), stats->mapped));
+    }
+    printf("  Session %s, location deltas %s, route cache %s, text cache %s\n",
+           format_bytes(a, sizeof(a), stats->session), format_bytes(b, sizeof(b), stats->overlay),
+           format_bytes(c, sizeof(c), stats->route_cache), format_bytes(d, sizeof(d), stats->text_cache));
+}
@@ -2,98 +2,322 @@
 #define ADVENTURE_ENGINE_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include "arena.h"
+#include "command_parser.h"
+#include "name_match.h"
 
-#define MAX_STRING_LENGTH 256
-#define MAX_DESCRIPTION_LENGTH 1024
-#define MAX_EXITS 8
-#define MAX_ITEMS 32
-#define MAX_LOCATIONS 256
-#define MAX_INVENTORY_ITEMS 64
-#define MAX_FLAGS 128
+#define GAME_MESSAGE_LENGTH 512
+
+#define INVALID_SYMBOL -1
+#define INVALID_LOCATION INVALID_SYMBOL
+
+// Bitsets indexed by symbol
+#define BITSET_WORDS(bits) (((bits) + 31) / 32)
+#define BIT_TEST(set, bit) (((set)[(bit) >> 5] >> ((bit) & 31)) & 1u)
+#define BIT_SET(set, bit) ((set)[(bit) >> 5] |= (1u << ((bit) & 31)))
+#define BIT_CLEAR(set, bit) ((set)[(bit) >> 5] &= ~(1u << ((bit) & 31)))
+
+// Interned identifiers: each distinct name maps to a dense id in insertion order
+typedef struct {
+    const char** names;
+    int count;
+    int capacity;
+    int* slots; // Symbol id + 1, 0 marks an empty slot
+    unsigned int slot_mask; // Slot count - 1 (power of two, >= 2 * capacity)
+} SymbolTable;
 
 typedef struct {
-    char direction[32];
-    char target_location[64];
+    const char* direction;
+    const char* target_location;
+    int target_index; // Resolved at load time, INVALID_LOCATION if the target does not exist
+    Direction direction_id; // Resolved at load time, DIRECTION_NONE for directions matched by name
 } Exit;
 
+// One flag word of a compiled flags_required or flags_set condition. A condition
+// is the handful of terms for the words it names, so testing or applying it
+// costs the same however many flags the world has.
+typedef struct {
+    int word; // Index into flag bitsets
+    unsigned int mask; // Flags the condition names in that word
+    unsigned int values; // Their required or assigned values, a subset of mask
+} FlagTerm;
+
 typedef struct {
-    char id[64];
-    char title[MAX_STRING_LENGTH];
-    char description[MAX_DESCRIPTION_LENGTH];
-    char image_path[MAX_STRING_LENGTH];
-    char first_visit_text[MAX_DESCRIPTION_LENGTH];
-    bool visited;
+    const char* id;
+    const char* title;
+    const char* description;
+    const char* image_path;
+    const char* first_visit_text;
+    bool visited; // Authored starting value; sessions track their own
     
-    Exit exits[MAX_EXITS];
+    Exit* exits;
     int exits_count;
     
-    char items[MAX_ITEMS][64];
+    int* items; // Item symbols
     int items_count;
     
-    // Game flags (simplified for now)
-    char flags_required[MAX_FLAGS][64];
-    bool flags_required_values[MAX_FLAGS];
+    // Flag requirements for entering and effects of entering, compiled at load time
+    FlagTerm* flags_required;
     int flags_required_count;
     
-    char flags_set[MAX_FLAGS][64];
-    bool flags_set_values[MAX_FLAGS];
+    FlagTerm* flags_set;
     int flags_set_count;
 } Location;
 
 typedef struct {
-    char id[64];
-    char name[MAX_STRING_LENGTH];
-    char description[MAX_DESCRIPTION_LENGTH];
+    const char* id;
+    const char* name;
+    const char* description;
     bool takeable;
     bool useable;
-    char use_text[MAX_DESCRIPTION_LENGTH];
+    const char* use_text;
 } InventoryItem;
 
 typedef struct {
-    char title[MAX_STRING_LENGTH];
-    char author[MAX_STRING_LENGTH];
-    char description[MAX_DESCRIPTION_LENGTH];
-    char version[32];
+    const char* title;
+    const char* author;
+    const char* description;
+    const char* version;
 } GameMeta;
 
+// Exits as a compressed sparse row graph over location indices, built once at
+// load time: location i leads to targets[offsets[i]] .. targets[offsets[i + 1] - 1].
+// Exits to missing locations are left out.
 typedef struct {
-    char inventory[MAX_INVENTORY_ITEMS][64];
+    int* offsets; // locations_count + 1 entries
+    int* targets;
+    int edges_count;
+    int edges_capacity; // Exits the loader sized targets for
+    unsigned int* gated; // Bit per location that has flags_required
+    unsigned int* gate_flags; // Every flag some location requires, over flag symbols
+} WorldGraph;
+
+typedef struct {
+    unsigned int* inventory; // Bitmap over item symbols
     int inventory_count;
-    char current_location[64];
+    int current_location_index; // Cached index into World.locations
     
-    char flags[MAX_FLAGS][64];
-    bool flag_values[MAX_FLAGS];
-    int flags_count;
+    unsigned int* flags; // Effective flag values (game flags overridden by player flags)
 } Player;
 
-typedef struct {
+// Authored game data. Nothing changes it once loaded, so any number of
+// sessions can share one world.
+typedef struct World {
+    Arena arena; // Holds this struct and everything it points to
+    
+    // Read-only file mapping: the bundle that strings point into, or the JSON
+    // source that lazily loaded location text is decoded from
+    void* mapping;
+    size_t mapping_size;
+    long* text_offsets; // Lazy text only: file offset of each location's object, else NULL
+    size_t load_peak; // Most heap the loader held at once, the arena included
+    unsigned int fingerprint; // Hash of the symbol names, see world_fingerprint
+    
     GameMeta meta;
-    char start_location[64];
+    const char* start_location;
     
-    Location locations[MAX_LOCATIONS];
+    Location* locations;
     int locations_count;
     
-    InventoryItem inventory_items[MAX_INVENTORY_ITEMS];
+    InventoryItem* inventory_items;
     int inventory_items_count;
     
-    char game_flags[MAX_FLAGS][64];
-    bool game_flag_values[MAX_FLAGS];
-    int game_flags_count;
+    // Symbol ids of locations and defined items match their array indices
+    SymbolTable location_symbols;
+    SymbolTable item_symbols;
+    SymbolTable flag_symbols;
+    int flag_words; // Words per flag bitset
+    int item_words; // Words per item bitset
     
+    unsigned int* game_flags; // Authored game_flags defaults
+    
+    Player start; // Player state new sessions begin with
+    
+    WorldGraph graph;
+    NameIndex names; // Exit direction and item keys per location, for matching command words
+    
+    // Worlds loaded from a region manifest keep each region's own world, whose
+    // arenas hold the strings, exits and item lists the merged records point to
+    struct World** regions;
+    int regions_count;
+} World;
+
+typedef void (*GameOutput)(void* context, const char* text);
+
+// LocationDelta.state bits
+#define LOCATION_VISITED 1u
+
+// Copy-on-write record of what one session changed at one location; locations
+// a session never touched have no delta and read straight from the world
+typedef struct {
+    int location; // Index into World.locations, INVALID_LOCATION marks an empty slot
+    unsigned int state; // LOCATION_* bits
+    unsigned int* taken; // Bit per entry of Location.items, NULL until one is taken
+} LocationDelta;
+
+// Per-session deltas, open-addressed by location index
+typedef struct {
+    LocationDelta* deltas;
+    int count;
+    int capacity; // Power of two, 0 until the first delta
+} LocationOverlay;
+
+// Route queries over the world graph for one session (see world_graph.c)
+typedef struct RouteCache RouteCache;
+
+// Decoded text of recently shown locations in a lazily loaded world (see location_text.c)
+typedef struct LocationTextCache LocationTextCache;
+
+// One player's mutable state over a shared world; the player's bitsets live in
+// the same allocation as the struct
+typedef struct {
+    const World* world;
     Player player;
+    LocationOverlay overlay;
+    unsigned int tick; // Inputs applied so far; execute_command counts each one
+    
+    RouteCache* routes; // NULL until the first route query
+    LocationTextCache* text; // NULL until location text is first decoded
+    unsigned int gate_version; // Bumped whenever a flag in graph.gate_flags changes
+    
+    bool owns_world; // Set by load_game: cleanup_game frees the world too
+    bool quiet; // Suppress player-facing messages, e.g. while benchmarking
+    GameOutput output; // Receives player-facing messages; NULL prints to stdout
+    void* output_context;
 } GameState;
 
+// Upper bounds gathered by a loader so the arena can be allocated once
+typedef struct {
+    size_t bytes; // Loader-specific allocations (strings, exits, item lists)
+    int locations;
+    int inventory_items;
+    int item_names; // Every item id occurrence, an upper bound on item symbols
+    int flag_names; // Every flag name occurrence, an upper bound on flag symbols
+    int exits;
+    int item_refs; // Entries of every location's item list
+    bool records_only; // A region merged into another world: no graph or name index of its own
+} WorldSizes;
+
+typedef enum {
+    COMMAND_UNKNOWN,
+    COMMAND_MOVE,
+    COMMAND_LOOK,
+    COMMAND_INVENTORY,
+    COMMAND_TAKE,
+    COMMAND_HELP,
+    COMMAND_QUIT
+} CommandType;
+
+typedef struct {
+    CommandType type;
+    bool succeeded; // The command changed game state (a move or take went through)
+} CommandResult;
+
+// Bytes behind one session and the world it plays in. The world categories
+// partition the arena's used bytes; total is everything on the heap.
+typedef struct {
+    size_t locations; // Location records, exits, item lists, flag terms and lazy text offsets
+    size_t items; // Inventory item records
+    size_t flags; // Flag symbol table and the default and starting flag bitsets
+    size_t symbols; // Location and item symbol tables and the starting inventory bitmap
+    size_t graph; // Compiled exit graph
+    size_t names; // Name index of exit directions and items
+    size_t strings; // Ids and text copied into the arena, plus alignment padding
+    size_t regions; // Arenas of the regions a manifest world was merged from
+    size_t arena_used;
+    size_t arena_reserved; // Sized once from the loader's upper bounds
+    size_t mapped; // Game file mapping strings or lazy text are read from; file-backed, not heap
+    size_t load_peak; // Most heap the loader held at once
+    
+    size_t session; // GameState and the player's bitsets
+    size_t overlay; // Per-location deltas
+    size_t route_cache;
+    size_t text_cache; // Decoded location text of a lazily loaded world
+    size_t total;
+} EngineMemoryStats;
+
+// Inverted index over location titles, descriptions and first visit text and
+// item names, descriptions and use text (see search_index.c). Built once per
+// world and read-only afterwards, so sessions on any thread can share it.
+typedef struct SearchIndex SearchIndex;
+
+typedef enum {
+    SEARCH_LOCATION,
+    SEARCH_ITEM
+} SearchHitType;
+
+typedef struct {
+    SearchHitType type;
+    int index; // Into World.locations or World.inventory_items
+} SearchHit;
+
+typedef struct {
+    int documents; // Locations and items indexed
+    int terms; // Distinct words
+    long postings; // Word and document pairs
+    size_t postings_bytes; // Their compressed size
+    size_t bytes; // Everything the index holds
+} SearchIndexStats;
+
 // Function declarations
+bool symbol_table_init(SymbolTable* table, Arena* arena, int capacity);
+int symbol_intern(SymbolTable* table, Arena* arena, const char* name);
+int symbol_intern_static(SymbolTable* table, const char* name);
+int symbol_lookup(const SymbolTable* table, const char* name);
+const char* symbol_name(const SymbolTable* table, int symbol);
+size_t symbol_table_size(int capacity);
+
+void world_sizes_finish(WorldSizes* sizes);
+World* allocate_world(const WorldSizes* sizes);
+void resolve_exits(World* world);
+// FNV-1a over the location ids, then the item and flag names, in symbol order;
+// snapshots record it so a save never restores into a world whose ids moved
+unsigned int world_fingerprint(const World* world);
+World* load_region_world(const char* filename); // One JSON file as is, ignoring any "regions" list
+
+World* load_world(const char* filename);
+World* load_world_lazy(const char* filename);
+void cleanup_world(World* world);
+size_t session_size(const World* world);
+GameState* create_session(const World* world);
+void cleanup_session(GameState* game);
+
 GameState* load_game(const char* filename);
+GameState* load_game_lazy(const char* filename);
 void cleanup_game(GameState* game);
-Location* get_location_by_id(GameState* game, const char* location_id);
-Location* get_current_location(GameState* game);
+int get_location_index(GameState* game, const char* location_id);
+const Location* get_location_by_id(GameState* game, const char* location_id);
+const Location* get_current_location(GameState* game);
 bool move_player(GameState* game, const char* direction);
 bool has_item(GameState* game, const char* item_id);
+bool has_item_symbol(GameState* game, int item_symbol);
 bool add_item_to_inventory(GameState* game, const char* item_id);
 bool remove_item_from_inventory(GameState* game, const char* item_id);
 bool get_flag(GameState* game, const char* flag_name);
+bool get_flag_symbol(GameState* game, int flag_symbol);
 void set_flag(GameState* game, const char* flag_name, bool value);
-bool check_location_requirements(GameState* game, Location* location);
+void set_flag_symbol(GameState* game, int flag_symbol, bool value);
+int add_flag_term(FlagTerm* terms, int count, int flag_symbol, bool value);
+bool check_location_requirements(GameState* game, const Location* location);
+bool location_visited(GameState* game, int location_index);
+LocationDelta* find_location_delta(const GameState* game, int location_index);
+LocationDelta* touch_location(GameState* game, int location_index);
+bool reserve_location_deltas(GameState* game, int count);
+bool take_item(GameState* game, const char* item_name);
+void describe_inventory(GameState* game);
+void describe_location(GameState* game);
+CommandResult execute_command(GameState* game, const char* input);
+EngineMemoryStats engine_memory_stats(const GameState* game);
+void print_memory_stats(const EngineMemoryStats* stats);
+
+// Words are runs of ASCII letters and digits or UTF-8 bytes, matched without
+// regard to ASCII case. search_world finds the documents holding every word of
+// the query, locations first, writes up to max_hits of them and returns how
+// many there are.
+SearchIndex* build_search_index(const World* world);
+int search_world(const SearchIndex* index, const char* query, SearchHit* hits, int max_hits);
+SearchIndexStats search_index_stats(const SearchIndex* index);
+void free_search_index(SearchIndex* index);
 
-#endif // ADVENTURE_ENGINE_H 
\ No newline at end of file
+#endif // ADVENTURE_ENGINE_H
@@ -0,0 +1,40 @@
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+bool arena_init(Arena* arena, size_t size) {
+    arena->base = calloc(1, size);
+    arena->size = arena->base ? size : 0;
+    arena->used = 0;
+    return arena->base != NULL;
+}
+
+void* arena_alloc(Arena* arena, size_t bytes) {
+    size_t aligned = ARENA_ALIGN(bytes);
+    if (!arena->base || aligned > arena->size - arena->used) {
+        return NULL;
+    }
+    
+    // Memory comes from calloc, so every allocation starts zeroed
+    void* ptr = arena->base + arena->used;
+    arena->used += aligned;
+    return ptr;
+}
+
+char* arena_strdup(Arena* arena, const char* str) {
+    if (!str) str = "";
+    
+    size_t length = strlen(str) + 1;
+    char* copy = arena_alloc(arena, length);
+    if (copy) {
+        memcpy(copy, str, length);
+    }
+    return copy;
+}
+
+void arena_free(Arena* arena) {
+    free(arena->base);
+    arena->base = NULL;
+    arena->size = 0;
+    arena->used = 0;
+}
@@ -0,0 +1,24 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ARENA_ALIGNMENT 8
+
+// Rounds a request up to the arena's allocation granularity
+#define ARENA_ALIGN(bytes) (((bytes) + (ARENA_ALIGNMENT - 1)) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+// Bump allocator: one block, never freed piecemeal
+typedef struct {
+    char* base;
+    size_t size;
+    size_t used;
+} Arena;
+
+bool arena_init(Arena* arena, size_t size);
+void* arena_alloc(Arena* arena, size_t bytes);
+char* arena_strdup(Arena* arena, const char* str);
+void arena_free(Arena* arena);
+
+#endif // ARENA_H
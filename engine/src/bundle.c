@@ -0,0 +1,377 @@
+#include "bundle.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Validated view over a mapped bundle
+typedef struct {
+    const char* data;
+    size_t size;
+    BundleHeader header; // Host byte order copy
+    const char* strings;
+    uint32_t strings_size;
+} BundleView;
+
+// Bundle fields are little-endian on disk
+static uint32_t bundle_u32(uint32_t value) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap32(value);
+#else
+    return value;
+#endif
+}
+
+// Check that count records of record_size bytes at offset lie inside the file
+static bool table_fits(const BundleView* view, uint32_t offset, uint32_t count, size_t record_size) {
+    if (offset > view->size) return false;
+    return count <= (view->size - offset) / record_size;
+}
+
+// Check that [first, first + count) lies inside a table of total records
+static bool range_fits(uint32_t first, uint32_t count, uint32_t total) {
+    return first <= total && count <= total - first;
+}
+
+static const char* bundle_string(const BundleView* view, uint32_t offset) {
+    offset = bundle_u32(offset);
+    if (offset >= view->strings_size) return "";
+    return view->strings + offset;
+}
+
+static const void* bundle_table(const BundleView* view, uint32_t offset) {
+    return view->data + offset;
+}
+
+bool is_bundle_file(const char* filename) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) return false;
+    
+    char magic[4];
+    bool is_bundle = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                     memcmp(magic, BUNDLE_MAGIC, sizeof(magic)) == 0;
+    fclose(file);
+    return is_bundle;
+}
+
+// Map the whole file read-only (read into memory where mmap is unavailable)
+void* map_file(const char* filename, size_t* size) {
+#ifdef _WIN32
+    FILE* file = fopen(filename, "rb");
+    if (!file) return NULL;
+    
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    
+    void* data = file_size > 0 ? malloc(file_size) : NULL;
+    if (data && fread(data, 1, file_size, file) != (size_t)file_size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    
+    *size = data ? (size_t)file_size : 0;
+    return data;
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return NULL;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+    
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return NULL;
+    
+    *size = st.st_size;
+    return data;
+#endif
+}
+
+void unmap_file(void* mapping, size_t size) {
+#ifdef _WIN32
+    (void)size;
+    free(mapping);
+#else
+    munmap(mapping, size);
+#endif
+}
+
+// Validate the header and every table against the file size
+static bool validate_bundle(BundleView* view) {
+    if (view->size < sizeof(BundleHeader)) return false;
+    
+    const uint32_t* raw = (const uint32_t*)view->data;
+    uint32_t* header = (uint32_t*)&view->header;
+    memcpy(view->header.magic, view->data, sizeof(view->header.magic));
+    for (size_t i = 1; i < sizeof(BundleHeader) / sizeof(uint32_t); i++) {
+        header[i] = bundle_u32(raw[i]);
+    }
+    
+    const BundleHeader* h = &view->header;
+    if (memcmp(h->magic, BUNDLE_MAGIC, sizeof(h->magic)) != 0 || h->version != BUNDLE_VERSION) {
+        return false;
+    }
+    
+    if (!table_fits(view, h->string_pool_offset, h->string_pool_size, 1) ||
+        !table_fits(view, h->locations_offset, h->locations_count, sizeof(BundleLocation)) ||
+        !table_fits(view, h->exits_offset, h->exits_count, sizeof(BundleExit)) ||
+        !table_fits(view, h->item_refs_offset, h->item_refs_count, sizeof(uint32_t)) ||
+        !table_fits(view, h->items_offset, h->items_count, sizeof(BundleItem)) ||
+        !table_fits(view, h->item_names_offset, h->item_names_count, sizeof(uint32_t)) ||
+        !table_fits(view, h->flag_names_offset, h->flag_names_count, sizeof(uint32_t)) ||
+        !table_fits(view, h->flag_values_offset, h->flag_values_count, sizeof(BundleFlagValue))) {
+        return false;
+    }
+    
+    // Every string must terminate inside the pool
+    if (h->string_pool_size == 0 || view->data[h->string_pool_offset + h->string_pool_size - 1] != '\0') {
+        return false;
+    }
+    view->strings = view->data + h->string_pool_offset;
+    view->strings_size = h->string_pool_size;
+    
+    // Each defined item needs a matching item symbol
+    if (h->items_count > h->item_names_count) return false;
+    
+    // Tables are 4-byte aligned so records can be read in place
+    uint32_t offsets[] = {h->locations_offset, h->exits_offset, h->item_refs_offset, h->items_offset,
+                          h->item_names_offset, h->flag_names_offset, h->flag_values_offset};
+    for (size_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++) {
+        if (offsets[i] % sizeof(uint32_t) != 0) return false;
+    }
+    
+    return range_fits(h->game_flags_first, h->game_flags_count, h->flag_values_count) &&
+           range_fits(h->player_flags_first, h->player_flags_count, h->flag_values_count) &&
+           range_fits(h->player_inventory_first, h->player_inventory_count, h->item_refs_count) &&
+           (h->player_location == BUNDLE_NONE || h->player_location < h->locations_count);
+}
+
+// Intern every name in a string offset table, which must produce dense symbols
+static bool intern_bundle_names(const BundleView* view, SymbolTable* table, uint32_t offset, uint32_t count) {
+    const uint32_t* names = bundle_table(view, offset);
+    for (uint32_t i = 0; i < count; i++) {
+        if (symbol_intern_static(table, bundle_string(view, names[i])) != (int)i) {
+            return false; // Duplicate name
+        }
+    }
+    return true;
+}
+
+// Apply a range of flag values to a flag bitset
+static void apply_bundle_flags(const BundleView* view, World* world, unsigned int* flags,
+                               uint32_t first, uint32_t count) {
+    const BundleFlagValue* values = bundle_table(view, view->header.flag_values_offset);
+    for (uint32_t i = first; i < first + count; i++) {
+        uint32_t flag = bundle_u32(values[i].flag);
+        if (flag >= (uint32_t)world->flag_symbols.count) continue;
+        
+        if (bundle_u32(values[i].value)) {
+            BIT_SET(flags, flag);
+        } else {
+            BIT_CLEAR(flags, flag);
+        }
+    }
+}
+
+// Compile a range of flag values into flag terms carved from the arena;
+// terms stays NULL for an empty range
+static bool compile_bundle_condition(const BundleView* view, World* world, uint32_t first, uint32_t count,
+                                     FlagTerm** terms, int* terms_count) {
+    *terms = NULL;
+    *terms_count = 0;
+    if (count == 0) return true;
+    if (!range_fits(first, count, view->header.flag_values_count)) return false;
+    
+    // At most one term per flag value
+    *terms = arena_alloc(&world->arena, count * sizeof(FlagTerm));
+    if (!*terms) return false;
+    
+    const BundleFlagValue* values = bundle_table(view, view->header.flag_values_offset);
+    for (uint32_t i = first; i < first + count; i++) {
+        uint32_t flag = bundle_u32(values[i].flag);
+        if (flag >= (uint32_t)world->flag_symbols.count) continue;
+        *terms_count = add_flag_term(*terms, *terms_count, (int)flag, bundle_u32(values[i].value) != 0);
+    }
+    return true;
+}
+
+// Arena bytes for every location's flag terms. Ranges that do not fit count as
+// empty; populate_world rejects them.
+static size_t bundle_condition_bytes(const BundleView* view) {
+    const BundleLocation* records = bundle_table(view, view->header.locations_offset);
+    uint32_t limit = view->header.flag_values_count;
+    size_t bytes = 0;
+    for (uint32_t i = 0; i < view->header.locations_count; i++) {
+        uint32_t required = bundle_u32(records[i].flags_required_count);
+        uint32_t set = bundle_u32(records[i].flags_set_count);
+        if (required <= limit) bytes += ARENA_ALIGN(required * sizeof(FlagTerm));
+        if (set <= limit) bytes += ARENA_ALIGN(set * sizeof(FlagTerm));
+    }
+    return bytes;
+}
+
+static bool populate_world(const BundleView* view, World* world) {
+    const BundleHeader* h = &view->header;
+    Arena* arena = &world->arena;
+    
+    if (!intern_bundle_names(view, &world->item_symbols, h->item_names_offset, h->item_names_count) ||
+        !intern_bundle_names(view, &world->flag_symbols, h->flag_names_offset, h->flag_names_count)) {
+        return false;
+    }
+    
+    world->meta.title = bundle_string(view, h->meta_title);
+    world->meta.author = bundle_string(view, h->meta_author);
+    world->meta.description = bundle_string(view, h->meta_description);
+    world->meta.version = bundle_string(view, h->meta_version);
+    world->start_location = bundle_string(view, h->start_location);
+    
+    // Item symbols referenced by locations and the inventory, widened once
+    const uint32_t* item_refs = bundle_table(view, h->item_refs_offset);
+    int* items = arena_alloc(arena, h->item_refs_count * sizeof(int));
+    for (uint32_t i = 0; i < h->item_refs_count; i++) {
+        uint32_t item = bundle_u32(item_refs[i]);
+        if (item >= h->item_names_count) return false;
+        items[i] = (int)item;
+    }
+    
+    const BundleExit* bundle_exits = bundle_table(view, h->exits_offset);
+    Exit* exits = arena_alloc(arena, h->exits_count * sizeof(Exit));
+    for (uint32_t i = 0; i < h->exits_count; i++) {
+        uint32_t target_index = bundle_u32(bundle_exits[i].target_index);
+        exits[i].direction = bundle_string(view, bundle_exits[i].direction);
+        exits[i].target_location = bundle_string(view, bundle_exits[i].target_location);
+        exits[i].target_index = target_index < h->locations_count ? (int)target_index : INVALID_LOCATION;
+        exits[i].direction_id = parse_direction(exits[i].direction);
+    }
+    
+    const BundleLocation* bundle_locations = bundle_table(view, h->locations_offset);
+    for (uint32_t i = 0; i < h->locations_count; i++) {
+        const BundleLocation* record = &bundle_locations[i];
+        Location* location = &world->locations[i];
+        
+        location->id = bundle_string(view, record->id);
+        if (symbol_intern_static(&world->location_symbols, location->id) != (int)i) {
+            return false; // Duplicate location id
+        }
+        
+        location->title = bundle_string(view, record->title);
+        location->description = bundle_string(view, record->description);
+        location->image_path = bundle_string(view, record->image);
+        location->first_visit_text = bundle_string(view, record->first_visit_text);
+        location->visited = bundle_u32(record->visited) != 0;
+        
+        uint32_t exits_first = bundle_u32(record->exits_first);
+        uint32_t exits_count = bundle_u32(record->exits_count);
+        uint32_t items_first = bundle_u32(record->items_first);
+        uint32_t items_count = bundle_u32(record->items_count);
+        if (!range_fits(exits_first, exits_count, h->exits_count) ||
+            !range_fits(items_first, items_count, h->item_refs_count)) {
+            return false;
+        }
+        
+        location->exits = exits + exits_first;
+        location->exits_count = exits_count;
+        location->items = items + items_first;
+        location->items_count = items_count;
+        
+        if (!compile_bundle_condition(view, world, bundle_u32(record->flags_required_first),
+                                      bundle_u32(record->flags_required_count), &location->flags_required,
+                                      &location->flags_required_count) ||
+            !compile_bundle_condition(view, world, bundle_u32(record->flags_set_first),
+                                      bundle_u32(record->flags_set_count), &location->flags_set,
+                                      &location->flags_set_count)) {
+            return false;
+        }
+    }
+    world->locations_count = h->locations_count;
+    
+    const BundleItem* bundle_items = bundle_table(view, h->items_offset);
+    for (uint32_t i = 0; i < h->items_count; i++) {
+        InventoryItem* item = &world->inventory_items[i];
+        uint32_t attributes = bundle_u32(bundle_items[i].attributes);
+        
+        item->id = symbol_name(&world->item_symbols, i);
+        item->name = bundle_string(view, bundle_items[i].name);
+        item->description = bundle_string(view, bundle_items[i].description);
+        item->use_text = bundle_string(view, bundle_items[i].use_text);
+        item->takeable = (attributes & BUNDLE_ITEM_TAKEABLE) != 0;
+        item->useable = (attributes & BUNDLE_ITEM_USEABLE) != 0;
+    }
+    world->inventory_items_count = h->items_count;
+    
+    // Player flags override the game flag defaults
+    apply_bundle_flags(view, world, world->game_flags, h->game_flags_first, h->game_flags_count);
+    memcpy(world->start.flags, world->game_flags, world->flag_words * sizeof(unsigned int));
+    apply_bundle_flags(view, world, world->start.flags, h->player_flags_first, h->player_flags_count);
+    
+    for (uint32_t i = h->player_inventory_first; i < h->player_inventory_first + h->player_inventory_count; i++) {
+        if (!BIT_TEST(world->start.inventory, items[i])) {
+            BIT_SET(world->start.inventory, items[i]);
+            world->start.inventory_count++;
+        }
+    }
+    
+    world->start.current_location_index = h->player_location != BUNDLE_NONE
+        ? (int)h->player_location
+        : symbol_lookup(&world->location_symbols, world->start_location);
+    
+    return true;
+}
+
+World* load_bundle(const char* filename) {
+    BundleView view = {0};
+    void* mapping = map_file(filename, &view.size);
+    if (!mapping) {
+        printf("Error: Could not open file %s\n", filename);
+        return NULL;
+    }
+    view.data = mapping;
+    
+    if (!validate_bundle(&view)) {
+        printf("Error: Invalid or unsupported game bundle %s\n", filename);
+        unmap_file(mapping, view.size);
+        return NULL;
+    }
+    
+    // Strings stay in the mapping; the arena holds only the record arrays
+    WorldSizes sizes = {0};
+    sizes.locations = view.header.locations_count;
+    sizes.inventory_items = view.header.items_count;
+    sizes.item_names = view.header.item_names_count;
+    sizes.flag_names = view.header.flag_names_count;
+    sizes.bytes = ARENA_ALIGN(view.header.exits_count * sizeof(Exit)) +
+                  ARENA_ALIGN(view.header.item_refs_count * sizeof(int));
+    sizes.bytes += bundle_condition_bytes(&view);
+    sizes.exits = view.header.exits_count;
+    sizes.item_refs = view.header.item_refs_count;
+    world_sizes_finish(&sizes);
+    
+    World* world = allocate_world(&sizes);
+    if (!world) {
+        printf("Error: Could not allocate memory for game world\n");
+        unmap_file(mapping, view.size);
+        return NULL;
+    }
+    world->mapping = mapping;
+    world->mapping_size = view.size;
+    world->load_peak = world->arena.size;
+    
+    if (!populate_world(&view, world)) {
+        printf("Error: Corrupt game bundle %s\n", filename);
+        cleanup_world(world);
+        return NULL;
+    }
+    
+    return world;
+}
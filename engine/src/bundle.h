@@ -0,0 +1,71 @@
+#ifndef BUNDLE_H
+#define BUNDLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "adventure_engine.h"
+
+// Compiled .advgptb bundle, written by AdvGPTFormat.save_bundle in the editor.
+// Every field is a little-endian uint32; strings are offsets into a pool of
+// NUL-terminated strings, and ranges index into the shared tables below.
+#define BUNDLE_MAGIC "AGPB"
+#define BUNDLE_VERSION 1
+#define BUNDLE_NONE 0xFFFFFFFFu
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    
+    uint32_t string_pool_offset, string_pool_size;
+    uint32_t locations_offset, locations_count;
+    uint32_t exits_offset, exits_count;
+    uint32_t item_refs_offset, item_refs_count; // Item symbols for location items and the player inventory
+    uint32_t items_offset, items_count;
+    uint32_t item_names_offset, item_names_count; // One string per item symbol, defined items first
+    uint32_t flag_names_offset, flag_names_count; // One string per flag symbol
+    uint32_t flag_values_offset, flag_values_count;
+    
+    uint32_t meta_title, meta_author, meta_description, meta_version;
+    uint32_t start_location;
+    
+    uint32_t game_flags_first, game_flags_count;
+    uint32_t player_location; // Location index, BUNDLE_NONE for the start location
+    uint32_t player_inventory_first, player_inventory_count;
+    uint32_t player_flags_first, player_flags_count;
+} BundleHeader;
+
+typedef struct {
+    uint32_t id, title, description, image, first_visit_text;
+    uint32_t visited;
+    uint32_t exits_first, exits_count;
+    uint32_t items_first, items_count;
+    uint32_t flags_required_first, flags_required_count;
+    uint32_t flags_set_first, flags_set_count;
+} BundleLocation;
+
+typedef struct {
+    uint32_t direction;
+    uint32_t target_location;
+    uint32_t target_index; // BUNDLE_NONE if the target does not exist
+} BundleExit;
+
+#define BUNDLE_ITEM_TAKEABLE 1u
+#define BUNDLE_ITEM_USEABLE 2u
+
+typedef struct {
+    uint32_t id, name, description, use_text;
+    uint32_t attributes;
+} BundleItem;
+
+typedef struct {
+    uint32_t flag;
+    uint32_t value;
+} BundleFlagValue;
+
+bool is_bundle_file(const char* filename);
+World* load_bundle(const char* filename);
+void* map_file(const char* filename, size_t* size);
+void unmap_file(void* mapping, size_t size);
+
+#endif // BUNDLE_H
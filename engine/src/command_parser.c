@@ -0,0 +1,91 @@
+#include "command_parser.h"
+#include "command_words.h"
+#include <string.h>
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static unsigned char lower(unsigned char c) {
+    return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+#define FNV_PRIME 16777619u
+
+// Must match word_hash in tools/gen_command_words.py, whose find_seed picks the seed
+static unsigned int hash_step(unsigned int hash, char c) {
+    return (hash ^ lower((unsigned char)c)) * FNV_PRIME;
+}
+
+// The table is perfect, so only the word's own slot can hold it
+static const CommandWord* match_command_word(const char* word, size_t length, unsigned int hash) {
+    const CommandWord* entry = &command_words[hash >> (32 - COMMAND_WORD_SLOT_BITS)];
+    if (!entry->word || entry->length != length) return NULL;
+
+    for (size_t i = 0; i < length; i++) {
+        if (lower((unsigned char)word[i]) != (unsigned char)entry->word[i]) return NULL;
+    }
+    return entry;
+}
+
+// Case-insensitive
+const CommandWord* lookup_command_word(const char* word, size_t length) {
+    unsigned int hash = COMMAND_WORD_SEED;
+    for (size_t i = 0; i < length; i++) {
+        hash = hash_step(hash, word[i]);
+    }
+    return match_command_word(word, length, hash);
+}
+
+Direction parse_direction(const char* word) {
+    if (!word) return DIRECTION_NONE;
+    const CommandWord* entry = lookup_command_word(word, strlen(word));
+    return entry ? (Direction)entry->direction : DIRECTION_NONE;
+}
+
+// Splits "<verb> <object words>" and resolves the verb in one pass over the
+// line. A bare direction is short for "go <direction>". Returns false when
+// the line is not a command.
+bool parse_command(const char* input, ParsedCommand* command) {
+    command->verb = VERB_NONE;
+    command->direction = DIRECTION_NONE;
+    command->object[0] = '\0';
+    command->text = input;
+    if (!input) return false;
+
+    while (is_space(*input)) input++;
+    const char* word = input;
+    unsigned int hash = COMMAND_WORD_SEED;
+    while (*input && !is_space(*input)) {
+        hash = hash_step(hash, *input++);
+    }
+    size_t word_length = input - word;
+
+    // Object: the rest of the line with surrounding whitespace trimmed
+    while (is_space(*input)) input++;
+    size_t copied = 0;
+    size_t object_length = 0;
+    while (*input && copied < COMMAND_OBJECT_LENGTH - 1) {
+        char c = *input++;
+        command->object[copied++] = c;
+        if (!is_space(c)) object_length = copied;
+    }
+    command->object[object_length] = '\0';
+
+    const CommandWord* entry = match_command_word(word, word_length, hash);
+    if (!entry) return false;
+
+    if (entry->verb == VERB_GO) {
+        command->verb = VERB_GO;
+        const CommandWord* direction = lookup_command_word(command->object, object_length);
+        if (direction) command->direction = (Direction)direction->direction;
+    } else if (entry->verb != VERB_NONE) {
+        command->verb = (Verb)entry->verb;
+    } else if (object_length == 0) {
+        command->verb = VERB_GO;
+        command->direction = (Direction)entry->direction;
+        memcpy(command->object, word, word_length);
+        command->object[word_length] = '\0';
+    }
+    return command->verb != VERB_NONE;
+}
@@ -0,0 +1,58 @@
+#ifndef COMMAND_PARSER_H
+#define COMMAND_PARSER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define COMMAND_OBJECT_LENGTH 256
+
+typedef enum {
+    VERB_NONE, // Not a verb; unknown commands dispatch here too
+    VERB_GO,
+    VERB_TAKE,
+    VERB_LOOK,
+    VERB_INVENTORY,
+    VERB_HELP,
+    VERB_QUIT,
+    VERB_COUNT
+} Verb;
+
+typedef enum {
+    DIRECTION_NONE, // A direction the vocabulary does not know, matched by name
+    DIRECTION_NORTH,
+    DIRECTION_SOUTH,
+    DIRECTION_EAST,
+    DIRECTION_WEST,
+    DIRECTION_NORTHEAST,
+    DIRECTION_NORTHWEST,
+    DIRECTION_SOUTHEAST,
+    DIRECTION_SOUTHWEST,
+    DIRECTION_UP,
+    DIRECTION_DOWN,
+    DIRECTION_IN,
+    DIRECTION_OUT,
+    DIRECTION_COUNT
+} Direction;
+
+// Entry of the generated perfect-hash table in command_words.h
+typedef struct {
+    const char* word; // Lowercase
+    unsigned char length;
+    unsigned char verb;
+    unsigned char direction;
+} CommandWord;
+
+// One tokenized line of input. Nothing is allocated: the object is copied
+// into the struct, so it can live on the caller's stack.
+typedef struct {
+    Verb verb;
+    Direction direction; // The object of VERB_GO resolved, DIRECTION_NONE otherwise
+    char object[COMMAND_OBJECT_LENGTH]; // Words after the verb, trimmed; a bare direction's own word
+    const char* text; // The whole input line, for error messages
+} ParsedCommand;
+
+const CommandWord* lookup_command_word(const char* word, size_t length);
+Direction parse_direction(const char* word);
+bool parse_command(const char* input, ParsedCommand* command);
+
+#endif // COMMAND_PARSER_H
@@ -0,0 +1,73 @@
+#include "command_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Sequence numbers follow Vyukov's bounded queue: a slot at position p is free
+// for the producer of p while sequence == p, and holds that producer's command
+// once sequence == p + 1. The consumer frees it for position p + capacity.
+
+bool command_queue_init(CommandQueue* queue, size_t capacity) {
+    memset(queue, 0, sizeof(*queue));
+
+    size_t slots = 2;
+    while (slots < capacity) slots *= 2;
+
+    queue->slots = malloc(slots * sizeof(CommandSlot));
+    if (!queue->slots) {
+        printf("Error: Could not allocate command queue\n");
+        return false;
+    }
+    for (size_t i = 0; i < slots; i++) {
+        queue->slots[i].sequence = i;
+    }
+    queue->mask = slots - 1;
+    return true;
+}
+
+void command_queue_destroy(CommandQueue* queue) {
+    free(queue->slots);
+    memset(queue, 0, sizeof(*queue));
+}
+
+// Safe from any thread; returns false without blocking when the queue is full
+bool command_queue_push(CommandQueue* queue, const char* text) {
+    size_t position = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+    CommandSlot* slot;
+
+    for (;;) {
+        slot = &queue->slots[position & queue->mask];
+        size_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        ptrdiff_t distance = (ptrdiff_t)(sequence - position);
+
+        if (distance == 0) {
+            // Free slot: claim the position, or retry from wherever head moved to
+            if (__atomic_compare_exchange_n(&queue->head, &position, position + 1, true, __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (distance < 0) {
+            return false; // The consumer has not freed this slot yet
+        } else {
+            position = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+        }
+    }
+
+    strncpy(slot->command.text, text, COMMAND_TEXT_LENGTH - 1);
+    slot->command.text[COMMAND_TEXT_LENGTH - 1] = '\0';
+    __atomic_store_n(&slot->sequence, position + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Consumer thread only; returns false when nothing is ready
+bool command_queue_pop(CommandQueue* queue, QueuedCommand* command) {
+    size_t position = queue->tail;
+    CommandSlot* slot = &queue->slots[position & queue->mask];
+
+    if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != position + 1) return false;
+
+    *command = slot->command;
+    queue->tail = position + 1;
+    __atomic_store_n(&slot->sequence, position + queue->mask + 1, __ATOMIC_RELEASE);
+    return true;
+}
@@ -0,0 +1,36 @@
+#ifndef COMMAND_QUEUE_H
+#define COMMAND_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define COMMAND_TEXT_LENGTH 256
+#define COMMAND_QUEUE_CACHE_LINE 64
+
+// One line of player input waiting for the engine
+typedef struct {
+    char text[COMMAND_TEXT_LENGTH];
+} QueuedCommand;
+
+typedef struct {
+    size_t sequence; // Slot index when free for the producer at that position, + 1 once filled
+    QueuedCommand command;
+} CommandSlot;
+
+// Bounded lock-free queue: any number of producers, one consumer. Producers
+// claim a slot with a CAS on head; the consumer owns tail outright.
+typedef struct {
+    CommandSlot* slots;
+    size_t mask; // Capacity - 1 (power of two)
+    char head_padding[COMMAND_QUEUE_CACHE_LINE];
+    size_t head; // Next position producers claim
+    char tail_padding[COMMAND_QUEUE_CACHE_LINE];
+    size_t tail; // Next position the consumer reads
+} CommandQueue;
+
+bool command_queue_init(CommandQueue* queue, size_t capacity);
+void command_queue_destroy(CommandQueue* queue);
+bool command_queue_push(CommandQueue* queue, const char* text);
+bool command_queue_pop(CommandQueue* queue, QueuedCommand* command);
+
+#endif // COMMAND_QUEUE_H
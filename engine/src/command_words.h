@@ -0,0 +1,55 @@
+// Generated by tools/gen_command_words.py; edit the vocabulary there and
+// run `make command-words` instead of changing this file by hand.
+#ifndef COMMAND_WORDS_H
+#define COMMAND_WORDS_H
+
+#include "command_parser.h"
+
+#define COMMAND_WORD_SEED 42425u
+#define COMMAND_WORD_SLOT_BITS 7
+#define COMMAND_WORD_SLOTS 128
+
+static const CommandWord command_words[COMMAND_WORD_SLOTS] = {
+    [0] = {"outside", 7, VERB_NONE, DIRECTION_OUT},
+    [6] = {"grab", 4, VERB_TAKE, DIRECTION_NONE},
+    [8] = {"nw", 2, VERB_NONE, DIRECTION_NORTHWEST},
+    [9] = {"up", 2, VERB_NONE, DIRECTION_UP},
+    [15] = {"ne", 2, VERB_NONE, DIRECTION_NORTHEAST},
+    [16] = {"sw", 2, VERB_NONE, DIRECTION_SOUTHWEST},
+    [18] = {"help", 4, VERB_HELP, DIRECTION_NONE},
+    [20] = {"in", 2, VERB_NONE, DIRECTION_IN},
+    [21] = {"go", 2, VERB_GO, DIRECTION_NONE},
+    [23] = {"out", 3, VERB_NONE, DIRECTION_OUT},
+    [25] = {"se", 2, VERB_NONE, DIRECTION_SOUTHEAST},
+    [26] = {"quit", 4, VERB_QUIT, DIRECTION_NONE},
+    [28] = {"southeast", 9, VERB_NONE, DIRECTION_SOUTHEAST},
+    [33] = {"take", 4, VERB_TAKE, DIRECTION_NONE},
+    [46] = {"south", 5, VERB_NONE, DIRECTION_SOUTH},
+    [47] = {"west", 4, VERB_NONE, DIRECTION_WEST},
+    [50] = {"down", 4, VERB_NONE, DIRECTION_DOWN},
+    [60] = {"inside", 6, VERB_NONE, DIRECTION_IN},
+    [67] = {"?", 1, VERB_HELP, DIRECTION_NONE},
+    [68] = {"northeast", 9, VERB_NONE, DIRECTION_NORTHEAST},
+    [75] = {"walk", 4, VERB_GO, DIRECTION_NONE},
+    [79] = {"southwest", 9, VERB_NONE, DIRECTION_SOUTHWEST},
+    [83] = {"get", 3, VERB_TAKE, DIRECTION_NONE},
+    [88] = {"inventory", 9, VERB_INVENTORY, DIRECTION_NONE},
+    [89] = {"inv", 3, VERB_INVENTORY, DIRECTION_NONE},
+    [98] = {"east", 4, VERB_NONE, DIRECTION_EAST},
+    [100] = {"q", 1, VERB_QUIT, DIRECTION_NONE},
+    [101] = {"s", 1, VERB_NONE, DIRECTION_SOUTH},
+    [102] = {"u", 1, VERB_NONE, DIRECTION_UP},
+    [103] = {"w", 1, VERB_NONE, DIRECTION_WEST},
+    [104] = {"i", 1, VERB_INVENTORY, DIRECTION_NONE},
+    [107] = {"l", 1, VERB_LOOK, DIRECTION_NONE},
+    [108] = {"n", 1, VERB_NONE, DIRECTION_NORTH},
+    [110] = {"e", 1, VERB_NONE, DIRECTION_EAST},
+    [111] = {"d", 1, VERB_NONE, DIRECTION_DOWN},
+    [119] = {"move", 4, VERB_GO, DIRECTION_NONE},
+    [121] = {"north", 5, VERB_NONE, DIRECTION_NORTH},
+    [122] = {"northwest", 9, VERB_NONE, DIRECTION_NORTHWEST},
+    [124] = {"exit", 4, VERB_QUIT, DIRECTION_NONE},
+    [127] = {"look", 4, VERB_LOOK, DIRECTION_NONE},
+};
+
+#endif // COMMAND_WORDS_H
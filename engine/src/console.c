@@ -0,0 +1,158 @@
+// Console frontend without SDL: plays one session over standard input and
+// output, so it also serves an SSH ForceCommand or an inetd-style telnet
+// service. Output is buffered and each batch of input is answered with one
+// writev; location descriptions come pre-wrapped to a fixed width.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
+#include "adventure_engine.h"
+#include "text_output.h"
+
+#define INPUT_LINE_LENGTH 256
+#define READ_CHUNK_SIZE 4096
+#define PROMPT "> "
+
+typedef struct {
+    GameState* game;
+    const WrappedText* wrapped;
+    TextOutput output;
+    char input[INPUT_LINE_LENGTH];
+    int input_length;
+    bool discarding; // The current input line overflowed and is skipped
+    bool finished; // The player quit
+} Console;
+
+// Returns false once the player quits
+static bool run_line(Console* console, char* line) {
+    size_t length = strlen(line);
+    while (length > 0 && (line[length - 1] == '\r' || line[length - 1] == ' ')) line[--length] = '\0';
+
+    if (length > 0) {
+        CommandResult result = execute_command(console->game, line);
+        switch (result.type) {
+            case COMMAND_MOVE:
+                if (result.succeeded) text_output_describe(&console->output, console->wrapped, console->game);
+                break;
+            case COMMAND_LOOK:
+                text_output_describe(&console->output, console->wrapped, console->game);
+                break;
+            case COMMAND_QUIT:
+                text_output_print(&console->output, "Goodbye.\n");
+                return false;
+            default:
+                break;
+        }
+    }
+    text_output_print(&console->output, PROMPT);
+    return true;
+}
+
+// Split received bytes into lines; overlong lines are dropped with a warning
+static void console_receive(Console* console, const char* data, int length) {
+    for (int i = 0; i < length && !console->finished; i++) {
+        char c = data[i];
+        if (c == '\n') {
+            if (console->discarding) {
+                text_output_print(&console->output, "Command too long.\n" PROMPT);
+            } else {
+                console->input[console->input_length] = '\0';
+                console->finished = !run_line(console, console->input);
+            }
+            console->input_length = 0;
+            console->discarding = false;
+        } else if (console->input_length < INPUT_LINE_LENGTH - 1) {
+            console->input[console->input_length++] = c;
+        } else {
+            console->discarding = true;
+        }
+    }
+}
+
+// Engine errors still go through stdio; send them ahead of the buffered replies
+static bool console_flush(Console* console) {
+    fflush(stdout);
+    return text_output_flush(&console->output);
+}
+
+static void print_usage(const char* program) {
+    printf("Usage: %s [--width <columns>] [--lazy] <game_file>\n", program);
+    printf("--width wraps location descriptions (default %d, 0 to leave them unwrapped).\n", TEXT_OUTPUT_WIDTH);
+    printf("--lazy leaves location text in the game file until a location is shown.\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char* game_file = NULL;
+    int width = TEXT_OUTPUT_WIDTH;
+    bool lazy = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--lazy") == 0) {
+            lazy = true;
+        } else if (!game_file) {
+            game_file = argv[i];
+        } else {
+            game_file = NULL;
+            break;
+        }
+    }
+
+    if (!game_file || width < 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    GameState* game = lazy ? load_game_lazy(game_file) : load_game(game_file);
+    if (!game) {
+        printf("Failed to load game: %s\n", game_file);
+        return 1;
+    }
+
+    WrappedText* wrapped = wrap_world_text(game->world, width);
+    if (!wrapped) {
+        cleanup_game(game);
+        return 1;
+    }
+
+    Console console;
+    memset(&console, 0, sizeof(console));
+    console.game = game;
+    console.wrapped = wrapped;
+    text_output_init(&console.output, STDOUT_FILENO, 0);
+    game->output = text_output_game;
+    game->output_context = &console.output;
+
+    const GameMeta* meta = &game->world->meta;
+    char welcome[GAME_MESSAGE_LENGTH];
+    snprintf(welcome, sizeof(welcome), "Welcome to %s by %s\n\n", meta->title ? meta->title : "AdventureGPT",
+             meta->author ? meta->author : "unknown");
+    text_output_print(&console.output, welcome);
+    text_output_describe(&console.output, wrapped, game);
+    text_output_print(&console.output, PROMPT);
+    bool ok = console_flush(&console);
+
+    // Standard output blocks, so every flush either finishes or fails
+    char data[READ_CHUNK_SIZE];
+    while (ok && !console.finished) {
+        ssize_t received = read(STDIN_FILENO, data, sizeof(data));
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) break;
+        console_receive(&console, data, (int)received);
+        ok = console_flush(&console);
+    }
+    if (ok && !console.finished) {
+        // A last command without a newline still counts
+        if (console.input_length > 0 && !console.discarding) console_receive(&console, "\n", 1);
+        if (!console.finished) text_output_print(&console.output, "\n");
+        ok = console_flush(&console);
+    }
+
+    text_output_free(&console.output);
+    free_wrapped_text(wrapped);
+    cleanup_game(game);
+    return ok ? 0 : 1;
+}
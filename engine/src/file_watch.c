@@ -0,0 +1,100 @@
+#include "file_watch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#if defined(__linux__) && !defined(FILE_WATCH_POLL)
+#define FILE_WATCH_INOTIFY
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Size and modification time, or false while the file is missing (mid-rename)
+static bool file_version(const FileWatch* watch, long long* size, long long* mtime) {
+    size_t length = strlen(watch->directory) + strlen(watch->name) + 2;
+    char* path = malloc(length);
+    if (!path) return false;
+    snprintf(path, length, "%s/%s", watch->directory, watch->name);
+
+    struct stat st;
+    bool found = stat(path, &st) == 0;
+    free(path);
+    if (found) {
+        *size = (long long)st.st_size;
+        *mtime = (long long)st.st_mtime;
+    }
+    return found;
+}
+
+bool file_watch_open(FileWatch* watch, const char* path) {
+    memset(watch, 0, sizeof(*watch));
+    watch->fd = -1;
+
+    const char* slash = strrchr(path, '/');
+    size_t directory_length = slash ? (size_t)(slash - path) : 1;
+    watch->directory = malloc(directory_length + strlen(path) + 2);
+    if (!watch->directory) {
+        printf("Error: Could not allocate file watch\n");
+        return false;
+    }
+    if (slash) {
+        memcpy(watch->directory, path, directory_length);
+    } else {
+        watch->directory[0] = '.';
+    }
+    watch->directory[directory_length] = '\0';
+
+    // The name is kept right after the directory in the same allocation
+    char* name = watch->directory + directory_length + 1;
+    strcpy(name, slash ? slash + 1 : path);
+    watch->name = name;
+
+    if (!file_version(watch, &watch->size, &watch->mtime)) {
+        printf("Error: Could not watch %s\n", path);
+        file_watch_close(watch);
+        return false;
+    }
+
+#ifdef FILE_WATCH_INOTIFY
+    // Write closes and renames into the directory; falls back to polling if unavailable
+    watch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watch->fd >= 0 && inotify_add_watch(watch->fd, watch->directory, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(watch->fd);
+        watch->fd = -1;
+    }
+#endif
+    return true;
+}
+
+bool file_watch_changed(FileWatch* watch) {
+#ifdef FILE_WATCH_INOTIFY
+    if (watch->fd >= 0) {
+        char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        bool changed = false;
+        ssize_t length;
+        while ((length = read(watch->fd, buffer, sizeof(buffer))) > 0) {
+            for (char* p = buffer; p < buffer + length;) {
+                const struct inotify_event* event = (const struct inotify_event*)p;
+                if (event->len > 0 && strcmp(event->name, watch->name) == 0) changed = true;
+                p += sizeof(struct inotify_event) + event->len;
+            }
+        }
+        return changed;
+    }
+#endif
+    long long size, mtime;
+    if (!file_version(watch, &size, &mtime) || (size == watch->size && mtime == watch->mtime)) return false;
+    watch->size = size;
+    watch->mtime = mtime;
+    return true;
+}
+
+void file_watch_close(FileWatch* watch) {
+#ifdef FILE_WATCH_INOTIFY
+    if (watch->fd >= 0) close(watch->fd);
+#endif
+    free(watch->directory);
+    memset(watch, 0, sizeof(*watch));
+    watch->fd = -1;
+}
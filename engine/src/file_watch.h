@@ -0,0 +1,27 @@
+#ifndef FILE_WATCH_H
+#define FILE_WATCH_H
+
+#include <stdbool.h>
+
+// How often a frontend should check a watch; the check never blocks
+#define FILE_WATCH_INTERVAL_MS 250
+
+// Notices when a file is rewritten. Linux watches the file's directory with
+// inotify, which also catches editors that save by renaming a new copy over
+// the file; other targets compare its size and modification time.
+typedef struct {
+    char* directory;
+    const char* name; // File name within directory
+    int fd; // inotify descriptor, -1 when polling
+    long long size;
+    long long mtime;
+} FileWatch;
+
+bool file_watch_open(FileWatch* watch, const char* path);
+
+// Whether the file changed since the last call; a burst of writes counts once
+// if it lands between two calls
+bool file_watch_changed(FileWatch* watch);
+void file_watch_close(FileWatch* watch);
+
+#endif // FILE_WATCH_H
@@ -0,0 +1,236 @@
+#include "glyph_atlas.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const Uint16 extra_code_points[GLYPH_EXTRA_COUNT] = {
+    0x2013, 0x2014, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2026 // – — ‘ ’ “ ” • …
+};
+
+// Map a code point to its glyph index, or -1 if the atlas doesn't cover it
+static int glyph_index(unsigned int code) {
+    if (code >= 32 && code <= 126) return code - 32;
+    if (code >= 160 && code <= 255) return GLYPH_ASCII_COUNT + (code - 160);
+    
+    for (int i = 0; i < GLYPH_EXTRA_COUNT; i++) {
+        if (extra_code_points[i] == code) return GLYPH_ASCII_COUNT + GLYPH_LATIN1_COUNT + i;
+    }
+    return -1;
+}
+
+static unsigned int glyph_code_point(int index) {
+    if (index < GLYPH_ASCII_COUNT) return 32 + index;
+    if (index < GLYPH_ASCII_COUNT + GLYPH_LATIN1_COUNT) return 160 + (index - GLYPH_ASCII_COUNT);
+    return extra_code_points[index - GLYPH_ASCII_COUNT - GLYPH_LATIN1_COUNT];
+}
+
+// Decode one UTF-8 sequence; stray bytes are taken as Latin-1
+static unsigned int next_code_point(const unsigned char** text, const unsigned char* end) {
+    const unsigned char* p = *text;
+    unsigned int code = *p++;
+    int continuation = 0;
+    
+    if (code >= 0xF0 && code < 0xF8) { code &= 0x07; continuation = 3; }
+    else if (code >= 0xE0) { code &= 0x0F; continuation = 2; }
+    else if (code >= 0xC0) { code &= 0x1F; continuation = 1; }
+    
+    if (continuation > end - p) {
+        continuation = -1;
+    }
+    for (int i = 0; i < continuation; i++) {
+        if ((p[i] & 0xC0) != 0x80) {
+            continuation = -1;
+            break;
+        }
+    }
+    
+    if (continuation < 0) {
+        code = **text;
+        p = *text + 1;
+    } else {
+        for (int i = 0; i < continuation; i++) {
+            code = (code << 6) | (*p++ & 0x3F);
+        }
+    }
+    
+    *text = p;
+    return code;
+}
+
+static const Glyph* find_glyph(const GlyphAtlas* atlas, unsigned int code) {
+    int index = glyph_index(code);
+    return &atlas->glyphs[index >= 0 ? index : atlas->fallback];
+}
+
+bool glyph_atlas_init(GlyphAtlas* atlas, SDL_Renderer* renderer, TTF_Font* font) {
+    memset(atlas, 0, sizeof(*atlas));
+    atlas->line_height = TTF_FontHeight(font);
+    atlas->fallback = glyph_index('?');
+    
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Surface* surfaces[GLYPH_COUNT] = {0};
+    
+    // Rasterize every glyph and shelf-pack the cells into rows
+    int pen_x = 0;
+    int pen_y = 0;
+    int row_height = 0;
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        Uint16 code = (Uint16)glyph_code_point(i);
+        Glyph* glyph = &atlas->glyphs[i];
+        int min_x, max_x, min_y, max_y;
+        
+        if (i != atlas->fallback && !TTF_GlyphIsProvided(font, code)) {
+            glyph->advance = -1; // Resolved to the fallback below
+            continue;
+        }
+        if (TTF_GlyphMetrics(font, code, &min_x, &max_x, &min_y, &max_y, &glyph->advance) != 0) {
+            glyph->advance = -1;
+            continue;
+        }
+        
+        surfaces[i] = TTF_RenderGlyph_Blended(font, code, white);
+        if (!surfaces[i]) {
+            glyph->advance = -1;
+            continue;
+        }
+        
+        if (pen_x + surfaces[i]->w > GLYPH_ATLAS_WIDTH) {
+            pen_x = 0;
+            pen_y += row_height + 1;
+            row_height = 0;
+        }
+        
+        glyph->source = (SDL_Rect){pen_x, pen_y, surfaces[i]->w, surfaces[i]->h};
+        glyph->offset_x = min_x < 0 ? min_x : 0;
+        pen_x += surfaces[i]->w + 1;
+        if (surfaces[i]->h > row_height) row_height = surfaces[i]->h;
+    }
+    
+    atlas->height = pen_y + row_height;
+    SDL_Surface* sheet = SDL_CreateRGBSurfaceWithFormat(0, GLYPH_ATLAS_WIDTH, atlas->height, 32,
+                                                        SDL_PIXELFORMAT_RGBA32);
+    if (sheet) {
+        for (int i = 0; i < GLYPH_COUNT; i++) {
+            if (!surfaces[i]) continue;
+            
+            // Copy coverage as-is instead of blending it onto the empty sheet
+            SDL_SetSurfaceBlendMode(surfaces[i], SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(surfaces[i], NULL, sheet, &atlas->glyphs[i].source);
+        }
+        atlas->texture = SDL_CreateTextureFromSurface(renderer, sheet);
+        SDL_FreeSurface(sheet);
+    }
+    
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        SDL_FreeSurface(surfaces[i]);
+    }
+    
+    if (!atlas->texture || atlas->glyphs[atlas->fallback].advance < 0) {
+        printf("Unable to build glyph atlas! SDL Error: %s\n", SDL_GetError());
+        glyph_atlas_destroy(atlas);
+        return false;
+    }
+    SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+    
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        if (atlas->glyphs[i].advance < 0) {
+            atlas->glyphs[i] = atlas->glyphs[atlas->fallback];
+        }
+    }
+    
+    return true;
+}
+
+void glyph_atlas_destroy(GlyphAtlas* atlas) {
+    if (atlas->texture) {
+        SDL_DestroyTexture(atlas->texture);
+    }
+    free(atlas->vertices);
+    free(atlas->indices);
+    memset(atlas, 0, sizeof(*atlas));
+}
+
+int glyph_atlas_text_width(const GlyphAtlas* atlas, const char* text, size_t length) {
+    const unsigned char* p = (const unsigned char*)text;
+    const unsigned char* end = p + length;
+    int width = 0;
+    
+    while (p < end) {
+        width += find_glyph(atlas, next_code_point(&p, end))->advance;
+    }
+    return width;
+}
+
+static bool reserve_quads(GlyphAtlas* atlas, int count) {
+    if (atlas->quad_count + count <= atlas->quad_capacity) return true;
+    
+    int capacity = atlas->quad_capacity ? atlas->quad_capacity : 256;
+    while (capacity < atlas->quad_count + count) capacity *= 2;
+    
+    SDL_Vertex* vertices = realloc(atlas->vertices, capacity * 4 * sizeof(SDL_Vertex));
+    if (!vertices) return false;
+    atlas->vertices = vertices;
+    
+    int* indices = realloc(atlas->indices, capacity * 6 * sizeof(int));
+    if (!indices) return false;
+    atlas->indices = indices;
+    
+    atlas->quad_capacity = capacity;
+    return true;
+}
+
+// Queue one line of text; nothing is drawn until glyph_atlas_flush
+void glyph_atlas_add_text(GlyphAtlas* atlas, const char* text, size_t length, int x, int y, SDL_Color color) {
+    if (!atlas->texture || !reserve_quads(atlas, (int)length)) return;
+    
+    float inv_width = 1.0f / GLYPH_ATLAS_WIDTH;
+    float inv_height = 1.0f / atlas->height;
+    
+    const unsigned char* p = (const unsigned char*)text;
+    const unsigned char* end = p + length;
+    int pen_x = x;
+    
+    while (p < end) {
+        unsigned int code = next_code_point(&p, end);
+        int index = glyph_index(code);
+        const Glyph* glyph = &atlas->glyphs[index >= 0 ? index : atlas->fallback];
+        if (index < 0) atlas->glyphs_missing++;
+        if (code != ' ' && glyph->source.w > 0) {
+            atlas->glyphs_drawn++;
+            float left = (float)(pen_x + glyph->offset_x);
+            float top = (float)y;
+            float right = left + glyph->source.w;
+            float bottom = top + glyph->source.h;
+            float u0 = glyph->source.x * inv_width;
+            float v0 = glyph->source.y * inv_height;
+            float u1 = (glyph->source.x + glyph->source.w) * inv_width;
+            float v1 = (glyph->source.y + glyph->source.h) * inv_height;
+            
+            int base = atlas->quad_count * 4;
+            SDL_Vertex* v = &atlas->vertices[base];
+            v[0] = (SDL_Vertex){{left, top}, color, {u0, v0}};
+            v[1] = (SDL_Vertex){{right, top}, color, {u1, v0}};
+            v[2] = (SDL_Vertex){{right, bottom}, color, {u1, v1}};
+            v[3] = (SDL_Vertex){{left, bottom}, color, {u0, v1}};
+            
+            int* index = &atlas->indices[atlas->quad_count * 6];
+            index[0] = base; index[1] = base + 1; index[2] = base + 2;
+            index[3] = base; index[4] = base + 2; index[5] = base + 3;
+            atlas->quad_count++;
+        }
+        pen_x += glyph->advance;
+    }
+}
+
+size_t glyph_atlas_bytes(const GlyphAtlas* atlas) {
+    size_t texture = atlas->texture ? (size_t)GLYPH_ATLAS_WIDTH * atlas->height * 4 : 0;
+    return texture + atlas->quad_capacity * (4 * sizeof(SDL_Vertex) + 6 * sizeof(int));
+}
+
+void glyph_atlas_flush(GlyphAtlas* atlas, SDL_Renderer* renderer) {
+    if (atlas->quad_count == 0) return;
+    
+    SDL_RenderGeometry(renderer, atlas->texture, atlas->vertices, atlas->quad_count * 4,
+                       atlas->indices, atlas->quad_count * 6);
+    atlas->quad_count = 0;
+}
@@ -0,0 +1,47 @@
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+// Printable ASCII, the Latin-1 supplement and a few typographic extras
+#define GLYPH_ASCII_COUNT 95
+#define GLYPH_LATIN1_COUNT 96
+#define GLYPH_EXTRA_COUNT 8
+#define GLYPH_COUNT (GLYPH_ASCII_COUNT + GLYPH_LATIN1_COUNT + GLYPH_EXTRA_COUNT)
+#define GLYPH_ATLAS_WIDTH 512
+
+typedef struct {
+    SDL_Rect source; // Glyph cell inside the atlas texture
+    int offset_x; // Cell position relative to the pen (negative for overhanging glyphs)
+    int advance;
+} Glyph;
+
+// Every glyph rasterized once into one texture; text is drawn as batched quads
+typedef struct {
+    SDL_Texture* texture;
+    Glyph glyphs[GLYPH_COUNT];
+    int fallback; // Glyph index used for characters outside the atlas
+    int height; // Atlas texture height in pixels
+    int line_height;
+    
+    // Pending quads, drawn with one SDL_RenderGeometry call per flush
+    SDL_Vertex* vertices;
+    int* indices;
+    int quad_count;
+    int quad_capacity;
+    
+    unsigned long glyphs_drawn;
+    unsigned long glyphs_missing; // Characters outside the atlas, drawn as the fallback
+} GlyphAtlas;
+
+bool glyph_atlas_init(GlyphAtlas* atlas, SDL_Renderer* renderer, TTF_Font* font);
+void glyph_atlas_destroy(GlyphAtlas* atlas);
+int glyph_atlas_text_width(const GlyphAtlas* atlas, const char* text, size_t length);
+void glyph_atlas_add_text(GlyphAtlas* atlas, const char* text, size_t length, int x, int y, SDL_Color color);
+void glyph_atlas_flush(GlyphAtlas* atlas, SDL_Renderer* renderer);
+size_t glyph_atlas_bytes(const GlyphAtlas* atlas); // Texture and quad buffers
+
+#endif // GLYPH_ATLAS_H
@@ -0,0 +1,531 @@
+// Headless engine driver: runs scripted or random-walk commands against the core
+// engine without SDL and reports load time, throughput and per-command latency.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include "adventure_engine.h"
+#include "snapshot.h"
+#include "journal.h"
+#include "location_text.h"
+#include "profiler.h"
+#include "world_graph.h"
+#include "world_regions.h"
+#include "world_reload.h"
+
+#define MAX_COMMAND_LENGTH 256
+#define SNAPSHOT_ROUNDS 1000 // Save/restore round trips timed for the report
+#define ROUTE_QUERIES 1000 // Random route lookups timed after the full search
+#define TEXT_LOOKUPS 1000 // Random location text lookups timed for the report
+#define SEARCH_QUERIES 1000 // Repeats of the --search query timed for the report
+#define SEARCH_SHOWN 5 // Matches listed by id
+
+typedef struct {
+    char** lines;
+    unsigned int* ticks; // Recorded tick of each line when replaying a journal, NULL otherwise
+    int count;
+    int capacity;
+} Script;
+
+typedef struct {
+    long long* samples; // Nanoseconds per command
+    int count;
+    int capacity;
+} Latencies;
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Small deterministic generator so walks are reproducible across runs and platforms
+static unsigned int next_random(unsigned int* state) {
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static bool add_latency(Latencies* latencies, long long sample) {
+    if (latencies->count == latencies->capacity) {
+        int capacity = latencies->capacity ? latencies->capacity * 2 : 1024;
+        long long* samples = realloc(latencies->samples, capacity * sizeof(long long));
+        if (!samples) return false;
+        latencies->samples = samples;
+        latencies->capacity = capacity;
+    }
+    latencies->samples[latencies->count++] = sample;
+    return true;
+}
+
+static int compare_latency(const void* a, const void* b) {
+    long long x = *(const long long*)a;
+    long long y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+static long long percentile(const Latencies* latencies, int percent) {
+    if (latencies->count == 0) return 0;
+    int index = (int)((long long)(latencies->count - 1) * percent / 100);
+    return latencies->samples[index];
+}
+
+static bool add_line(Script* script, const char* line, unsigned int tick, bool replay) {
+    if (script->count == script->capacity) {
+        int capacity = script->capacity ? script->capacity * 2 : 64;
+        char** lines = realloc(script->lines, capacity * sizeof(char*));
+        if (!lines) return false;
+        script->lines = lines;
+        if (replay) {
+            unsigned int* ticks = realloc(script->ticks, capacity * sizeof(unsigned int));
+            if (!ticks) return false;
+            script->ticks = ticks;
+        }
+        script->capacity = capacity;
+    }
+    script->lines[script->count] = strdup(line);
+    if (!script->lines[script->count]) return false;
+    if (replay) script->ticks[script->count] = tick;
+    script->count++;
+    return true;
+}
+
+// One command per line; blank lines and lines starting with '#' are skipped
+static bool load_script(const char* filename, Script* script) {
+    FILE* file = strcmp(filename, "-") == 0 ? stdin : fopen(filename, "r");
+    if (!file) {
+        printf("Error: Could not open script %s\n", filename);
+        return false;
+    }
+
+    char line[MAX_COMMAND_LENGTH];
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') continue;
+        ok = add_line(script, line, 0, false);
+    }
+
+    if (file != stdin) fclose(file);
+    if (!ok) printf("Error: Out of memory reading script %s\n", filename);
+    return ok;
+}
+
+// Journal entries the session has not applied yet: everything past its tick,
+// which is zero for a fresh game or the snapshot's tick after --save resumes
+static bool load_replay(const char* filename, unsigned int after_tick, Script* script) {
+    JournalReader reader;
+    if (!journal_reader_open(&reader, filename)) return false;
+
+    JournalEntry entry;
+    int status;
+    bool ok = true;
+    while (ok && (status = journal_read(&reader, &entry)) == 1) {
+        if (entry.tick <= after_tick) continue;
+        ok = add_line(script, entry.command, entry.tick, true);
+        if (!ok) printf("Error: Out of memory reading journal %s\n", filename);
+    }
+    journal_reader_close(&reader);
+    return ok && status == 0;
+}
+
+static void free_script(Script* script) {
+    for (int i = 0; i < script->count; i++) {
+        free(script->lines[i]);
+    }
+    free(script->lines);
+    free(script->ticks);
+}
+
+// Player commands go through execute_command; "set <flag>" and "clear <flag>"
+// drive set_flag directly and count as a tick too, so journals of scripts
+// replay in step. Returns false once the script asks to quit.
+static bool run_command(GameState* game, const char* command) {
+    if (strncmp(command, "set ", 4) == 0) {
+        set_flag(game, command + 4, true);
+        game->tick++;
+        return true;
+    }
+    if (strncmp(command, "clear ", 6) == 0) {
+        set_flag(game, command + 6, false);
+        game->tick++;
+        return true;
+    }
+    return execute_command(game, command).type != COMMAND_QUIT;
+}
+
+// Journaling happens outside the timed region so latencies stay comparable
+static bool timed_command(GameState* game, const char* command, Latencies* latencies, Journal* journal) {
+    long long start = now_ns();
+    bool running = run_command(game, command);
+    long long elapsed = now_ns() - start;
+
+    if (!add_latency(latencies, elapsed)) {
+        printf("Error: Out of memory recording latencies\n");
+        return false;
+    }
+    if (journal->file && !journal_append(journal, game->tick, command)) return false;
+    return running;
+}
+
+// Pick the next command of a random walk: mostly moves through random exits,
+// picking up items and toggling flags along the way
+static void next_walk_command(GameState* game, unsigned int* seed, char* command, size_t size) {
+    // Only exits and items are needed, so skip decoding lazily loaded text
+    int index = game->player.current_location_index;
+    const Location* location = index != INVALID_LOCATION ? &game->world->locations[index] : NULL;
+    unsigned int roll = next_random(seed);
+
+    if (location && location->items_count > 0 && roll % 4 == 0) {
+        int item = location->items[next_random(seed) % location->items_count];
+        snprintf(command, size, "take %s", symbol_name(&game->world->item_symbols, item));
+    } else if (game->world->flag_symbols.count > 0 && roll % 8 == 1) {
+        const char* flag = symbol_name(&game->world->flag_symbols, next_random(seed) % game->world->flag_symbols.count);
+        snprintf(command, size, "%s %s", roll % 16 == 1 ? "set" : "clear", flag);
+    } else if (location && location->exits_count > 0) {
+        const Exit* exit = &location->exits[next_random(seed) % location->exits_count];
+        snprintf(command, size, "go %s", exit->direction);
+    } else {
+        snprintf(command, size, "look");
+    }
+}
+
+// Time a full search of the world graph from the player's location, then
+// lookups that reuse it
+static void report_routes(GameState* game) {
+    int from = game->player.current_location_index;
+    int locations = game->world->locations_count;
+    if (from == INVALID_LOCATION) return;
+
+    long long search_start = now_ns();
+    int reachable = count_reachable(game, from);
+    long long search_time = now_ns() - search_start;
+
+    unsigned int seed = 1;
+    int routed = 0;
+    long long query_start = now_ns();
+    for (int i = 0; i < ROUTE_QUERIES; i++) {
+        if (route_distance(game, from, (int)(next_random(&seed) % (unsigned int)locations)) >= 0) routed++;
+    }
+    long long query_time = now_ns() - query_start;
+
+    printf("Routes: %d of %d locations reachable over %d exits, full search %.3f ms, cached query %.0f ns "
+           "(%d of %d routed)\n", reachable, locations, game->world->graph.edges_count, search_time / 1e6,
+           (double)query_time / ROUTE_QUERIES, routed, ROUTE_QUERIES);
+}
+
+// Time text lookups of random locations, which decode lazily loaded text on a
+// cache miss
+static void report_text(GameState* game) {
+    const World* world = game->world;
+    if (world->locations_count == 0) return;
+
+    unsigned int seed = 1;
+    size_t characters = 0;
+    long long lookup_start = now_ns();
+    for (int i = 0; i < TEXT_LOOKUPS; i++) {
+        const char* id = symbol_name(&world->location_symbols, (int)(next_random(&seed) % world->locations_count));
+        const Location* location = get_location_by_id(game, id);
+        if (location) characters += strlen(location->description);
+    }
+    long long lookup_time = now_ns() - lookup_start;
+
+    LocationTextStats stats = location_text_stats(game->text);
+    printf("Text: lookup %.0f ns (%zu characters), %s, %d rooms and %zu bytes cached (%ld decoded, %ld evicted)\n",
+           (double)lookup_time / TEXT_LOOKUPS, characters, world->text_offsets ? "lazy" : "loaded", stats.rooms,
+           stats.bytes, stats.decodes, stats.evictions);
+}
+
+// Build the search index, then time the query and list its first matches
+static bool report_search(GameState* game, const char* query) {
+    const World* world = game->world;
+    long long build_start = now_ns();
+    SearchIndex* index = build_search_index(world);
+    long long build_time = now_ns() - build_start;
+    if (!index) return false;
+
+    SearchHit hits[SEARCH_SHOWN];
+    int matches = 0;
+    long long query_start = now_ns();
+    for (int i = 0; i < SEARCH_QUERIES; i++) {
+        matches = search_world(index, query, hits, SEARCH_SHOWN);
+    }
+    long long query_time = now_ns() - query_start;
+
+    SearchIndexStats stats = search_index_stats(index);
+    printf("Search: \"%s\" in %.0f ns, %d matches", query, (double)query_time / SEARCH_QUERIES, matches);
+    for (int i = 0; i < matches && i < SEARCH_SHOWN; i++) {
+        const char* id = hits[i].type == SEARCH_LOCATION ? world->locations[hits[i].index].id
+                                                          : world->inventory_items[hits[i].index].id;
+        printf("%s%s %s", i == 0 ? " (" : ", ", hits[i].type == SEARCH_LOCATION ? "location" : "item", id);
+    }
+    printf("%s\n", matches > SEARCH_SHOWN ? ", ...)" : matches > 0 ? ")" : "");
+    printf("Index: %d documents, %d terms, %ld postings in %zu bytes, %zu bytes in all, built in %.3f ms\n",
+           stats.documents, stats.terms, stats.postings, stats.postings_bytes, stats.bytes, build_time / 1e6);
+    free_search_index(index);
+    return true;
+}
+
+// Time in-memory snapshot round trips of the session's final state
+static bool report_snapshot(GameState* game) {
+    size_t size = snapshot_size(game);
+    void* buffer = malloc(size);
+    if (!buffer) {
+        printf("Error: Out of memory timing snapshots\n");
+        return false;
+    }
+
+    long long save_start = now_ns();
+    for (int i = 0; i < SNAPSHOT_ROUNDS; i++) {
+        snapshot_write(game, buffer, size);
+    }
+    long long save_time = now_ns() - save_start;
+
+    bool ok = true;
+    long long restore_start = now_ns();
+    for (int i = 0; i < SNAPSHOT_ROUNDS && ok; i++) {
+        ok = snapshot_read(game, buffer, size);
+    }
+    long long restore_time = now_ns() - restore_start;
+    free(buffer);
+
+    printf("Snapshot: %zu bytes (%d locations changed), save %.0f ns, restore %.0f ns\n", size,
+           game->overlay.count, (double)save_time / SNAPSHOT_ROUNDS, (double)restore_time / SNAPSHOT_ROUNDS);
+    return ok;
+}
+
+// Load another version of the game and carry the session over to it, as the
+// engine's --watch does when the game file changes
+static bool reload_game(GameState** game, const char* filename, bool lazy) {
+    long long load_start = now_ns();
+    World* world = lazy ? load_world_lazy(filename) : load_world(filename);
+    long long load_time = now_ns() - load_start;
+    if (!world) {
+        printf("Failed to load game: %s\n", filename);
+        return false;
+    }
+
+    WorldDiff diff;
+    long long diff_start = now_ns();
+    bool diffed = diff_worlds((*game)->world, world, &diff);
+    long long diff_time = now_ns() - diff_start;
+    long long rebase_start = now_ns();
+    GameState* rebased = diffed ? rebase_session(*game, world, &diff) : NULL;
+    long long rebase_time = now_ns() - rebase_start;
+    if (!rebased) {
+        if (diffed) free_world_diff(&diff);
+        cleanup_world(world);
+        return false;
+    }
+
+    printf("Reload: %s loaded in %.3f ms, diffed in %.3f ms, session rebased in %.3f ms\n", filename,
+           load_time / 1e6, diff_time / 1e6, rebase_time / 1e6);
+    printf("Changes: %d locations changed, %d added, %d removed, %d items changed, start %s\n",
+           diff.locations_changed, diff.locations_added, diff.locations_removed, diff.items_changed,
+           diff.start_changed ? "changed" : "unchanged");
+    free_world_diff(&diff);
+
+    rebased->owns_world = true;
+    cleanup_game(*game);
+    *game = rebased;
+    return true;
+}
+
+// Totals of every zone that ran, then the trace itself
+static bool report_profile(const char* trace_file) {
+    const char* separator = " ";
+    printf("Profile:");
+    for (int zone = 0; zone < PROFILE_ZONES; zone++) {
+        ProfileZoneStats stats = profile_zone_stats((ProfileZone)zone);
+        if (stats.count == 0) continue;
+        printf("%s%s %ld x %.0f ns (max %.0f ns)", separator, profile_zone_name((ProfileZone)zone), stats.count,
+               (double)stats.total_ns / stats.count, (double)stats.max_ns);
+        separator = ", ";
+    }
+    printf("\n");
+
+    bool ok = profiler_write_trace(trace_file);
+    if (ok) printf("Trace written to %s\n", trace_file);
+    profiler_stop();
+    return ok;
+}
+
+static void print_usage(const char* program) {
+    printf("Usage: %s [--quiet] [--lazy] [--repeat <n>] [--walk <commands>] [--seed <n>] [--save <file>] "
+           "[--journal <file>] [--replay <file>] [--trace <file>] [--stats] [--search <words>] "
+           "[--load-threads <n>] [--reload <file>] <game_file> [script_file|-]\n", program);
+    printf("Without a script, --walk or --replay, commands are read from standard input.\n");
+    printf("--save resumes from the snapshot file if it exists and writes it back on exit.\n");
+    printf("--journal records every command; --replay runs a journal's commands past the session's tick.\n");
+    printf("--lazy leaves location text in the game file until a location is looked up.\n");
+    printf("--trace writes a Chrome trace of loading and the most recent commands.\n");
+    printf("--stats breaks down the world's and the session's memory use after the run.\n");
+    printf("--load-threads caps the threads a region manifest loads on (default one per core).\n");
+    printf("--reload carries the session over to another version of the game after the run, as --watch does.\n");
+    printf("--search builds the full-text index and times a query for locations and items holding every word.\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char* game_file = NULL;
+    const char* script_file = NULL;
+    const char* save_file = NULL;
+    const char* journal_file = NULL;
+    const char* replay_file = NULL;
+    const char* trace_file = NULL;
+    bool quiet = false;
+    bool lazy = false;
+    bool stats = false;
+    const char* search_query = NULL;
+    const char* reload_file = NULL;
+    int repeat = 1;
+    long walk = 0;
+    unsigned int seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quiet") == 0) {
+            quiet = true;
+        } else if (strcmp(argv[i], "--lazy") == 0) {
+            lazy = true;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats = true;
+        } else if (strcmp(argv[i], "--search") == 0 && i + 1 < argc) {
+            search_query = argv[++i];
+        } else if (strcmp(argv[i], "--reload") == 0 && i + 1 < argc) {
+            reload_file = argv[++i];
+        } else if (strcmp(argv[i], "--load-threads") == 0 && i + 1 < argc) {
+            set_region_threads(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--walk") == 0 && i + 1 < argc) {
+            walk = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            save_file = argv[++i];
+        } else if (strcmp(argv[i], "--journal") == 0 && i + 1 < argc) {
+            journal_file = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_file = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_file = argv[++i];
+        } else if (!game_file) {
+            game_file = argv[i];
+        } else if (!script_file) {
+            script_file = argv[i];
+        } else {
+            game_file = NULL;
+            break;
+        }
+    }
+
+    // A replay carries its own commands and ticks, which only happen once
+    if (!game_file || repeat < 1 || walk < 0 ||
+        (replay_file && (walk > 0 || script_file || repeat > 1))) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (seed == 0) seed = 1; // xorshift never leaves zero
+
+    Script script = {0};
+    if (walk == 0 && !replay_file && !load_script(script_file ? script_file : "-", &script)) {
+        free_script(&script);
+        return 1;
+    }
+
+    if (trace_file && !profiler_start(PROFILE_TRACE_EVENTS)) {
+        free_script(&script);
+        return 1;
+    }
+
+    long long load_start = now_ns();
+    GameState* game = lazy ? load_game_lazy(game_file) : load_game(game_file);
+    long long load_time = now_ns() - load_start;
+    if (!game) {
+        printf("Failed to load game: %s\n", game_file);
+        free_script(&script);
+        return 1;
+    }
+    game->quiet = quiet;
+
+    FILE* existing = save_file ? fopen(save_file, "rb") : NULL;
+    bool resumed = existing != NULL;
+    if (existing) {
+        fclose(existing);
+        if (!load_snapshot(game, save_file)) {
+            free_script(&script);
+            cleanup_game(game);
+            return 1;
+        }
+    }
+
+    Journal journal = {0};
+    if ((replay_file && !load_replay(replay_file, game->tick, &script)) ||
+        (journal_file && !journal_open(&journal, journal_file, resumed))) {
+        free_script(&script);
+        cleanup_game(game);
+        return 1;
+    }
+
+    Latencies latencies = {0};
+    char command[MAX_COMMAND_LENGTH];
+    bool running = true;
+    bool diverged = false;
+
+    long long run_start = now_ns();
+    if (walk > 0) {
+        for (long i = 0; i < walk && running; i++) {
+            next_walk_command(game, &seed, command, sizeof(command));
+            running = timed_command(game, command, &latencies, &journal);
+        }
+    } else {
+        for (int pass = 0; pass < repeat && running; pass++) {
+            for (int i = 0; i < script.count && running; i++) {
+                running = timed_command(game, script.lines[i], &latencies, &journal);
+
+                // A replay that lands on a different tick did not reproduce the session
+                if (script.ticks && game->tick != script.ticks[i]) {
+                    printf("Error: Journal entry %u (%s) replayed as tick %u\n", script.ticks[i],
+                           script.lines[i], game->tick);
+                    running = false;
+                    diverged = true;
+                }
+            }
+        }
+    }
+    long long run_time = now_ns() - run_start;
+    journal_close(&journal);
+
+    if (latencies.count > 0) {
+        qsort(latencies.samples, latencies.count, sizeof(long long), compare_latency);
+    }
+
+    printf("Game: %s (%d locations, %d items, %d flags)\n", game_file, game->world->locations_count,
+           game->world->item_symbols.count, game->world->flag_symbols.count);
+    printf("Load time: %.3f ms\n", load_time / 1e6);
+    printf("Commands: %d in %.3f ms (%.0f commands/sec)\n", latencies.count, run_time / 1e6,
+           run_time > 0 ? latencies.count * 1e9 / run_time : 0.0);
+    printf("Latency: p50 %lld ns, p99 %lld ns, max %lld ns\n", percentile(&latencies, 50),
+           percentile(&latencies, 99), latencies.count ? latencies.samples[latencies.count - 1] : 0);
+
+    bool reloaded = !reload_file || diverged || reload_game(&game, reload_file, lazy);
+
+    report_routes(game);
+    report_text(game);
+    if (stats) {
+        EngineMemoryStats memory = engine_memory_stats(game);
+        print_memory_stats(&memory);
+    }
+    bool ok = !diverged && reloaded && report_snapshot(game);
+    if (ok && search_query) ok = report_search(game, search_query);
+    if (ok && save_file) ok = save_snapshot(game, save_file);
+    if (trace_file && !report_profile(trace_file)) ok = false;
+
+    free(latencies.samples);
+    free_script(&script);
+    cleanup_game(game);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,279 @@
+#include "image_loader.h"
+#include "image_pack.h"
+#include "profiler.h"
+#include <SDL2/SDL_image.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Shrink to the display size and convert to the upload format, so textures
+// never hold more pixels than are drawn
+static SDL_Surface* prepare_surface(const ImageLoader* loader, SDL_Surface* surface) {
+    // Packs exported for this display arrive ready to upload
+    if (surface->format->format == loader->format && surface->w <= loader->max_width &&
+        surface->h <= loader->max_height) {
+        return surface;
+    }
+
+    SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGB888, 0);
+    SDL_FreeSurface(surface);
+    if (!converted) return NULL;
+
+    int width = converted->w < loader->max_width ? converted->w : loader->max_width;
+    int height = converted->h < loader->max_height ? converted->h : loader->max_height;
+    if (width != converted->w || height != converted->h) {
+        SDL_Surface* scaled = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGB888);
+        if (scaled && SDL_SoftStretchLinear(converted, NULL, scaled, NULL) == 0) {
+            SDL_FreeSurface(converted);
+            converted = scaled;
+        } else if (scaled) {
+            SDL_FreeSurface(scaled); // Keep the full-size image rather than none
+        }
+    }
+
+    if (loader->format == SDL_PIXELFORMAT_RGB888) return converted;
+
+    SDL_Surface* result = SDL_ConvertSurfaceFormat(converted, loader->format, 0);
+    SDL_FreeSurface(converted);
+    return result;
+}
+
+static SDL_Surface* decode_image(const ImageLoader* loader, const char* path) {
+    long long start = profile_begin();
+    SDL_Surface* surface = NULL;
+    if (is_image_pack_path(path)) {
+        surface = load_image_pack(path, loader->max_width, loader->max_height);
+    } else {
+        surface = IMG_Load(path);
+        if (!surface) printf("Unable to load image %s! SDL_image Error: %s\n", path, IMG_GetError());
+    }
+    if (surface) {
+        surface = prepare_surface(loader, surface);
+        if (!surface) {
+            printf("Unable to convert image %s! SDL Error: %s\n", path, SDL_GetError());
+        }
+    }
+    profile_end(PROFILE_DECODE_IMAGE, start);
+    return surface;
+}
+
+// Job list helpers; callers hold loader->lock
+static ImageJob* find_job(ImageLoader* loader, const char* path) {
+    for (ImageJob* job = loader->jobs; job; job = job->next) {
+        if (strcmp(job->path, path) == 0) return job;
+    }
+    return NULL;
+}
+
+static ImageJob* append_job(ImageLoader* loader, const char* path, ImageJobState state) {
+    ImageJob* job = calloc(1, sizeof(ImageJob));
+    if (!job) return NULL;
+    job->path = strdup(path);
+    if (!job->path) {
+        free(job);
+        return NULL;
+    }
+    job->state = state;
+
+    ImageJob** link = &loader->jobs;
+    while (*link) link = &(*link)->next;
+    *link = job;
+    return job;
+}
+
+static void unlink_job(ImageLoader* loader, ImageJob* job) {
+    ImageJob** link = &loader->jobs;
+    while (*link != job) link = &(*link)->next;
+    *link = job->next;
+}
+
+static void free_job(ImageJob* job) {
+    if (job->surface) {
+        SDL_FreeSurface(job->surface);
+    }
+    free(job->path);
+    free(job);
+}
+
+static int image_worker(void* data) {
+    ImageLoader* loader = data;
+
+    SDL_LockMutex(loader->lock);
+    while (!loader->stopping) {
+        ImageJob* job = loader->jobs;
+        while (job && job->state != IMAGE_JOB_QUEUED) job = job->next;
+        if (!job) {
+            SDL_CondWait(loader->work_ready, loader->lock);
+            continue;
+        }
+
+        // Decoding jobs are never unlinked, so the job outlives the unlocked decode
+        job->state = IMAGE_JOB_DECODING;
+        SDL_UnlockMutex(loader->lock);
+        SDL_Surface* surface = decode_image(loader, job->path);
+        SDL_LockMutex(loader->lock);
+
+        job->surface = surface;
+        job->state = surface ? IMAGE_JOB_DONE : IMAGE_JOB_FAILED;
+        SDL_CondBroadcast(loader->job_done);
+
+        if (surface && loader->done_event != (Uint32)-1) {
+            SDL_Event event;
+            SDL_zero(event);
+            event.type = loader->done_event;
+            SDL_PushEvent(&event);
+        }
+    }
+    SDL_UnlockMutex(loader->lock);
+    return 0;
+}
+
+bool image_loader_init(ImageLoader* loader, int thread_count, int max_width, int max_height, Uint32 format) {
+    memset(loader, 0, sizeof(*loader));
+    loader->max_width = max_width;
+    loader->max_height = max_height;
+    loader->format = format;
+
+    loader->lock = SDL_CreateMutex();
+    loader->work_ready = SDL_CreateCond();
+    loader->job_done = SDL_CreateCond();
+    if (!loader->lock || !loader->work_ready || !loader->job_done) {
+        printf("Error: Could not create image loader: %s\n", SDL_GetError());
+        image_loader_destroy(loader);
+        return false;
+    }
+    loader->done_event = SDL_RegisterEvents(1);
+
+    if (thread_count < 1) thread_count = 1;
+    if (thread_count > IMAGE_LOADER_MAX_THREADS) thread_count = IMAGE_LOADER_MAX_THREADS;
+
+    for (int i = 0; i < thread_count; i++) {
+        SDL_Thread* thread = SDL_CreateThread(image_worker, "image_loader", loader);
+        if (!thread) break;
+        loader->threads[loader->thread_count++] = thread;
+    }
+
+    if (loader->thread_count == 0) {
+        printf("Error: Could not start image loader threads: %s\n", SDL_GetError());
+        image_loader_destroy(loader);
+        return false;
+    }
+    return true;
+}
+
+void image_loader_destroy(ImageLoader* loader) {
+    if (loader->lock) {
+        SDL_LockMutex(loader->lock);
+        loader->stopping = true;
+        SDL_CondBroadcast(loader->work_ready);
+        SDL_UnlockMutex(loader->lock);
+    }
+
+    for (int i = 0; i < loader->thread_count; i++) {
+        SDL_WaitThread(loader->threads[i], NULL);
+    }
+
+    while (loader->jobs) {
+        ImageJob* job = loader->jobs;
+        loader->jobs = job->next;
+        free_job(job);
+    }
+
+    if (loader->job_done) SDL_DestroyCond(loader->job_done);
+    if (loader->work_ready) SDL_DestroyCond(loader->work_ready);
+    if (loader->lock) SDL_DestroyMutex(loader->lock);
+    memset(loader, 0, sizeof(*loader));
+}
+
+// Queue a background decode; paths already queued, decoded or failed are ignored
+void image_loader_request(ImageLoader* loader, const char* path) {
+    if (!path || path[0] == '\0') return;
+
+    SDL_LockMutex(loader->lock);
+    if (!find_job(loader, path) && append_job(loader, path, IMAGE_JOB_QUEUED)) {
+        SDL_CondSignal(loader->work_ready);
+    }
+    SDL_UnlockMutex(loader->lock);
+}
+
+// Drop requests no worker has started, e.g. prefetches for the previous location
+void image_loader_cancel_queued(ImageLoader* loader) {
+    SDL_LockMutex(loader->lock);
+    ImageJob** link = &loader->jobs;
+    while (*link) {
+        ImageJob* job = *link;
+        if (job->state == IMAGE_JOB_QUEUED) {
+            *link = job->next;
+            free_job(job);
+        } else {
+            link = &job->next;
+        }
+    }
+    SDL_UnlockMutex(loader->lock);
+}
+
+// Get the decoded surface for path, blocking if needed; the caller owns the result.
+// A job still waiting in the queue is decoded here rather than behind other prefetches.
+SDL_Surface* image_loader_take(ImageLoader* loader, const char* path) {
+    SDL_LockMutex(loader->lock);
+    ImageJob* job = find_job(loader, path);
+    while (job && job->state == IMAGE_JOB_DECODING) {
+        SDL_CondWait(loader->job_done, loader->lock);
+    }
+
+    SDL_Surface* surface = NULL;
+    bool decode = true;
+    if (job) {
+        if (job->state == IMAGE_JOB_FAILED) {
+            decode = false;
+        } else {
+            if (job->state == IMAGE_JOB_DONE) {
+                surface = job->surface;
+                job->surface = NULL;
+                decode = false;
+            }
+            unlink_job(loader, job);
+            free_job(job);
+        }
+    }
+    SDL_UnlockMutex(loader->lock);
+
+    if (decode) {
+        surface = decode_image(loader, path);
+        if (!surface) {
+            // Remember the failure so the path isn't prefetched again
+            SDL_LockMutex(loader->lock);
+            append_job(loader, path, IMAGE_JOB_FAILED);
+            SDL_UnlockMutex(loader->lock);
+        }
+    }
+    return surface;
+}
+
+// Hand every finished decode to callback, which takes ownership of the surface
+void image_loader_collect(ImageLoader* loader, ImageLoadedCallback callback, void* context) {
+    ImageJob* done = NULL;
+
+    SDL_LockMutex(loader->lock);
+    ImageJob** link = &loader->jobs;
+    while (*link) {
+        ImageJob* job = *link;
+        if (job->state == IMAGE_JOB_DONE) {
+            *link = job->next;
+            job->next = done;
+            done = job;
+        } else {
+            link = &job->next;
+        }
+    }
+    SDL_UnlockMutex(loader->lock);
+
+    // Uploads happen outside the lock so workers keep decoding
+    while (done) {
+        ImageJob* job = done;
+        done = job->next;
+        callback(context, job->path, job->surface);
+        job->surface = NULL;
+        free_job(job);
+    }
+}
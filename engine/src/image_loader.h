@@ -0,0 +1,47 @@
+#ifndef IMAGE_LOADER_H
+#define IMAGE_LOADER_H
+
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+#define IMAGE_LOADER_MAX_THREADS 4
+
+typedef enum {
+    IMAGE_JOB_QUEUED,
+    IMAGE_JOB_DECODING,
+    IMAGE_JOB_DONE,
+    IMAGE_JOB_FAILED
+} ImageJobState;
+
+typedef struct ImageJob {
+    struct ImageJob* next;
+    char* path;
+    SDL_Surface* surface; // Set once the job is done
+    ImageJobState state;
+} ImageJob;
+
+// Background PNG decoding; surfaces are handed back to the main thread for upload
+typedef struct {
+    SDL_Thread* threads[IMAGE_LOADER_MAX_THREADS];
+    int thread_count;
+    int max_width; // Decoded images are shrunk to fit this size
+    int max_height;
+    Uint32 format; // Pixel format of every decoded surface
+    SDL_mutex* lock;
+    SDL_cond* work_ready; // Signalled when a job is queued or the pool stops
+    SDL_cond* job_done; // Broadcast whenever a decode finishes
+    ImageJob* jobs; // Oldest first; failed jobs stay so they aren't retried
+    bool stopping;
+    Uint32 done_event; // Pushed to wake the event loop when a decode finishes
+} ImageLoader;
+
+typedef void (*ImageLoadedCallback)(void* context, const char* path, SDL_Surface* surface);
+
+bool image_loader_init(ImageLoader* loader, int thread_count, int max_width, int max_height, Uint32 format);
+void image_loader_destroy(ImageLoader* loader);
+void image_loader_request(ImageLoader* loader, const char* path);
+void image_loader_cancel_queued(ImageLoader* loader);
+SDL_Surface* image_loader_take(ImageLoader* loader, const char* path);
+void image_loader_collect(ImageLoader* loader, ImageLoadedCallback callback, void* context);
+
+#endif // IMAGE_LOADER_H
@@ -0,0 +1,137 @@
+#include "image_pack.h"
+#include <stdio.h>
+#include <string.h>
+
+// Pack fields are little-endian on disk
+static uint32_t pack_u32(uint32_t value) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap32(value);
+#else
+    return value;
+#endif
+}
+
+// Pixels are read straight into the surface, so big-endian hosts swap them there
+static void swap_pixels(SDL_Surface* surface, int bytes_per_pixel) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    for (int y = 0; y < surface->h; y++) {
+        unsigned char* row = (unsigned char*)surface->pixels + (size_t)y * surface->pitch;
+        for (int x = 0; x < surface->w; x++) {
+            if (bytes_per_pixel == 4) {
+                uint32_t* pixel = (uint32_t*)(row + x * 4);
+                *pixel = __builtin_bswap32(*pixel);
+            } else {
+                uint16_t* pixel = (uint16_t*)(row + x * 2);
+                *pixel = __builtin_bswap16(*pixel);
+            }
+        }
+    }
+#else
+    (void)surface;
+    (void)bytes_per_pixel;
+#endif
+}
+
+bool is_image_pack_path(const char* path) {
+    size_t length = strlen(path);
+    size_t extension = strlen(IMAGE_PACK_EXTENSION);
+    return length > extension && strcmp(path + length - extension, IMAGE_PACK_EXTENSION) == 0;
+}
+
+static Uint32 level_format(uint32_t format) {
+    switch (format) {
+        case IMAGE_PACK_XRGB8888: return SDL_PIXELFORMAT_RGB888;
+        case IMAGE_PACK_RGB565: return SDL_PIXELFORMAT_RGB565;
+        default: return 0;
+    }
+}
+
+// Check each level's pixels lie inside the file; levels are returned in host order
+static bool read_levels(FILE* file, long file_size, ImagePackLevel* levels, int* count) {
+    ImagePackHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, IMAGE_PACK_MAGIC, 4) != 0 ||
+        pack_u32(header.version) != IMAGE_PACK_VERSION) {
+        return false;
+    }
+    *count = (int)pack_u32(header.levels_count);
+    if (*count < 1 || *count > IMAGE_PACK_MAX_LEVELS ||
+        fread(levels, sizeof(ImagePackLevel), *count, file) != (size_t)*count) {
+        return false;
+    }
+
+    for (int i = 0; i < *count; i++) {
+        ImagePackLevel* level = &levels[i];
+        level->width = pack_u32(level->width);
+        level->height = pack_u32(level->height);
+        level->format = pack_u32(level->format);
+        level->offset = pack_u32(level->offset);
+
+        Uint32 format = level_format(level->format);
+        if (!format || level->width < 1 || level->width > IMAGE_PACK_MAX_SIDE ||
+            level->height < 1 || level->height > IMAGE_PACK_MAX_SIDE) {
+            return false;
+        }
+        long long size = (long long)level->width * level->height * SDL_BYTESPERPIXEL(format);
+        if (level->offset > (unsigned long)file_size || size > file_size - (long long)level->offset) return false;
+    }
+    return true;
+}
+
+static const ImagePackLevel* pick_level(const ImagePackLevel* levels, int count, int max_width, int max_height) {
+    const ImagePackLevel* best = &levels[0];
+    for (int i = 0; i < count; i++) {
+        const ImagePackLevel* level = &levels[i];
+        if ((int)level->width < max_width || (int)level->height < max_height) continue;
+        if ((int)best->width < max_width || (int)best->height < max_height ||
+            level->width * level->height < best->width * best->height) {
+            best = level;
+        }
+    }
+    return best;
+}
+
+static bool read_pixels(FILE* file, SDL_Surface* surface, int bytes_per_pixel) {
+    size_t row = (size_t)surface->w * bytes_per_pixel;
+    if ((size_t)surface->pitch == row) {
+        return fread(surface->pixels, row, surface->h, file) == (size_t)surface->h;
+    }
+    for (int y = 0; y < surface->h; y++) {
+        if (fread((unsigned char*)surface->pixels + (size_t)y * surface->pitch, row, 1, file) != 1) return false;
+    }
+    return true;
+}
+
+SDL_Surface* load_image_pack(const char* path, int max_width, int max_height) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        printf("Unable to load image %s! Could not open file\n", path);
+        return NULL;
+    }
+
+    ImagePackLevel levels[IMAGE_PACK_MAX_LEVELS];
+    int count = 0;
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (file_size <= 0 || !read_levels(file, file_size, levels, &count)) {
+        printf("Unable to load image %s! Not a valid image pack\n", path);
+        fclose(file);
+        return NULL;
+    }
+
+    const ImagePackLevel* level = pick_level(levels, count, max_width, max_height);
+    Uint32 format = level_format(level->format);
+    int bytes_per_pixel = SDL_BYTESPERPIXEL(format);
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, level->width, level->height, bytes_per_pixel * 8, format);
+    if (!surface) {
+        printf("Unable to load image %s! SDL Error: %s\n", path, SDL_GetError());
+    } else if (fseek(file, level->offset, SEEK_SET) != 0 || !read_pixels(file, surface, bytes_per_pixel)) {
+        printf("Unable to load image %s! The file is truncated\n", path);
+        SDL_FreeSurface(surface);
+        surface = NULL;
+    } else {
+        swap_pixels(surface, bytes_per_pixel);
+    }
+    fclose(file);
+    return surface;
+}
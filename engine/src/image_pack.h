@@ -0,0 +1,43 @@
+#ifndef IMAGE_PACK_H
+#define IMAGE_PACK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <SDL2/SDL.h>
+
+// Location art pre-converted at export (.agimg), written by
+// AdvGPTFormat.compile_image_pack in the editor: the same picture at a few
+// sizes, largest first, as raw pixels in the renderer's upload format, so
+// loading one is a single read into a surface with nothing to decode.
+// Every field is a little-endian uint32, and so is every XRGB8888 pixel;
+// RGB565 pixels are little-endian uint16s. Rows are packed without padding.
+#define IMAGE_PACK_MAGIC "AGIM"
+#define IMAGE_PACK_VERSION 1
+#define IMAGE_PACK_EXTENSION ".agimg"
+#define IMAGE_PACK_MAX_LEVELS 8
+#define IMAGE_PACK_MAX_SIDE 16384
+
+#define IMAGE_PACK_XRGB8888 0u // SDL_PIXELFORMAT_RGB888
+#define IMAGE_PACK_RGB565 1u // SDL_PIXELFORMAT_RGB565
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t levels_count;
+} ImagePackHeader;
+
+typedef struct {
+    uint32_t width, height;
+    uint32_t format;
+    uint32_t offset; // From the start of the file
+} ImagePackLevel;
+
+bool is_image_pack_path(const char* path);
+
+// The smallest level that still covers max_width x max_height, or the largest
+// level if none does. The surface comes back in the level's own format and
+// size, so the caller converts or shrinks it only if the export did not
+// already match the display.
+SDL_Surface* load_image_pack(const char* path, int max_width, int max_height);
+
+#endif // IMAGE_PACK_H
@@ -0,0 +1,116 @@
+#include "journal.h"
+#include <stdlib.h>
+#include <string.h>
+
+// A resumed session appends to its journal; a fresh one starts it over, since
+// its ticks begin again from zero
+bool journal_open(Journal* journal, const char* filename, bool append) {
+    memset(journal, 0, sizeof(*journal));
+
+    journal->file = fopen(filename, append ? "ab" : "wb");
+    journal->buffer = malloc(JOURNAL_BUFFER_SIZE);
+    if (!journal->file || !journal->buffer) {
+        printf("Error: Could not open journal %s\n", filename);
+        journal_close(journal);
+        return false;
+    }
+
+    fseek(journal->file, 0, SEEK_END);
+    if (ftell(journal->file) == 0) {
+        journal->used = snprintf(journal->buffer, JOURNAL_BUFFER_SIZE, "%s %d\n", JOURNAL_HEADER, JOURNAL_VERSION);
+    }
+    return true;
+}
+
+// Hands the buffered entries to the OS; no fsync, a crash loses at most what
+// the OS had not written yet
+bool journal_flush(Journal* journal) {
+    if (!journal->file || journal->used == 0) return true;
+
+    bool ok = fwrite(journal->buffer, 1, journal->used, journal->file) == journal->used &&
+              fflush(journal->file) == 0;
+    journal->used = 0;
+    if (!ok) printf("Error: Could not write journal\n");
+    return ok;
+}
+
+bool journal_append(Journal* journal, unsigned int tick, const char* command) {
+    if (!journal->file) return false;
+
+    // Entries are single lines; anything past a line break is not part of the command
+    size_t length = strcspn(command, "\r\n");
+    if (length > JOURNAL_COMMAND_LENGTH - 1) length = JOURNAL_COMMAND_LENGTH - 1;
+
+    // Longest entry: ten tick digits, a space, the command and a newline
+    if (journal->used + length + 12 > JOURNAL_BUFFER_SIZE && !journal_flush(journal)) return false;
+
+    journal->used += snprintf(journal->buffer + journal->used, JOURNAL_BUFFER_SIZE - journal->used, "%u %.*s\n",
+                              tick, (int)length, command);
+    return true;
+}
+
+void journal_close(Journal* journal) {
+    journal_flush(journal);
+    if (journal->file) fclose(journal->file);
+    free(journal->buffer);
+    memset(journal, 0, sizeof(*journal));
+}
+
+bool journal_reader_open(JournalReader* reader, const char* filename) {
+    memset(reader, 0, sizeof(*reader));
+
+    reader->file = fopen(filename, "rb");
+    if (!reader->file) {
+        printf("Error: Could not open journal %s\n", filename);
+        return false;
+    }
+
+    char header[128];
+    int version = 0;
+    if (!fgets(header, sizeof(header), reader->file) ||
+        strncmp(header, JOURNAL_HEADER " ", strlen(JOURNAL_HEADER) + 1) != 0 ||
+        sscanf(header + strlen(JOURNAL_HEADER), "%d", &version) != 1 || version != JOURNAL_VERSION) {
+        printf("Error: %s is not a version %d journal\n", filename, JOURNAL_VERSION);
+        journal_reader_close(reader);
+        return false;
+    }
+    reader->line = 1;
+    return true;
+}
+
+// Returns 1 for an entry and 0 at the end. A torn last line from a crash ends
+// the journal; malformed or out-of-order entries anywhere else return -1.
+int journal_read(JournalReader* reader, JournalEntry* entry) {
+    char line[JOURNAL_COMMAND_LENGTH + 16];
+
+    while (fgets(line, sizeof(line), reader->file)) {
+        reader->line++;
+        size_t length = strlen(line);
+        if (length == 0 || line[length - 1] != '\n') {
+            if (feof(reader->file)) return 0;
+            printf("Error: Journal line %d is too long\n", reader->line);
+            return -1;
+        }
+        line[--length] = '\0';
+        if (length > 0 && line[length - 1] == '\r') line[--length] = '\0';
+        if (line[0] == '#' || line[0] == '\0') continue;
+
+        char* command = NULL;
+        unsigned long tick = strtoul(line, &command, 10);
+        if (command == line || *command != ' ' || tick <= reader->last_tick) {
+            printf("Error: Bad journal entry on line %d\n", reader->line);
+            return -1;
+        }
+
+        entry->tick = (unsigned int)tick;
+        snprintf(entry->command, sizeof(entry->command), "%s", command + 1);
+        reader->last_tick = entry->tick;
+        return 1;
+    }
+    return 0;
+}
+
+void journal_reader_close(JournalReader* reader) {
+    if (reader->file) fclose(reader->file);
+    memset(reader, 0, sizeof(*reader));
+}
@@ -0,0 +1,45 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Append-only text log of player input, one "<tick> <command>" line per
+// input after a "# AdventureGPT journal <version>" header. Ticks are the
+// session's GameState.tick after the input was applied, so replaying the
+// entries past a snapshot's tick recovers everything after that snapshot.
+#define JOURNAL_HEADER "# AdventureGPT journal"
+#define JOURNAL_VERSION 1
+#define JOURNAL_BUFFER_SIZE (64 * 1024)
+#define JOURNAL_COMMAND_LENGTH 256
+
+// Entries collect in memory and reach the file in batches: when the buffer
+// fills or the caller flushes, typically once its input goes idle
+typedef struct {
+    FILE* file;
+    char* buffer;
+    size_t used;
+} Journal;
+
+typedef struct {
+    unsigned int tick;
+    char command[JOURNAL_COMMAND_LENGTH];
+} JournalEntry;
+
+typedef struct {
+    FILE* file;
+    int line;
+    unsigned int last_tick;
+} JournalReader;
+
+bool journal_open(Journal* journal, const char* filename, bool append);
+bool journal_append(Journal* journal, unsigned int tick, const char* command);
+bool journal_flush(Journal* journal);
+void journal_close(Journal* journal);
+
+bool journal_reader_open(JournalReader* reader, const char* filename);
+int journal_read(JournalReader* reader, JournalEntry* entry);
+void journal_reader_close(JournalReader* reader);
+
+#endif // JOURNAL_H
@@ -0,0 +1,391 @@
+#include "json_stream.h"
+#include <stdlib.h>
+#include <string.h>
+
+// What the tokenizer accepts next
+enum {
+    STATE_VALUE,        // Any value
+    STATE_ARRAY_FIRST,  // A value or ']'
+    STATE_OBJECT_FIRST, // A key or '}'
+    STATE_KEY,          // A key after ','
+    STATE_COLON,        // ':' after a key
+    STATE_COMMA,        // ',' or the container's closing bracket
+    STATE_DONE          // End of input after the top-level value
+};
+
+bool json_stream_open(JsonStream* stream, const char* filename) {
+    memset(stream, 0, sizeof(*stream));
+    
+    stream->file = fopen(filename, "rb");
+    if (!stream->file) {
+        return false;
+    }
+    
+    stream->chunk = malloc(JSON_STREAM_CHUNK_SIZE);
+    stream->text_capacity = 256;
+    stream->text = malloc(stream->text_capacity);
+    if (!stream->chunk || !stream->text) {
+        json_stream_close(stream);
+        return false;
+    }
+    
+    stream->state = STATE_VALUE;
+    return true;
+}
+
+// Tokenize a buffer that outlives the stream, such as a mapped file, in place
+bool json_stream_open_memory(JsonStream* stream, const char* data, size_t size) {
+    memset(stream, 0, sizeof(*stream));
+    
+    stream->chunk = (char*)data; // Only ever read
+    stream->chunk_length = size;
+    stream->text_capacity = 256;
+    stream->text = malloc(stream->text_capacity);
+    if (!stream->text) {
+        return false;
+    }
+    
+    stream->state = STATE_VALUE;
+    return true;
+}
+
+void json_stream_close(JsonStream* stream) {
+    if (stream->file) {
+        fclose(stream->file);
+        free(stream->chunk);
+    }
+    free(stream->text);
+    memset(stream, 0, sizeof(*stream));
+}
+
+// Restart tokenizing at a file offset where a value begins
+bool json_stream_seek(JsonStream* stream, long offset) {
+    if (!stream->file) {
+        if (offset < 0 || (size_t)offset > stream->chunk_length) {
+            return false;
+        }
+        stream->chunk_pos = offset;
+    } else if (fseek(stream->file, offset, SEEK_SET) != 0) {
+        return false;
+    } else {
+        stream->chunk_length = 0;
+        stream->chunk_pos = 0;
+        stream->chunk_offset = offset;
+    }
+    
+    stream->depth = 0;
+    stream->state = STATE_VALUE;
+    return true;
+}
+
+static int stream_peek(JsonStream* stream) {
+    if (stream->chunk_pos >= stream->chunk_length) {
+        if (!stream->file) {
+            return EOF;
+        }
+        stream->chunk_offset += stream->chunk_length;
+        stream->chunk_length = fread(stream->chunk, 1, JSON_STREAM_CHUNK_SIZE, stream->file);
+        stream->chunk_pos = 0;
+        if (stream->chunk_length == 0) {
+            return EOF;
+        }
+    }
+    return (unsigned char)stream->chunk[stream->chunk_pos];
+}
+
+static int stream_getc(JsonStream* stream) {
+    int c = stream_peek(stream);
+    if (c != EOF) {
+        stream->chunk_pos++;
+    }
+    return c;
+}
+
+static bool text_append(JsonStream* stream, char c) {
+    if (stream->text_length + 1 >= stream->text_capacity) {
+        size_t capacity = stream->text_capacity * 2;
+        char* text = realloc(stream->text, capacity);
+        if (!text) {
+            return false;
+        }
+        stream->text = text;
+        stream->text_capacity = capacity;
+    }
+    
+    stream->text[stream->text_length++] = c;
+    stream->text[stream->text_length] = '\0';
+    return true;
+}
+
+// Append a code point as UTF-8
+static bool text_append_utf8(JsonStream* stream, unsigned long code) {
+    if (code < 0x80) {
+        return text_append(stream, (char)code);
+    }
+    if (code < 0x800) {
+        return text_append(stream, (char)(0xC0 | (code >> 6))) &&
+               text_append(stream, (char)(0x80 | (code & 0x3F)));
+    }
+    if (code < 0x10000) {
+        return text_append(stream, (char)(0xE0 | (code >> 12))) &&
+               text_append(stream, (char)(0x80 | ((code >> 6) & 0x3F))) &&
+               text_append(stream, (char)(0x80 | (code & 0x3F)));
+    }
+    return text_append(stream, (char)(0xF0 | (code >> 18))) &&
+           text_append(stream, (char)(0x80 | ((code >> 12) & 0x3F))) &&
+           text_append(stream, (char)(0x80 | ((code >> 6) & 0x3F))) &&
+           text_append(stream, (char)(0x80 | (code & 0x3F)));
+}
+
+static long read_hex4(JsonStream* stream) {
+    long value = 0;
+    for (int i = 0; i < 4; i++) {
+        int c = stream_getc(stream);
+        value <<= 4;
+        if (c >= '0' && c <= '9') value |= c - '0';
+        else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+        else return -1;
+    }
+    return value;
+}
+
+// Append a run of bytes that needs no unescaping
+static bool text_append_run(JsonStream* stream, const char* run, size_t length) {
+    if (stream->text_length + length >= stream->text_capacity) {
+        size_t capacity = stream->text_capacity * 2;
+        while (stream->text_length + length >= capacity) capacity *= 2;
+        char* text = realloc(stream->text, capacity);
+        if (!text) {
+            return false;
+        }
+        stream->text = text;
+        stream->text_capacity = capacity;
+    }
+    
+    memcpy(stream->text + stream->text_length, run, length);
+    stream->text_length += length;
+    stream->text[stream->text_length] = '\0';
+    return true;
+}
+
+// Read a string body after its opening quote into stream->text, or only
+// check it while skipping
+static bool read_string(JsonStream* stream) {
+    bool keep = !stream->skipping;
+    stream->text_length = 0;
+    stream->text[0] = '\0';
+    
+    for (;;) {
+        if (stream_peek(stream) == EOF) return false;
+        
+        // Take everything up to the next quote or escape at once
+        const char* run = stream->chunk + stream->chunk_pos;
+        size_t available = stream->chunk_length - stream->chunk_pos;
+        size_t length = 0;
+        while (length < available && run[length] != '"' && run[length] != '\\') length++;
+        if (length > 0) {
+            if (keep && !text_append_run(stream, run, length)) return false;
+            stream->chunk_pos += length;
+            continue;
+        }
+        
+        if (stream_getc(stream) == '"') return true;
+        
+        int c = stream_getc(stream);
+        long code;
+        switch (c) {
+            case '"': case '\\': case '/': code = c; break;
+            case 'b': code = '\b'; break;
+            case 'f': code = '\f'; break;
+            case 'n': code = '\n'; break;
+            case 'r': code = '\r'; break;
+            case 't': code = '\t'; break;
+            case 'u': {
+                code = read_hex4(stream);
+                if (code < 0) return false;
+                
+                // Combine a UTF-16 surrogate pair
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    if (stream_getc(stream) != '\\' || stream_getc(stream) != 'u') return false;
+                    long low = read_hex4(stream);
+                    if (low < 0xDC00 || low > 0xDFFF) return false;
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                break;
+            }
+            default:
+                return false;
+        }
+        if (keep && !text_append_utf8(stream, (unsigned long)code)) return false;
+    }
+}
+
+static bool read_number(JsonStream* stream, int first) {
+    stream->text_length = 0;
+    if (!text_append(stream, (char)first)) return false;
+    
+    for (;;) {
+        int c = stream_peek(stream);
+        if (!((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-')) {
+            return true;
+        }
+        stream_getc(stream);
+        if (!text_append(stream, (char)c)) return false;
+    }
+}
+
+static bool read_literal(JsonStream* stream, const char* rest) {
+    while (*rest) {
+        if (stream_getc(stream) != *rest++) return false;
+    }
+    return true;
+}
+
+// Skip whitespace and comments, returning the next significant character
+static int skip_whitespace(JsonStream* stream) {
+    for (;;) {
+        int c = stream_peek(stream);
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            stream_getc(stream);
+            continue;
+        }
+        if (c != '/') {
+            return c;
+        }
+        
+        stream_getc(stream);
+        c = stream_getc(stream);
+        if (c == '/') {
+            while (c != '\n' && c != EOF) c = stream_getc(stream);
+        } else if (c == '*') {
+            int previous = 0;
+            for (;;) {
+                c = stream_getc(stream);
+                if (c == EOF) return EOF;
+                if (previous == '*' && c == '/') break;
+                previous = c;
+            }
+        } else {
+            return '/'; // Not a comment; rejected by the caller
+        }
+    }
+}
+
+// State after a complete value at the current depth
+static int state_after_value(const JsonStream* stream) {
+    return stream->depth == 0 ? STATE_DONE : STATE_COMMA;
+}
+
+static JsonToken fail(JsonStream* stream) {
+    stream->state = STATE_DONE;
+    stream->depth = -1; // Force every later call to fail too
+    return JSON_TOKEN_ERROR;
+}
+
+JsonToken json_stream_next(JsonStream* stream) {
+    if (stream->depth < 0) return JSON_TOKEN_ERROR;
+    
+    for (;;) {
+        int c = skip_whitespace(stream);
+        stream->token_offset = stream->chunk_offset + (long)stream->chunk_pos;
+        
+        if (c == EOF) {
+            return stream->state == STATE_DONE ? JSON_TOKEN_END : fail(stream);
+        }
+        stream_getc(stream);
+        
+        switch (stream->state) {
+            case STATE_DONE:
+                return fail(stream);
+                
+            case STATE_COLON:
+                if (c != ':') return fail(stream);
+                stream->state = STATE_VALUE;
+                continue;
+                
+            case STATE_COMMA: {
+                char open = stream->stack[stream->depth - 1];
+                if (c == ',') {
+                    stream->state = open == '{' ? STATE_KEY : STATE_VALUE;
+                    continue;
+                }
+                if ((c == '}' && open == '{') || (c == ']' && open == '[')) {
+                    stream->depth--;
+                    stream->state = state_after_value(stream);
+                    return c == '}' ? JSON_TOKEN_OBJECT_END : JSON_TOKEN_ARRAY_END;
+                }
+                return fail(stream);
+            }
+                
+            case STATE_OBJECT_FIRST:
+                if (c == '}') {
+                    stream->depth--;
+                    stream->state = state_after_value(stream);
+                    return JSON_TOKEN_OBJECT_END;
+                }
+                /* fall through */
+            case STATE_KEY:
+                if (c != '"' || !read_string(stream)) return fail(stream);
+                stream->state = STATE_COLON;
+                return JSON_TOKEN_KEY;
+                
+            case STATE_ARRAY_FIRST:
+                if (c == ']') {
+                    stream->depth--;
+                    stream->state = state_after_value(stream);
+                    return JSON_TOKEN_ARRAY_END;
+                }
+                /* fall through */
+            case STATE_VALUE:
+                if (c == '{' || c == '[') {
+                    if (stream->depth >= JSON_STREAM_MAX_DEPTH) return fail(stream);
+                    stream->stack[stream->depth++] = (char)c;
+                    stream->state = c == '{' ? STATE_OBJECT_FIRST : STATE_ARRAY_FIRST;
+                    return c == '{' ? JSON_TOKEN_OBJECT_BEGIN : JSON_TOKEN_ARRAY_BEGIN;
+                }
+                
+                JsonToken token;
+                if (c == '"') {
+                    if (!read_string(stream)) return fail(stream);
+                    token = JSON_TOKEN_STRING;
+                } else if (c == '-' || (c >= '0' && c <= '9')) {
+                    if (!read_number(stream, c)) return fail(stream);
+                    token = JSON_TOKEN_NUMBER;
+                } else if (c == 't' && read_literal(stream, "rue")) {
+                    token = JSON_TOKEN_TRUE;
+                } else if (c == 'f' && read_literal(stream, "alse")) {
+                    token = JSON_TOKEN_FALSE;
+                } else if (c == 'n' && read_literal(stream, "ull")) {
+                    token = JSON_TOKEN_NULL;
+                } else {
+                    return fail(stream);
+                }
+                stream->state = state_after_value(stream);
+                return token;
+        }
+    }
+}
+
+// Skip the rest of a value whose first token has already been read
+bool json_stream_skip(JsonStream* stream, JsonToken token) {
+    if (token == JSON_TOKEN_ERROR || token == JSON_TOKEN_END) return false;
+    if (token != JSON_TOKEN_OBJECT_BEGIN && token != JSON_TOKEN_ARRAY_BEGIN) return true;
+    
+    int depth = 1;
+    while (depth > 0) {
+        token = json_stream_next(stream);
+        if (token == JSON_TOKEN_ERROR || token == JSON_TOKEN_END) return false;
+        if (token == JSON_TOKEN_OBJECT_BEGIN || token == JSON_TOKEN_ARRAY_BEGIN) depth++;
+        if (token == JSON_TOKEN_OBJECT_END || token == JSON_TOKEN_ARRAY_END) depth--;
+    }
+    return true;
+}
+
+// Skip the next value without decoding the strings in it
+bool json_stream_skip_next(JsonStream* stream) {
+    stream->skipping = true;
+    bool ok = json_stream_skip(stream, json_stream_next(stream));
+    stream->skipping = false;
+    return ok;
+}
@@ -0,0 +1,55 @@
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define JSON_STREAM_CHUNK_SIZE 65536
+#define JSON_STREAM_MAX_DEPTH 64
+
+typedef enum {
+    JSON_TOKEN_ERROR,
+    JSON_TOKEN_END, // End of input after the top-level value
+    JSON_TOKEN_OBJECT_BEGIN,
+    JSON_TOKEN_OBJECT_END,
+    JSON_TOKEN_ARRAY_BEGIN,
+    JSON_TOKEN_ARRAY_END,
+    JSON_TOKEN_KEY,
+    JSON_TOKEN_STRING,
+    JSON_TOKEN_NUMBER,
+    JSON_TOKEN_TRUE,
+    JSON_TOKEN_FALSE,
+    JSON_TOKEN_NULL
+} JsonToken;
+
+// Pull tokenizer over a file read in fixed-size chunks. Memory use is the
+// chunk plus the longest single string, independent of the file size.
+// C and C++ style comments are skipped, as json-c did.
+typedef struct {
+    FILE* file; // NULL when tokenizing a buffer in memory
+    char* chunk; // The whole buffer in memory mode, not owned
+    size_t chunk_length;
+    size_t chunk_pos;
+    long chunk_offset; // File offset of chunk[0]
+    long token_offset; // File offset where the last token started
+    
+    char* text; // Decoded key/string/number text of the last token
+    size_t text_length;
+    size_t text_capacity;
+    
+    char stack[JSON_STREAM_MAX_DEPTH]; // '{' or '[' per open container
+    int depth;
+    int state;
+    bool skipping; // Check strings without decoding them into text
+} JsonStream;
+
+bool json_stream_open(JsonStream* stream, const char* filename);
+bool json_stream_open_memory(JsonStream* stream, const char* data, size_t size);
+void json_stream_close(JsonStream* stream);
+bool json_stream_seek(JsonStream* stream, long offset);
+JsonToken json_stream_next(JsonStream* stream);
+bool json_stream_skip(JsonStream* stream, JsonToken token);
+bool json_stream_skip_next(JsonStream* stream);
+
+#endif // JSON_STREAM_H
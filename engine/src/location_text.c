@@ -0,0 +1,210 @@
+#include "location_text.h"
+#include "json_stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FIELD_MISSING ((size_t)-1)
+
+typedef struct {
+    int location; // INVALID_LOCATION marks a free entry
+    unsigned int last_used; // Cache clock at the last lookup
+    size_t bytes;
+    char* text; // Every text field back to back, NUL-terminated
+    Location record; // The world record with its text pointing into text
+} TextEntry;
+
+// Small enough that lookups just scan it
+struct LocationTextCache {
+    TextEntry* entries;
+    int capacity;
+    int last; // Entry of the previous lookup, checked first
+    unsigned int clock;
+    size_t budget;
+    LocationTextStats stats;
+};
+
+static const char* const field_keys[LOCATION_TEXT_FIELDS] = {
+    [LOCATION_TEXT_TITLE] = "title",
+    [LOCATION_TEXT_DESCRIPTION] = "description",
+    [LOCATION_TEXT_IMAGE] = "image",
+    [LOCATION_TEXT_FIRST_VISIT] = "first_visit_text",
+};
+
+LocationTextField location_text_field(const char* key) {
+    for (int i = 0; i < LOCATION_TEXT_FIELDS; i++) {
+        if (strcmp(key, field_keys[i]) == 0) return (LocationTextField)i;
+    }
+    return LOCATION_TEXT_NONE;
+}
+
+LocationTextCache* create_location_text_cache(int rooms, size_t budget) {
+    if (rooms < 1) rooms = 1;
+
+    LocationTextCache* cache = calloc(1, sizeof(LocationTextCache));
+    if (cache) cache->entries = calloc(rooms, sizeof(TextEntry));
+    if (!cache || !cache->entries) {
+        printf("Error: Could not allocate location text cache\n");
+        free(cache);
+        return NULL;
+    }
+
+    for (int i = 0; i < rooms; i++) {
+        cache->entries[i].location = INVALID_LOCATION;
+    }
+    cache->capacity = rooms;
+    cache->budget = budget;
+    return cache;
+}
+
+void free_location_text_cache(LocationTextCache* cache) {
+    if (!cache) return;
+    for (int i = 0; i < cache->capacity; i++) {
+        free(cache->entries[i].text);
+    }
+    free(cache->entries);
+    free(cache);
+}
+
+// Re-read the location's object from the mapped source, keeping only its text
+static bool decode_text(const World* world, int location_index, TextEntry* entry) {
+    JsonStream stream;
+    if (!json_stream_open_memory(&stream, world->mapping, world->mapping_size)) return false;
+
+    size_t fields[LOCATION_TEXT_FIELDS];
+    for (int i = 0; i < LOCATION_TEXT_FIELDS; i++) {
+        fields[i] = FIELD_MISSING;
+    }
+
+    char* text = NULL;
+    size_t length = 0;
+    JsonToken token = JSON_TOKEN_ERROR;
+    bool ok = json_stream_seek(&stream, world->text_offsets[location_index]) &&
+              json_stream_next(&stream) == JSON_TOKEN_OBJECT_BEGIN;
+    while (ok && (token = json_stream_next(&stream)) == JSON_TOKEN_KEY) {
+        LocationTextField field = location_text_field(stream.text);
+        if (field == LOCATION_TEXT_NONE) {
+            ok = json_stream_skip_next(&stream); // Exits, items and flags are already in the world
+            continue;
+        }
+        token = json_stream_next(&stream);
+        if (token != JSON_TOKEN_STRING) {
+            ok = json_stream_skip(&stream, token);
+            continue;
+        }
+
+        // A repeated key replaces the earlier value, as in the eager loader
+        char* grown = realloc(text, length + stream.text_length + 1);
+        if (!grown) {
+            ok = false;
+            break;
+        }
+        text = grown;
+        memcpy(text + length, stream.text, stream.text_length + 1);
+        fields[field] = length;
+        length += stream.text_length + 1;
+    }
+    ok = ok && token == JSON_TOKEN_OBJECT_END;
+    json_stream_close(&stream);
+    if (!ok) {
+        free(text);
+        return false;
+    }
+
+    const char** targets[LOCATION_TEXT_FIELDS] = {
+        [LOCATION_TEXT_TITLE] = &entry->record.title,
+        [LOCATION_TEXT_DESCRIPTION] = &entry->record.description,
+        [LOCATION_TEXT_IMAGE] = &entry->record.image_path,
+        [LOCATION_TEXT_FIRST_VISIT] = &entry->record.first_visit_text,
+    };
+    entry->record = world->locations[location_index];
+    for (int i = 0; i < LOCATION_TEXT_FIELDS; i++) {
+        *targets[i] = fields[i] == FIELD_MISSING ? "" : text + fields[i];
+    }
+    entry->location = location_index;
+    entry->text = text;
+    entry->bytes = length;
+    return true;
+}
+
+static void evict_entry(LocationTextCache* cache, TextEntry* entry) {
+    free(entry->text);
+    entry->text = NULL;
+    entry->location = INVALID_LOCATION;
+    cache->stats.rooms--;
+    cache->stats.bytes -= entry->bytes;
+    cache->stats.evictions++;
+}
+
+static TextEntry* least_recent_entry(LocationTextCache* cache) {
+    TextEntry* oldest = NULL;
+    for (int i = 0; i < cache->capacity; i++) {
+        TextEntry* entry = &cache->entries[i];
+        if (entry->location == INVALID_LOCATION) continue;
+        if (!oldest || cache->clock - entry->last_used > cache->clock - oldest->last_used) oldest = entry;
+    }
+    return oldest;
+}
+
+// Evict the least recently shown rooms until at most budget bytes of text
+// remain, e.g. under memory pressure. Records returned earlier may go with them.
+void trim_location_text_cache(LocationTextCache* cache, size_t budget) {
+    if (!cache) return;
+    while (cache->stats.rooms > 0 && cache->stats.bytes > budget) {
+        evict_entry(cache, least_recent_entry(cache));
+    }
+}
+
+static TextEntry* insert_entry(LocationTextCache* cache, const World* world, int location_index) {
+    TextEntry decoded;
+    if (!decode_text(world, location_index, &decoded)) {
+        printf("Error: Could not read the text of location %s\n", world->locations[location_index].id);
+        return NULL;
+    }
+
+    // Make room under the budget and in the table; a room bigger than the
+    // whole budget is still kept until the next one replaces it
+    trim_location_text_cache(cache, cache->budget > decoded.bytes ? cache->budget - decoded.bytes : 0);
+    if (cache->stats.rooms == cache->capacity) {
+        evict_entry(cache, least_recent_entry(cache));
+    }
+
+    TextEntry* entry = cache->entries;
+    while (entry->location != INVALID_LOCATION) entry++;
+    *entry = decoded;
+    cache->stats.rooms++;
+    cache->stats.bytes += decoded.bytes;
+    cache->stats.decodes++;
+    return entry;
+}
+
+const Location* location_text(LocationTextCache* cache, const World* world, int location_index) {
+    if (!world || location_index < 0 || location_index >= world->locations_count) return NULL;
+
+    const Location* record = &world->locations[location_index];
+    if (!world->text_offsets || !cache) return record;
+
+    TextEntry* entry = &cache->entries[cache->last];
+    if (entry->location != location_index) {
+        entry = NULL;
+        for (int i = 0; i < cache->capacity && !entry; i++) {
+            if (cache->entries[i].location == location_index) entry = &cache->entries[i];
+        }
+        if (!entry) entry = insert_entry(cache, world, location_index);
+        if (!entry) return record; // Exits and items still work without the text
+        cache->last = (int)(entry - cache->entries);
+    }
+
+    entry->last_used = ++cache->clock;
+    return &entry->record;
+}
+
+LocationTextStats location_text_stats(const LocationTextCache* cache) {
+    LocationTextStats none = {0};
+    return cache ? cache->stats : none;
+}
+
+size_t location_text_cache_bytes(const LocationTextCache* cache) {
+    if (!cache) return 0;
+    return sizeof(LocationTextCache) + cache->capacity * sizeof(TextEntry) + cache->stats.bytes;
+}
@@ -0,0 +1,43 @@
+#ifndef LOCATION_TEXT_H
+#define LOCATION_TEXT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "adventure_engine.h"
+
+// Default size of a session's cache: rooms kept decoded, and the text bytes
+// past which the least recently shown rooms are evicted
+#define LOCATION_TEXT_CACHE_ROOMS 64
+#define LOCATION_TEXT_CACHE_BYTES (256 * 1024)
+
+// Location object keys that hold text, which lazy loading leaves in the file
+typedef enum {
+    LOCATION_TEXT_NONE = -1,
+    LOCATION_TEXT_TITLE,
+    LOCATION_TEXT_DESCRIPTION,
+    LOCATION_TEXT_IMAGE,
+    LOCATION_TEXT_FIRST_VISIT,
+    LOCATION_TEXT_FIELDS
+} LocationTextField;
+
+typedef struct {
+    int rooms; // Locations decoded right now
+    size_t bytes; // Text they hold
+    long decodes; // Cache misses so far
+    long evictions;
+} LocationTextStats;
+
+LocationTextField location_text_field(const char* key);
+
+// A cache belongs to one thread. Locations of a world loaded with
+// load_world_lazy come back as a copy of the world record with its text filled
+// in, valid until the next location_text call on the same cache; other worlds'
+// records already hold their text and are returned directly.
+LocationTextCache* create_location_text_cache(int rooms, size_t budget);
+const Location* location_text(LocationTextCache* cache, const World* world, int location_index);
+void trim_location_text_cache(LocationTextCache* cache, size_t budget);
+LocationTextStats location_text_stats(const LocationTextCache* cache);
+size_t location_text_cache_bytes(const LocationTextCache* cache); // Table and decoded text
+void free_location_text_cache(LocationTextCache* cache);
+
+#endif // LOCATION_TEXT_H
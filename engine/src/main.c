@@ -5,28 +5,119 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_ttf.h>
-#include <json-c/json.h>
 #include "adventure_engine.h"
+#include "command_queue.h"
+#include "file_watch.h"
+#include "journal.h"
+#include "location_text.h"
+#include "profiler.h"
+#include "snapshot.h"
+#include "glyph_atlas.h"
+#include "render_cache.h"
+#include "texture_manager.h"
+#include "world_reload.h"
 
 #define WINDOW_WIDTH 1024
 #define WINDOW_HEIGHT 768
 #define TEXT_AREA_HEIGHT 200
 #define MAX_INPUT_LENGTH 256
+#define FRAME_INTERVAL_MS 16 // Redraw pacing while animating without vsync
+#define COMMAND_QUEUE_CAPACITY 64
+#define VIEW_FRESH 4 // Set in CommandPipeline.latest until the renderer takes that view
+#define VIEW_INDEX_MASK 3
+#define OVERLAY_WIDTH 600
+#define RELOAD_RETRY_MS 500 // Wait before loading a game file that failed mid-save again
+#define RELOAD_ATTEMPTS 4 // Loads of one change before waiting for the next
+
+typedef struct {
+    bool vsync;
+    size_t texture_budget; // Bytes of location textures kept resident
+    bool low_color; // Store location art as RGB565
+    const char* save_file; // Resume from and autosave to this snapshot, or NULL
+    const char* journal_file; // Replay the tail of and append every command to this journal, or NULL
+    bool lazy_text; // Decode location text when a location is first shown
+    const char* trace_file; // Write a Chrome trace of the profiled zones here on exit, or NULL
+    bool stats; // Print memory use once the game and first location are loaded
+    bool watch; // Reload the game file whenever it changes
+} EngineOptions;
+
+// What the renderer needs from the game, published by the engine thread after every command
+typedef struct {
+    const World* world; // The world location_index refers to
+    int location_index;
+    bool quit; // The player asked to quit
+} GameView;
+
+// A changed game file, noticed by the render thread, then loaded, diffed and
+// adopted by the engine thread, which carries the session over to the new world
+typedef struct {
+    World* world; // NULL if loading failed; owned by the session once adopted, else freed with the reload
+    World* previous; // The world it replaced, freed once the renderer stops drawing it
+    WorldDiff diff;
+    bool adopted;
+    SDL_atomic_t done; // Set by the engine thread once it has taken the reload, adopted or not
+    Uint64 started; // Performance counter when the change was noticed
+} WorldReload;
+
+// Player commands run on an engine thread: producers push input into a
+// lock-free queue, and the engine publishes views through a triple buffer,
+// so neither the render loop nor the engine ever waits on the other
+typedef struct {
+    SDL_Thread *thread;
+    CommandQueue commands;
+    SDL_sem *pending; // Posted once per queued command
+    SDL_atomic_t stopping;
+    GameView views[3];
+    SDL_atomic_t latest; // Index of the newest view, | VIEW_FRESH until taken
+    int write_index; // Engine thread only
+    int read_index; // Render thread only
+    SDL_atomic_t event_pending; // A view_event is queued and not yet handled
+    Uint32 view_event;
+    const char* save_file; // Autosaved after every command that changes the game
+    Journal journal; // Engine thread only; flushed whenever the queue runs dry
+    void* reload; // A WorldReload for the engine thread to take before its next command, or NULL
+} CommandPipeline;
+
+// --watch: the game file reloaded when it changes. game_file and lazy_text are
+// set before the engine thread starts, which reads them to load the file.
+typedef struct {
+    const char* game_file; // NULL when not watching
+    bool lazy_text;
+    FileWatch file;
+    WorldReload* pending; // Handed to the engine thread and not yet finished by the renderer
+    int attempts; // Loads left for the latest change until one succeeds
+    Uint32 retry_at; // SDL_GetTicks() time of the next of them
+} GameWatch;
 
 typedef struct {
     SDL_Window *window;
     SDL_Renderer *renderer;
     TTF_Font *font;
-    SDL_Texture *location_image;
+    GlyphAtlas atlas;
+    LayoutCache layouts;
+    LocationTextCache *text; // Location text decoded for the render thread; lazy worlds only
+    TextLayout scratch_layout; // Reused by render_text for one-off strings
+    TextureManager textures;
+    SDL_Texture *location_image; // Owned by textures
+    SDL_Texture *scene; // Everything but the input prompt; NULL without render target support
+    int scene_location; // Location composed into scene, or INVALID_LOCATION
+    const World* world; // What the renderer draws; replaced when a view from a reloaded world arrives
+    GameView view; // Latest game state from the engine thread
+    bool dirty; // Something on screen changed since the last present
+    bool animating; // Redraw every frame while set, not only on input
+    bool vsync; // Presents are paced by the display
+    bool overlay; // F3 timing overlay; redraws every frame while shown
     char input_buffer[MAX_INPUT_LENGTH];
     int input_length;
     bool running;
 } GameRenderer;
 
-GameState *game_state = NULL;
+GameState *game_state = NULL; // Owned by the engine thread while it runs
 GameRenderer renderer = {0};
+CommandPipeline pipeline = {0};
+GameWatch watch = {0};
 
-bool init_renderer() {
+bool init_renderer(const EngineOptions* options) {
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         printf("SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
         return false;
@@ -56,7 +147,13 @@ bool init_renderer() {
         return false;
     }
 
-    renderer.renderer = SDL_CreateRenderer(renderer.window, -1, SDL_RENDERER_ACCELERATED);
+    Uint32 renderer_flags = SDL_RENDERER_ACCELERATED;
+    if (options->vsync) {
+        renderer_flags |= SDL_RENDERER_PRESENTVSYNC;
+    }
+    renderer.vsync = options->vsync;
+    
+    renderer.renderer = SDL_CreateRenderer(renderer.window, -1, renderer_flags);
     if (renderer.renderer == NULL) {
         printf("Renderer could not be created! SDL_Error: %s\n", SDL_GetError());
         return false;
@@ -80,14 +177,40 @@ bool init_renderer() {
         }
     }
 
+    // Rasterize the font once; all text is drawn from this atlas
+    if (!glyph_atlas_init(&renderer.atlas, renderer.renderer, renderer.font)) {
+        return false;
+    }
+
+    // Compose the static scene off-screen so idle frames only redraw the prompt
+    if (SDL_RenderTargetSupported(renderer.renderer)) {
+        renderer.scene = SDL_CreateTexture(renderer.renderer, SDL_PIXELFORMAT_RGB888, SDL_TEXTUREACCESS_TARGET,
+                                           WINDOW_WIDTH, WINDOW_HEIGHT);
+    }
+    renderer.scene_location = INVALID_LOCATION;
+    renderer.dirty = true;
+
+    // Location art is only ever drawn into the image area, so it's stored at that size
+    if (!texture_manager_init(&renderer.textures, renderer.renderer, WINDOW_WIDTH, WINDOW_HEIGHT - TEXT_AREA_HEIGHT,
+                              options->texture_budget, options->low_color)) {
+        return false;
+    }
+
     renderer.running = true;
     return true;
 }
 
 void cleanup_renderer() {
-    if (renderer.location_image) {
-        SDL_DestroyTexture(renderer.location_image);
+    texture_manager_destroy(&renderer.textures);
+    renderer.location_image = NULL;
+    if (renderer.scene) {
+        SDL_DestroyTexture(renderer.scene);
     }
+    layout_cache_destroy(&renderer.layouts);
+    free_location_text_cache(renderer.text);
+    renderer.text = NULL;
+    text_layout_free(&renderer.scratch_layout);
+    glyph_atlas_destroy(&renderer.atlas);
     if (renderer.font) {
         TTF_CloseFont(renderer.font);
     }
@@ -104,100 +227,66 @@ void cleanup_renderer() {
 }
 
 SDL_Texture* load_location_image(const char* image_path) {
-    if (!image_path || strlen(image_path) == 0) {
-        return NULL;
-    }
-    
-    SDL_Surface* surface = IMG_Load(image_path);
-    if (!surface) {
-        printf("Unable to load image %s! SDL_image Error: %s\n", image_path, IMG_GetError());
-        return NULL;
-    }
+    long long start = profile_begin();
+    SDL_Texture* texture = texture_manager_get(&renderer.textures, image_path);
+    profile_end(PROFILE_LOAD_LOCATION_IMAGE, start);
+    return texture;
+}
+
+// Engine memory for the session, then what the renderer holds on top of it
+static void print_renderer_memory() {
+    EngineMemoryStats stats = engine_memory_stats(game_state);
+    print_memory_stats(&stats);
     
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer.renderer, surface);
-    SDL_FreeSurface(surface);
+    const TextureCache* textures = &renderer.textures.cache;
+    printf("  Renderer: %d textures %.1f of %.0f MiB, glyph atlas %.1f KiB, layouts %.1f KiB, text cache %.1f KiB\n",
+           textures->count, textures->bytes / (1024.0 * 1024.0), textures->budget / (1024.0 * 1024.0),
+           glyph_atlas_bytes(&renderer.atlas) / 1024.0, layout_cache_bytes(&renderer.layouts) / 1024.0,
+           location_text_cache_bytes(renderer.text) / 1024.0);
+}
+
+// Start decoding the art of every room reachable in one move
+static void prefetch_exit_images(int location_index) {
+    texture_manager_cancel_prefetch(&renderer.textures);
     
-    if (!texture) {
-        printf("Unable to create texture from %s! SDL Error: %s\n", image_path, SDL_GetError());
+    // Looking up a target's text may evict the current room's, so walk the world record
+    const World* world = renderer.world;
+    const Location* location = &world->locations[location_index];
+    for (int i = 0; i < location->exits_count; i++) {
+        int target = location->exits[i].target_index;
+        if (target != INVALID_LOCATION) {
+            texture_manager_prefetch(&renderer.textures, location_text(renderer.text, world, target)->image_path);
+        }
     }
-    
-    return texture;
 }
 
-void render_text(const char* text, int x, int y, int max_width, SDL_Color color) {
-    if (!text || strlen(text) == 0) return;
-    
-    // Simple word wrapping - split by words and render line by line
-    char* text_copy = strdup(text);
-    char* word = strtok(text_copy, " ");
-    char line_buffer[512] = "";
-    int line_y = y;
-    int line_height = TTF_FontHeight(renderer.font);
-    
-    while (word != NULL) {
-        char test_line[512];
-        if (strlen(line_buffer) > 0) {
-            snprintf(test_line, sizeof(test_line), "%s %s", line_buffer, word);
-        } else {
-            strncpy(test_line, word, sizeof(test_line) - 1);
-            test_line[sizeof(test_line) - 1] = '\0';
-        }
-        
-        int text_width;
-        TTF_SizeText(renderer.font, test_line, &text_width, NULL);
-        
-        if (text_width <= max_width) {
-            strncpy(line_buffer, test_line, sizeof(line_buffer) - 1);
-            line_buffer[sizeof(line_buffer) - 1] = '\0';
-        } else {
-            // Render current line and start new one
-            if (strlen(line_buffer) > 0) {
-                SDL_Surface* text_surface = TTF_RenderText_Solid(renderer.font, line_buffer, color);
-                if (text_surface) {
-                    SDL_Texture* text_texture = SDL_CreateTextureFromSurface(renderer.renderer, text_surface);
-                    if (text_texture) {
-                        SDL_Rect dest_rect = {x, line_y, text_surface->w, text_surface->h};
-                        SDL_RenderCopy(renderer.renderer, text_texture, NULL, &dest_rect);
-                        SDL_DestroyTexture(text_texture);
-                    }
-                    SDL_FreeSurface(text_surface);
-                }
-                line_y += line_height + 2;
-            }
-            strncpy(line_buffer, word, sizeof(line_buffer) - 1);
-            line_buffer[sizeof(line_buffer) - 1] = '\0';
-        }
-        
-        word = strtok(NULL, " ");
-    }
-    
-    // Render final line
-    if (strlen(line_buffer) > 0) {
-        SDL_Surface* text_surface = TTF_RenderText_Solid(renderer.font, line_buffer, color);
-        if (text_surface) {
-            SDL_Texture* text_texture = SDL_CreateTextureFromSurface(renderer.renderer, text_surface);
-            if (text_texture) {
-                SDL_Rect dest_rect = {x, line_y, text_surface->w, text_surface->h};
-                SDL_RenderCopy(renderer.renderer, text_texture, NULL, &dest_rect);
-                SDL_DestroyTexture(text_texture);
-            }
-            SDL_FreeSurface(text_surface);
-        }
+static void show_location_image(int location_index) {
+    renderer.location_image = NULL;
+    const Location* location = location_text(renderer.text, renderer.world, location_index);
+    if (location) {
+        renderer.location_image = load_location_image(location->image_path);
+        prefetch_exit_images(location_index);
     }
+    texture_manager_pin(&renderer.textures, renderer.location_image);
+}
+
+void render_text(const char* text, int x, int y, int max_width, SDL_Color color) {
+    if (!text || text[0] == '\0') return;
     
-    free(text_copy);
+    long long start = profile_begin();
+    if (text_layout_build(&renderer.scratch_layout, &renderer.atlas, text, max_width)) {
+        text_layout_draw(&renderer.scratch_layout, &renderer.atlas, x, y, color);
+        glyph_atlas_flush(&renderer.atlas, renderer.renderer);
+    }
+    profile_end(PROFILE_RENDER_TEXT, start);
 }
 
-void render_game() {
+// Draw the image, panels and location text: everything that only changes on a move
+static void draw_scene(int location_index) {
     // Clear screen
     SDL_SetRenderDrawColor(renderer.renderer, 0, 0, 0, 255);
     SDL_RenderClear(renderer.renderer);
     
-    if (!game_state) return;
-    
-    Location* current_location = get_current_location(game_state);
-    if (!current_location) return;
-    
     // Render location image (top half of screen)
     if (renderer.location_image) {
         SDL_Rect image_rect = {0, 0, WINDOW_WIDTH, WINDOW_HEIGHT - TEXT_AREA_HEIGHT};
@@ -222,6 +311,10 @@ void render_game() {
     SDL_Rect text_area = {0, WINDOW_HEIGHT - TEXT_AREA_HEIGHT, WINDOW_WIDTH, TEXT_AREA_HEIGHT};
     SDL_RenderFillRect(renderer.renderer, &text_area);
     
+    const LocationLayout* layout = layout_cache_get(&renderer.layouts, &renderer.atlas, renderer.world,
+                                                    renderer.text, location_index, WINDOW_WIDTH - 20);
+    if (!layout) return;
+    
     // Render location title and description
     SDL_Color white = {255, 255, 255, 255};
     SDL_Color yellow = {255, 255, 0, 255};
@@ -229,132 +322,577 @@ void render_game() {
     int text_y = WINDOW_HEIGHT - TEXT_AREA_HEIGHT + 10;
     
     // Title
-    render_text(current_location->title, 10, text_y, WINDOW_WIDTH - 20, yellow);
+    text_layout_draw(&layout->title, &renderer.atlas, 10, text_y, yellow);
     text_y += 30;
     
     // Description
-    render_text(current_location->description, 10, text_y, WINDOW_WIDTH - 20, white);
+    text_layout_draw(&layout->description, &renderer.atlas, 10, text_y, white);
     text_y += 60;
     
     // Show available exits
-    if (current_location->exits_count > 0) {
-        char exits_text[256] = "Exits: ";
-        for (int i = 0; i < current_location->exits_count; i++) {
-            if (i > 0) strcat(exits_text, ", ");
-            strcat(exits_text, current_location->exits[i].direction);
+    text_layout_draw(&layout->exits, &renderer.atlas, 10, text_y, white);
+    
+    glyph_atlas_flush(&renderer.atlas, renderer.renderer);
+}
+
+static double zone_ms(long long ns) {
+    return ns / 1e6;
+}
+
+static double zone_average_ms(const ProfileZoneStats* stats) {
+    return stats->count > 0 ? zone_ms(stats->total_ns / stats->count) : 0.0;
+}
+
+static double hit_percent(unsigned long hits, unsigned long misses) {
+    return hits + misses > 0 ? 100.0 * hits / (hits + misses) : 100.0;
+}
+
+// Frame and command timings with cache occupancy, drawn over the scene
+static void draw_overlay() {
+    ProfileZoneStats frame = profile_zone_stats(PROFILE_RENDER_FRAME);
+    ProfileZoneStats present = profile_zone_stats(PROFILE_RENDER_PRESENT);
+    ProfileZoneStats text = profile_zone_stats(PROFILE_RENDER_TEXT);
+    ProfileZoneStats command = profile_zone_stats(PROFILE_EXECUTE_COMMAND);
+    ProfileZoneStats image = profile_zone_stats(PROFILE_LOAD_LOCATION_IMAGE);
+    ProfileZoneStats decode = profile_zone_stats(PROFILE_DECODE_IMAGE);
+    ProfileZoneStats load = profile_zone_stats(PROFILE_LOAD_WORLD);
+    const TextureManager* textures = &renderer.textures;
+    const GlyphAtlas* atlas = &renderer.atlas;
+    LocationTextStats cached = location_text_stats(renderer.text);
+    
+    char lines[8][128];
+    int count = 0;
+    snprintf(lines[count++], sizeof(lines[0]), "Frame %.2f ms (avg %.2f, max %.2f), present %.2f ms",
+             zone_ms(frame.last_ns), zone_average_ms(&frame), zone_ms(frame.max_ns), zone_ms(present.last_ns));
+    snprintf(lines[count++], sizeof(lines[0]), "Text %.3f ms avg, commands %ld at %.3f ms avg, load %.1f ms",
+             zone_average_ms(&text), command.count, zone_average_ms(&command), zone_ms(load.total_ns));
+    snprintf(lines[count++], sizeof(lines[0]), "Textures %d, %.1f of %.0f MiB, %.0f%% hits",
+             textures->cache.count, textures->cache.bytes / (1024.0 * 1024.0),
+             textures->cache.budget / (1024.0 * 1024.0), hit_percent(textures->hits, textures->misses));
+    snprintf(lines[count++], sizeof(lines[0]), "Image load %.2f ms avg, decode %.2f ms avg (%ld decoded)",
+             zone_average_ms(&image), zone_average_ms(&decode), decode.count);
+    snprintf(lines[count++], sizeof(lines[0]), "Layouts %.0f%% hits (%lu built), glyphs %lu drawn, %lu missing",
+             hit_percent(renderer.layouts.hits, renderer.layouts.misses), renderer.layouts.misses,
+             atlas->glyphs_drawn, atlas->glyphs_missing);
+    if (renderer.text) {
+        snprintf(lines[count++], sizeof(lines[0]), "Location text %d rooms, %.0f KiB (%ld decoded, %ld evicted)",
+                 cached.rooms, cached.bytes / 1024.0, cached.decodes, cached.evictions);
+    }
+    
+    int line_height = atlas->line_height + TEXT_LINE_SPACING;
+    SDL_Rect box = {10, 10, OVERLAY_WIDTH, count * line_height + 12};
+    SDL_SetRenderDrawBlendMode(renderer.renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer.renderer, 0, 0, 0, 192);
+    SDL_RenderFillRect(renderer.renderer, &box);
+    SDL_SetRenderDrawBlendMode(renderer.renderer, SDL_BLENDMODE_NONE);
+    
+    SDL_Color green = {128, 255, 128, 255};
+    for (int i = 0; i < count; i++) {
+        render_text(lines[i], box.x + 6, box.y + 6 + i * line_height, OVERLAY_WIDTH - 12, green);
+    }
+}
+
+void render_game() {
+    if (!renderer.world) return;
+    
+    int location_index = renderer.view.location_index;
+    if (location_index == INVALID_LOCATION) {
+        renderer.dirty = false; // Nothing to draw; don't spin the event loop
+        return;
+    }
+    
+    // Nothing changed since the last present
+    if (!renderer.dirty && location_index == renderer.scene_location) return;
+    
+    long long start = profile_begin();
+    if (renderer.scene) {
+        // Recompose the static scene only when the location changes
+        if (location_index != renderer.scene_location) {
+            SDL_SetRenderTarget(renderer.renderer, renderer.scene);
+            draw_scene(location_index);
+            SDL_SetRenderTarget(renderer.renderer, NULL);
         }
-        render_text(exits_text, 10, text_y, WINDOW_WIDTH - 20, white);
-        text_y += 25;
+        SDL_RenderCopy(renderer.renderer, renderer.scene, NULL, NULL);
+    } else {
+        draw_scene(location_index);
     }
+    renderer.scene_location = location_index;
     
     // Input prompt
+    SDL_Color white = {255, 255, 255, 255};
     char prompt[512];
     snprintf(prompt, sizeof(prompt), "> %s", renderer.input_buffer);
     render_text(prompt, 10, WINDOW_HEIGHT - 30, WINDOW_WIDTH - 20, white);
     
+    if (renderer.overlay) {
+        draw_overlay();
+    }
+    
+    long long present_start = profile_begin();
     SDL_RenderPresent(renderer.renderer);
+    profile_end(PROFILE_RENDER_PRESENT, present_start);
+    renderer.dirty = false;
+    profile_end(PROFILE_RENDER_FRAME, start);
 }
 
-void handle_input(const char* input) {
-    if (!game_state || !input) return;
-    
-    // Basic command parsing
-    if (strncmp(input, "go ", 3) == 0 || strncmp(input, "move ", 5) == 0) {
-        const char* direction = strchr(input, ' ') + 1;
-        if (move_player(game_state, direction)) {
-            // Load new location image
-            if (renderer.location_image) {
-                SDL_DestroyTexture(renderer.location_image);
-                renderer.location_image = NULL;
-            }
-            
-            Location* new_location = get_current_location(game_state);
-            if (new_location && new_location->image_path[0] != '\0') {
-                renderer.location_image = load_location_image(new_location->image_path);
+// Engine thread: publish the session's state for the renderer
+static void publish_view(bool quit) {
+    GameView* view = &pipeline.views[pipeline.write_index];
+    view->world = game_state->world;
+    view->location_index = game_state->player.current_location_index;
+    view->quit = quit;
+    
+    int previous = SDL_AtomicSet(&pipeline.latest, pipeline.write_index | VIEW_FRESH);
+    pipeline.write_index = previous & VIEW_INDEX_MASK;
+    
+    // One wakeup covers every view published before the renderer gets to it
+    if (SDL_AtomicSet(&pipeline.event_pending, 1) == 0) {
+        SDL_Event event;
+        SDL_zero(event);
+        event.type = pipeline.view_event;
+        SDL_PushEvent(&event);
+    }
+}
+
+// Engine thread: load the changed game file and move the session onto it.
+// Commands queued meanwhile run on the new world. The old world stays alive
+// for the renderer, which may still be drawing it.
+static void adopt_reload(WorldReload* reload) {
+    reload->world = watch.lazy_text ? load_world_lazy(watch.game_file) : load_world(watch.game_file);
+    GameState* rebased = NULL;
+    if (reload->world && diff_worlds(game_state->world, reload->world, &reload->diff)) {
+        rebased = rebase_session(game_state, reload->world, &reload->diff);
+    }
+    if (rebased) {
+        rebased->owns_world = true;
+        reload->previous = (World*)game_state->world;
+        game_state->owns_world = false;
+        cleanup_session(game_state);
+        game_state = rebased;
+        reload->adopted = true;
+        
+        // The save file has to match the new world to be resumed in it
+        if (pipeline.save_file) save_snapshot(game_state, pipeline.save_file);
+    }
+    SDL_AtomicSet(&reload->done, 1);
+    publish_view(false);
+}
+
+static int engine_thread(void* data) {
+    (void)data;
+    QueuedCommand command;
+    bool quit = false;
+    
+    while (!quit && SDL_SemWait(pipeline.pending) == 0 && !SDL_AtomicGet(&pipeline.stopping)) {
+        // A reload posts like a command; whichever wakeup sees it first takes it
+        WorldReload* reload = SDL_AtomicSetPtr(&pipeline.reload, NULL);
+        if (reload) {
+            adopt_reload(reload);
+            continue;
+        }
+        
+        // Every post stands for one command; its producer may still be copying it in
+        while (!command_queue_pop(&pipeline.commands, &command)) {
+            SDL_Delay(0);
+        }
+        
+        CommandResult result = execute_command(game_state, command.text);
+        quit = result.type == COMMAND_QUIT;
+        publish_view(quit);
+        
+        // Batch journal writes while commands are backed up, flush once caught up
+        if (pipeline.journal.file) {
+            journal_append(&pipeline.journal, game_state->tick, command.text);
+            if (quit || SDL_SemValue(pipeline.pending) == 0) journal_flush(&pipeline.journal);
+        }
+        
+        // Snapshots are a few hundred bytes, so saving on every move is cheap
+        if (result.succeeded && pipeline.save_file) {
+            save_snapshot(game_state, pipeline.save_file);
+        }
+    }
+    return 0;
+}
+
+static bool start_pipeline() {
+    pipeline.view_event = SDL_RegisterEvents(1);
+    pipeline.pending = SDL_CreateSemaphore(0);
+    if (pipeline.view_event == (Uint32)-1 || !pipeline.pending ||
+        !command_queue_init(&pipeline.commands, COMMAND_QUEUE_CAPACITY)) {
+        printf("Failed to create command pipeline! SDL Error: %s\n", SDL_GetError());
+        return false;
+    }
+    
+    renderer.view.world = game_state->world;
+    renderer.view.location_index = game_state->player.current_location_index;
+    renderer.view.quit = false;
+    for (int i = 0; i < 3; i++) {
+        pipeline.views[i] = renderer.view;
+    }
+    pipeline.write_index = 0;
+    pipeline.read_index = 1;
+    SDL_AtomicSet(&pipeline.latest, 2);
+    
+    pipeline.thread = SDL_CreateThread(engine_thread, "engine", NULL);
+    if (!pipeline.thread) {
+        printf("Failed to start engine thread! SDL Error: %s\n", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+static void stop_pipeline() {
+    if (pipeline.thread) {
+        SDL_AtomicSet(&pipeline.stopping, 1);
+        SDL_SemPost(pipeline.pending);
+        SDL_WaitThread(pipeline.thread, NULL);
+        pipeline.thread = NULL;
+    }
+    if (pipeline.pending) {
+        SDL_DestroySemaphore(pipeline.pending);
+        pipeline.pending = NULL;
+    }
+    command_queue_destroy(&pipeline.commands);
+    journal_close(&pipeline.journal);
+}
+
+// Crash recovery: rerun whatever the journal recorded after the resumed
+// snapshot (or after a fresh start), then keep appending to it
+static bool recover_journal(const char* filename) {
+    FILE* existing = fopen(filename, "rb");
+    if (existing) {
+        fclose(existing);
+        
+        JournalReader reader;
+        if (!journal_reader_open(&reader, filename)) return false;
+        
+        JournalEntry entry;
+        int status;
+        int replayed = 0;
+        bool quiet = game_state->quiet;
+        game_state->quiet = true;
+        while ((status = journal_read(&reader, &entry)) == 1) {
+            if (entry.tick <= game_state->tick) continue;
+            execute_command(game_state, entry.command);
+            replayed++;
+            if (game_state->tick != entry.tick) {
+                printf("Error: Journal entry %u replayed as tick %u\n", entry.tick, game_state->tick);
+                status = -1;
+                break;
             }
         }
-    } else if (strcmp(input, "look") == 0 || strcmp(input, "l") == 0) {
-        // Just re-render current location (already handled by render loop)
-    } else if (strcmp(input, "inventory") == 0 || strcmp(input, "i") == 0) {
-        // Show inventory (would need to implement inventory display)
-        printf("Inventory system not yet implemented.\n");
-    } else if (strcmp(input, "help") == 0) {
-        printf("Available commands: go <direction>, look, inventory, help, quit\n");
-    } else if (strcmp(input, "quit") == 0 || strcmp(input, "exit") == 0) {
-        renderer.running = false;
+        game_state->quiet = quiet;
+        journal_reader_close(&reader);
+        if (status != 0) return false;
+        if (replayed > 0) printf("Replayed %d commands from %s\n", replayed, filename);
+    }
+    return journal_open(&pipeline.journal, filename, true);
+}
+
+// Queue a command for the engine thread; safe to call from any producer thread
+bool submit_command(const char* input) {
+    if (!input || !pipeline.thread) return false;
+    
+    if (!command_queue_push(&pipeline.commands, input)) {
+        printf("Warning: Command queue full, dropping \"%s\"\n", input);
+        return false;
+    }
+    SDL_SemPost(pipeline.pending);
+    return true;
+}
+
+// Render thread: switch to the world the engine thread adopted, keeping the
+// layouts of unchanged rooms. Textures are cached by image path, so rooms
+// whose art did not change keep theirs. A file that failed to load is loaded
+// again shortly, since it may only have been caught mid-save.
+static void finish_reload() {
+    WorldReload* reload = watch.pending;
+    watch.pending = NULL;
+    
+    if (reload->adopted) {
+        watch.attempts = 0;
+        if (!layout_cache_rebase(&renderer.layouts, reload->world, &reload->diff)) {
+            layout_cache_destroy(&renderer.layouts);
+            layout_cache_init(&renderer.layouts, reload->world->locations_count);
+        }
+        if (renderer.text) {
+            free_location_text_cache(renderer.text);
+            renderer.text = create_location_text_cache(LOCATION_TEXT_CACHE_ROOMS, LOCATION_TEXT_CACHE_BYTES);
+        }
+        renderer.world = reload->world;
+        renderer.view.location_index = INVALID_LOCATION; // Reshow the image, whose path may have changed
+        renderer.scene_location = INVALID_LOCATION;
+        
+        double ms = (SDL_GetPerformanceCounter() - reload->started) * 1000.0 / SDL_GetPerformanceFrequency();
+        printf("Reloaded %s in %.1f ms: %d locations changed, %d added, %d removed, %d items changed%s\n",
+               watch.game_file, ms, reload->diff.locations_changed, reload->diff.locations_added,
+               reload->diff.locations_removed, reload->diff.items_changed,
+               reload->diff.start_changed ? ", new start" : "");
+        cleanup_world(reload->previous);
     } else {
-        printf("Unknown command: %s\n", input);
+        if (watch.attempts > 0) {
+            printf("Reload failed, trying %s again in %d ms\n", watch.game_file, RELOAD_RETRY_MS);
+            watch.retry_at = SDL_GetTicks() + RELOAD_RETRY_MS;
+        } else {
+            printf("Reload failed, still playing the previous %s\n", watch.game_file);
+        }
+        cleanup_world(reload->world);
+    }
+    free_world_diff(&reload->diff);
+    free(reload);
+}
+
+// Render thread: when the game file changed, or a failed load is due again,
+// ask the engine thread to reload it, which keeps loading off this thread.
+// One reload is in flight at a time; changes made meanwhile are picked up
+// once it is finished.
+static void check_game_file() {
+    if (watch.pending) return;
+    
+    if (file_watch_changed(&watch.file)) {
+        watch.attempts = RELOAD_ATTEMPTS;
+    } else if (watch.attempts == 0 || !SDL_TICKS_PASSED(SDL_GetTicks(), watch.retry_at)) {
+        return;
+    }
+    watch.attempts--;
+    
+    WorldReload* reload = calloc(1, sizeof(WorldReload));
+    if (!reload) return;
+    reload->started = SDL_GetPerformanceCounter();
+    watch.pending = reload;
+    SDL_AtomicSetPtr(&pipeline.reload, reload);
+    SDL_SemPost(pipeline.pending);
+}
+
+// Render thread: catch up with the engine's newest view
+static void apply_latest_view() {
+    SDL_AtomicSet(&pipeline.event_pending, 0);
+    if (!(SDL_AtomicGet(&pipeline.latest) & VIEW_FRESH)) return;
+    
+    int previous = SDL_AtomicSet(&pipeline.latest, pipeline.read_index);
+    pipeline.read_index = previous & VIEW_INDEX_MASK;
+    const GameView* view = &pipeline.views[pipeline.read_index];
+    // Views published before an adopted reload still show the old world
+    WorldReload* reload = watch.pending;
+    if (reload && SDL_AtomicGet(&reload->done) && (!reload->adopted || view->world == reload->world)) {
+        finish_reload();
+    }
+    
+    if (view->location_index != renderer.view.location_index && view->location_index != INVALID_LOCATION) {
+        // Show the new location image, usually already prefetched
+        show_location_image(view->location_index);
+    }
+    renderer.view = *view;
+    renderer.dirty = true;
+    if (view->quit) {
+        renderer.running = false;
+    }
+}
+
+void handle_event(const SDL_Event* e) {
+    if (e->type == SDL_QUIT) {
+        renderer.running = false;
+    } else if (e->type == SDL_RENDER_TARGETS_RESET || e->type == SDL_RENDER_DEVICE_RESET) {
+        // The scene texture's contents were lost
+        renderer.scene_location = INVALID_LOCATION;
+    } else if (e->type == SDL_WINDOWEVENT && e->window.event == SDL_WINDOWEVENT_EXPOSED) {
+        renderer.dirty = true;
+    } else if (e->type == SDL_APP_LOWMEMORY) {
+        // Shown rooms keep their layouts, so decoded text can all go
+        trim_location_text_cache(renderer.text, 0);
+    } else if (e->type == pipeline.view_event) {
+        apply_latest_view();
+    } else if (e->type == renderer.textures.loader.done_event) {
+        // Upload prefetched images on the render thread
+        texture_manager_collect(&renderer.textures);
+    } else if (e->type == SDL_KEYDOWN) {
+        if (e->key.keysym.sym == SDLK_F3) {
+            renderer.overlay = !renderer.overlay;
+            renderer.dirty = true;
+        } else if (e->key.keysym.sym == SDLK_RETURN) {
+            // Process input
+            if (renderer.input_length > 0) {
+                renderer.input_buffer[renderer.input_length] = '\0';
+                submit_command(renderer.input_buffer);
+                renderer.input_length = 0;
+                renderer.input_buffer[0] = '\0';
+                renderer.dirty = true;
+            }
+        } else if (e->key.keysym.sym == SDLK_BACKSPACE) {
+            if (renderer.input_length > 0) {
+                renderer.input_length--;
+                renderer.input_buffer[renderer.input_length] = '\0';
+                renderer.dirty = true;
+            }
+        }
+    } else if (e->type == SDL_TEXTINPUT) {
+        if (renderer.input_length < MAX_INPUT_LENGTH - 1) {
+            strcat(renderer.input_buffer, e->text.text);
+            renderer.input_length += strlen(e->text.text);
+            renderer.dirty = true;
+        }
+    }
+}
+
+// How long the main loop may block waiting for events (-1 waits indefinitely)
+static int next_wait_timeout() {
+    if (renderer.dirty) return 0;
+    if (renderer.animating || renderer.overlay) return renderer.vsync ? 0 : FRAME_INTERVAL_MS;
+    return watch.game_file ? FILE_WATCH_INTERVAL_MS : -1;
+}
+
+// After the engine thread has stopped: free whichever world an unfinished reload left over
+static void stop_watching() {
+    WorldReload* reload = watch.pending;
+    if (reload) {
+        cleanup_world(reload->adopted ? reload->previous : reload->world);
+        free_world_diff(&reload->diff);
+        free(reload);
+        watch.pending = NULL;
     }
+    if (watch.game_file) file_watch_close(&watch.file);
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        printf("Usage: %s <game_file.advgpt>\n", argv[0]);
+    const char* game_file = NULL;
+    EngineOptions options = {false, (size_t)TEXTURE_CACHE_DEFAULT_BUDGET_MB * 1024 * 1024, false, NULL, NULL, false,
+                             NULL, false, false};
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--vsync") == 0) {
+            options.vsync = true;
+        } else if (strcmp(argv[i], "--texture-budget") == 0 && i + 1 < argc) {
+            options.texture_budget = (size_t)strtoul(argv[++i], NULL, 10) * 1024 * 1024;
+        } else if (strcmp(argv[i], "--low-color") == 0) {
+            options.low_color = true;
+        } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            options.save_file = argv[++i];
+        } else if (strcmp(argv[i], "--journal") == 0 && i + 1 < argc) {
+            options.journal_file = argv[++i];
+        } else if (strcmp(argv[i], "--lazy") == 0) {
+            options.lazy_text = true;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            options.trace_file = argv[++i];
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            options.stats = true;
+        } else if (strcmp(argv[i], "--watch") == 0) {
+            options.watch = true;
+        } else if (!game_file) {
+            game_file = argv[i];
+        } else {
+            game_file = NULL;
+            break;
+        }
+    }
+    
+    if (!game_file) {
+        printf("Usage: %s [--vsync] [--texture-budget <MB>] [--low-color] [--save <file>] [--journal <file>] "
+               "[--lazy] [--trace <file>] [--stats] [--watch] <game_file.advgpt>\n", argv[0]);
+        return 1;
+    }
+    
+    // Zone totals feed the F3 overlay; events are only kept when tracing
+    if (!profiler_start(options.trace_file ? PROFILE_TRACE_EVENTS : 0)) {
         return 1;
     }
     
     // Initialize renderer
-    if (!init_renderer()) {
+    if (!init_renderer(&options)) {
         printf("Failed to initialize renderer!\n");
         return 1;
     }
     
     // Load game
-    game_state = load_game(argv[1]);
+    game_state = options.lazy_text ? load_game_lazy(game_file) : load_game(game_file);
     if (!game_state) {
-        printf("Failed to load game: %s\n", argv[1]);
+        printf("Failed to load game: %s\n", game_file);
+        cleanup_renderer();
+        return 1;
+    }
+    
+    renderer.world = game_state->world;
+    if (options.lazy_text) {
+        renderer.text = create_location_text_cache(LOCATION_TEXT_CACHE_ROOMS, LOCATION_TEXT_CACHE_BYTES);
+    }
+    if (!layout_cache_init(&renderer.layouts, game_state->world->locations_count)) {
+        cleanup_game(game_state);
         cleanup_renderer();
         return 1;
     }
     
     printf("Game loaded successfully!\n");
-    printf("Title: %s\n", game_state->meta.title);
-    printf("Author: %s\n", game_state->meta.author);
-    printf("Starting location: %s\n", game_state->start_location);
+    printf("Title: %s\n", game_state->world->meta.title);
+    printf("Author: %s\n", game_state->world->meta.author);
+    printf("Starting location: %s\n", game_state->world->start_location);
+    
+    // Resume where the last session left off
+    FILE* save = options.save_file ? fopen(options.save_file, "rb") : NULL;
+    if (save) {
+        fclose(save);
+        if (load_snapshot(game_state, options.save_file)) {
+            printf("Resumed from %s\n", options.save_file);
+        }
+    }
+    pipeline.save_file = options.save_file;
+    if (options.journal_file && !recover_journal(options.journal_file)) {
+        cleanup_game(game_state);
+        cleanup_renderer();
+        return 1;
+    }
     
     // Load initial location image
-    Location* start_location = get_current_location(game_state);
-    if (start_location && start_location->image_path[0] != '\0') {
-        renderer.location_image = load_location_image(start_location->image_path);
+    show_location_image(game_state->player.current_location_index);
+    
+    if (options.stats) {
+        print_renderer_memory();
     }
     
-    // Main game loop
+    // Edits saved from the editor show up without a restart
+    if (options.watch && file_watch_open(&watch.file, game_file)) {
+        watch.game_file = game_file;
+        watch.lazy_text = options.lazy_text;
+        printf("Watching %s for changes\n", game_file);
+    }
+    
+    // From here on only the engine thread touches game_state's mutable fields
+    if (!start_pipeline()) {
+        stop_pipeline();
+        stop_watching();
+        cleanup_game(game_state);
+        cleanup_renderer();
+        return 1;
+    }
+    
+    // Main game loop: sleep in the event queue until there is something to do
     SDL_Event e;
     while (renderer.running) {
-        while (SDL_PollEvent(&e) != 0) {
-            if (e.type == SDL_QUIT) {
-                renderer.running = false;
-            } else if (e.type == SDL_KEYDOWN) {
-                if (e.key.keysym.sym == SDLK_RETURN) {
-                    // Process input
-                    if (renderer.input_length > 0) {
-                        renderer.input_buffer[renderer.input_length] = '\0';
-                        handle_input(renderer.input_buffer);
-                        renderer.input_length = 0;
-                        renderer.input_buffer[0] = '\0';
-                    }
-                } else if (e.key.keysym.sym == SDLK_BACKSPACE) {
-                    if (renderer.input_length > 0) {
-                        renderer.input_length--;
-                        renderer.input_buffer[renderer.input_length] = '\0';
-                    }
-                }
-            } else if (e.type == SDL_TEXTINPUT) {
-                if (renderer.input_length < MAX_INPUT_LENGTH - 1) {
-                    strcat(renderer.input_buffer, e.text.text);
-                    renderer.input_length += strlen(e.text.text);
-                }
-            }
+        if (SDL_WaitEventTimeout(&e, next_wait_timeout())) {
+            do {
+                handle_event(&e);
+            } while (SDL_PollEvent(&e) != 0);
         }
         
+        if (watch.game_file) {
+            check_game_file();
+        }
+        
+        if (renderer.animating || renderer.overlay) {
+            renderer.dirty = true;
+        }
         render_game();
-        SDL_Delay(16); // ~60 FPS
     }
     
     // Cleanup
+    stop_pipeline();
+    stop_watching();
     cleanup_game(game_state);
     cleanup_renderer();
     
+    // Every thread that records zones has stopped by now
+    if (options.trace_file && profiler_write_trace(options.trace_file)) {
+        printf("Trace written to %s\n", options.trace_file);
+    }
+    profiler_stop();
+    
     printf("Game ended. Thanks for playing!\n");
     return 0;
 } 
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "name_match.h"
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+// Build with -DNAME_MATCH_SCALAR to check the fallback on a vector target
+#if !defined(NAME_MATCH_SCALAR) && defined(__SSE2__)
+#define NAME_MATCH_SSE2
+#include <emmintrin.h>
+#if defined(__AVX2__)
+#define NAME_MATCH_AVX2
+#include <immintrin.h>
+#endif
+#elif !defined(NAME_MATCH_SCALAR) && defined(__ARM_NEON)
+#define NAME_MATCH_NEON
+#include <arm_neon.h>
+#endif
+
+static unsigned char lower(unsigned char c) {
+    return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+// Lowercase like strcasecmp in the C locale: ASCII letters only
+static size_t fill_key(NameKey* key, const char* name) {
+    memset(key, 0, sizeof(*key));
+    size_t length = name ? strlen(name) : 0;
+    for (size_t i = 0; i < length && i < NAME_KEY_BYTES; i++) {
+        key->bytes[i] = lower((unsigned char)name[i]);
+    }
+    return length;
+}
+
+void name_key_init(NameKey* key, const char* name) {
+    fill_key(key, name);
+}
+
+void name_token_init(NameToken* token, const char* text) {
+    token->text = text ? text : "";
+    token->length = fill_key(&token->key, token->text);
+}
+
+#if defined(NAME_MATCH_SSE2)
+
+int find_name_key(const NameKey* keys, int start, int count, const NameToken* token) {
+    __m128i wanted = _mm_loadu_si128((const __m128i*)token->key.bytes);
+    int i = start;
+#if defined(NAME_MATCH_AVX2)
+    __m256i wanted_pair = _mm256_broadcastsi128_si256(wanted);
+    for (; i + 1 < count; i += 2) {
+        __m256i pair = _mm256_loadu_si256((const __m256i*)keys[i].bytes);
+        unsigned int equal = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(pair, wanted_pair));
+        if ((equal & 0xFFFFu) == 0xFFFFu) return i;
+        if ((equal >> 16) == 0xFFFFu) return i + 1;
+    }
+#endif
+    for (; i < count; i++) {
+        __m128i key = _mm_loadu_si128((const __m128i*)keys[i].bytes);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(key, wanted)) == 0xFFFF) return i;
+    }
+    return -1;
+}
+
+#elif defined(NAME_MATCH_NEON)
+
+int find_name_key(const NameKey* keys, int start, int count, const NameToken* token) {
+    uint8x16_t wanted = vld1q_u8(token->key.bytes);
+    for (int i = start; i < count; i++) {
+        // Equal lanes are all ones, so both halves are too only on a full match
+        uint64x2_t equal = vreinterpretq_u64_u8(vceqq_u8(vld1q_u8(keys[i].bytes), wanted));
+        if ((vgetq_lane_u64(equal, 0) & vgetq_lane_u64(equal, 1)) == UINT64_MAX) return i;
+    }
+    return -1;
+}
+
+#else
+
+// Two word compares per key; memcpy keeps the loads legal on strict-alignment targets
+int find_name_key(const NameKey* keys, int start, int count, const NameToken* token) {
+    uint64_t wanted[2];
+    memcpy(wanted, token->key.bytes, sizeof(wanted));
+    for (int i = start; i < count; i++) {
+        uint64_t key[2];
+        memcpy(key, keys[i].bytes, sizeof(key));
+        if (key[0] == wanted[0] && key[1] == wanted[1]) return i;
+    }
+    return -1;
+}
+
+#endif
+
+bool name_matches_token(const char* name, const NameToken* token) {
+    return token->length < NAME_KEY_BYTES || (name && strcasecmp(name, token->text) == 0);
+}
+
+size_t name_index_size(int locations, int keys) {
+    return ARENA_ALIGN((locations + 1) * sizeof(int)) + ARENA_ALIGN(keys * sizeof(NameKey));
+}
+
+void name_index_init(NameIndex* index, Arena* arena, int locations, int keys) {
+    index->offsets = arena_alloc(arena, (locations + 1) * sizeof(int));
+    index->keys = arena_alloc(arena, keys * sizeof(NameKey));
+    index->keys_count = 0;
+    index->keys_capacity = keys;
+}
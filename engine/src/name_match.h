@@ -0,0 +1,53 @@
+#ifndef NAME_MATCH_H
+#define NAME_MATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "arena.h"
+
+// Bytes per key: one SSE2 or NEON register
+#define NAME_KEY_BYTES 16
+
+// A name lowercased and zero padded to one vector lane, so matching it
+// case-insensitively is a single compare. A name longer than the lane keeps its
+// first NAME_KEY_BYTES bytes, and a match on those is confirmed against the
+// full string.
+typedef struct {
+    unsigned char bytes[NAME_KEY_BYTES];
+} NameKey;
+
+// A command word to match, keyed once however many names it is tried against
+typedef struct {
+    NameKey key;
+    const char* text;
+    size_t length;
+} NameToken;
+
+// Nouns of every location as keys, built once at load time: location i's run
+// is keys[offsets[i]] .. keys[offsets[i + 1] - 1], holding its exit directions
+// in exit order, then an id and a display name key per entry of its item list
+typedef struct {
+    int* offsets; // locations_count + 1 entries
+    NameKey* keys;
+    int keys_count;
+    int keys_capacity; // Keys the loader sized the index for
+} NameIndex;
+
+void name_key_init(NameKey* key, const char* name);
+void name_token_init(NameToken* token, const char* text);
+
+// Index of the first key in keys[start, count) equal to the token's, or -1.
+// Compares a lane at a time (two with AVX2), with a portable scalar fallback
+// for targets without either vector unit.
+int find_name_key(const NameKey* keys, int start, int count, const NameToken* token);
+
+// Whether name, whose key matched, really equals the token; only tokens as
+// long as a lane need the string compare
+bool name_matches_token(const char* name, const NameToken* token);
+
+// Building: loaders reserve name_index_size bytes and the arrays are carved out
+// of the world arena
+size_t name_index_size(int locations, int keys);
+void name_index_init(NameIndex* index, Arena* arena, int locations, int keys);
+
+#endif // NAME_MATCH_H
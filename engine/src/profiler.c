@@ -0,0 +1,172 @@
+#include "profiler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    long count;
+    long long total_ns;
+    long long max_ns;
+    long long last_ns;
+} ZoneCounters;
+
+// One slot of the trace ring. Writers claim slots with a fetch-and-add and
+// publish them seqlock style, so readers skip a slot caught mid-write instead
+// of anybody taking a lock.
+typedef struct {
+    unsigned long long sequence; // Event number + 1 once written, 0 while being written
+    int zone;
+    int thread;
+    long long start_ns;
+    long long duration_ns;
+} TraceEvent;
+
+static const char* const zone_names[PROFILE_ZONES] = {
+    [PROFILE_LOAD_WORLD] = "load_world",
+    [PROFILE_PARSE_LOCATION] = "parse_location",
+    [PROFILE_EXECUTE_COMMAND] = "execute_command",
+    [PROFILE_RENDER_FRAME] = "render_frame",
+    [PROFILE_RENDER_TEXT] = "render_text",
+    [PROFILE_RENDER_PRESENT] = "render_present",
+    [PROFILE_LOAD_LOCATION_IMAGE] = "load_location_image",
+    [PROFILE_DECODE_IMAGE] = "decode_image",
+};
+
+static int running;
+static long long origin_ns; // Trace timestamps count from profiler_start
+static ZoneCounters counters[PROFILE_ZONES];
+static TraceEvent* events; // NULL when only totals are kept
+static unsigned long long events_mask;
+static unsigned long long events_head; // Events claimed so far
+static int threads_seen;
+static __thread int thread_id; // Trace thread number, 0 until the thread's first event
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+long long profile_begin(void) {
+    return __atomic_load_n(&running, __ATOMIC_ACQUIRE) ? now_ns() : 0;
+}
+
+static void record_event(ProfileZone zone, long long start, long long duration) {
+    if (thread_id == 0) thread_id = __atomic_add_fetch(&threads_seen, 1, __ATOMIC_RELAXED);
+
+    unsigned long long number = __atomic_fetch_add(&events_head, 1, __ATOMIC_RELAXED);
+    TraceEvent* event = &events[number & events_mask];
+    __atomic_store_n(&event->sequence, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&event->zone, (int)zone, __ATOMIC_RELAXED);
+    __atomic_store_n(&event->thread, thread_id, __ATOMIC_RELAXED);
+    __atomic_store_n(&event->start_ns, start, __ATOMIC_RELAXED);
+    __atomic_store_n(&event->duration_ns, duration, __ATOMIC_RELAXED);
+    __atomic_store_n(&event->sequence, number + 1, __ATOMIC_RELEASE);
+}
+
+void profile_end(ProfileZone zone, long long start) {
+    if (start == 0 || zone < 0 || zone >= PROFILE_ZONES || !__atomic_load_n(&running, __ATOMIC_ACQUIRE)) return;
+    long long duration = now_ns() - start;
+
+    ZoneCounters* zone_counters = &counters[zone];
+    __atomic_add_fetch(&zone_counters->count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&zone_counters->total_ns, duration, __ATOMIC_RELAXED);
+    __atomic_store_n(&zone_counters->last_ns, duration, __ATOMIC_RELAXED);
+    long long max = __atomic_load_n(&zone_counters->max_ns, __ATOMIC_RELAXED);
+    while (duration > max && !__atomic_compare_exchange_n(&zone_counters->max_ns, &max, duration, true,
+                                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+
+    if (events) record_event(zone, start, duration);
+}
+
+bool profiler_start(int trace_events) {
+    profiler_stop();
+    memset(counters, 0, sizeof(counters));
+
+    if (trace_events > 0) {
+        unsigned long long capacity = 1;
+        while (capacity < (unsigned long long)trace_events) capacity *= 2;
+        events = calloc(capacity, sizeof(TraceEvent));
+        if (!events) {
+            printf("Error: Could not allocate %d trace events\n", trace_events);
+            return false;
+        }
+        events_mask = capacity - 1;
+    }
+    events_head = 0;
+    origin_ns = now_ns();
+    __atomic_store_n(&running, 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+void profiler_stop(void) {
+    __atomic_store_n(&running, 0, __ATOMIC_RELEASE);
+    free(events);
+    events = NULL;
+    events_mask = 0;
+}
+
+const char* profile_zone_name(ProfileZone zone) {
+    return zone >= 0 && zone < PROFILE_ZONES ? zone_names[zone] : "unknown";
+}
+
+ProfileZoneStats profile_zone_stats(ProfileZone zone) {
+    ProfileZoneStats stats = {0};
+    if (zone < 0 || zone >= PROFILE_ZONES) return stats;
+
+    const ZoneCounters* zone_counters = &counters[zone];
+    stats.count = __atomic_load_n(&zone_counters->count, __ATOMIC_RELAXED);
+    stats.total_ns = __atomic_load_n(&zone_counters->total_ns, __ATOMIC_RELAXED);
+    stats.max_ns = __atomic_load_n(&zone_counters->max_ns, __ATOMIC_RELAXED);
+    stats.last_ns = __atomic_load_n(&zone_counters->last_ns, __ATOMIC_RELAXED);
+    return stats;
+}
+
+// Copy one slot out, or return false if it is being written or was never filled
+static bool read_event(const TraceEvent* event, unsigned long long number, TraceEvent* copy) {
+    unsigned long long sequence = __atomic_load_n(&event->sequence, __ATOMIC_ACQUIRE);
+    copy->zone = __atomic_load_n(&event->zone, __ATOMIC_RELAXED);
+    copy->thread = __atomic_load_n(&event->thread, __ATOMIC_RELAXED);
+    copy->start_ns = __atomic_load_n(&event->start_ns, __ATOMIC_RELAXED);
+    copy->duration_ns = __atomic_load_n(&event->duration_ns, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return sequence == number + 1 && __atomic_load_n(&event->sequence, __ATOMIC_RELAXED) == sequence;
+}
+
+// Complete ("X") events with microsecond timestamps, oldest first
+bool profiler_write_trace(const char* filename) {
+    if (!events) {
+        printf("Error: Tracing was not enabled\n");
+        return false;
+    }
+
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        printf("Error: Could not open trace file %s\n", filename);
+        return false;
+    }
+
+    unsigned long long head = __atomic_load_n(&events_head, __ATOMIC_ACQUIRE);
+    unsigned long long first = head > events_mask + 1 ? head - (events_mask + 1) : 0;
+    bool separator = false;
+    fprintf(file, "{\"traceEvents\":[\n");
+    for (unsigned long long number = first; number < head; number++) {
+        TraceEvent event;
+        if (!read_event(&events[number & events_mask], number, &event)) continue;
+        if (event.zone < 0 || event.zone >= PROFILE_ZONES) continue;
+
+        fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"engine\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                "\"ts\":%.3f,\"dur\":%.3f}", separator ? ",\n" : "", zone_names[event.zone], event.thread,
+                (event.start_ns - origin_ns) / 1e3, event.duration_ns / 1e3);
+        separator = true;
+    }
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    bool ok = fflush(file) == 0 && !ferror(file);
+    if (fclose(file) != 0) ok = false;
+    if (!ok) printf("Error: Could not write trace file %s\n", filename);
+    return ok;
+}
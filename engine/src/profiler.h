@@ -0,0 +1,50 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+
+// Events kept for a Chrome trace; older ones are overwritten
+#define PROFILE_TRACE_EVENTS 65536
+
+// Instrumented hot paths. The core times loading and commands; frontends time
+// their own rendering.
+typedef enum {
+    PROFILE_LOAD_WORLD,
+    PROFILE_PARSE_LOCATION,
+    PROFILE_EXECUTE_COMMAND,
+    PROFILE_RENDER_FRAME, // All of render_game, present included
+    PROFILE_RENDER_TEXT,
+    PROFILE_RENDER_PRESENT,
+    PROFILE_LOAD_LOCATION_IMAGE,
+    PROFILE_DECODE_IMAGE, // Background image loader thread
+    PROFILE_ZONES
+} ProfileZone;
+
+typedef struct {
+    long count;
+    long long total_ns;
+    long long max_ns;
+    long long last_ns;
+} ProfileZoneStats;
+
+// Scoped timers from any thread:
+//     long long start = profile_begin();
+//     ...
+//     profile_end(PROFILE_RENDER_TEXT, start);
+// While the profiler is stopped profile_begin returns 0 and profile_end does nothing.
+long long profile_begin(void);
+void profile_end(ProfileZone zone, long long start);
+
+// Start collecting per-zone totals, and with trace_events > 0 also the most
+// recent events for profiler_write_trace. Call before other threads time zones
+// and stop after they are done.
+bool profiler_start(int trace_events);
+void profiler_stop(void);
+
+const char* profile_zone_name(ProfileZone zone);
+ProfileZoneStats profile_zone_stats(ProfileZone zone);
+
+// Chrome trace event JSON, for chrome://tracing or ui.perfetto.dev
+bool profiler_write_trace(const char* filename);
+
+#endif // PROFILER_H
@@ -0,0 +1,195 @@
+#include "render_cache.h"
+#include "location_text.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool add_line(TextLayout* layout, const char* start, const char* end) {
+    if (layout->lines_count == layout->lines_capacity) {
+        int capacity = layout->lines_capacity ? layout->lines_capacity * 2 : 8;
+        TextLine* lines = realloc(layout->lines, capacity * sizeof(TextLine));
+        if (!lines) return false;
+        layout->lines = lines;
+        layout->lines_capacity = capacity;
+    }
+
+    TextLine* line = &layout->lines[layout->lines_count++];
+    line->start = (int)(start - layout->text);
+    line->length = (int)(end - start);
+    return true;
+}
+
+// Greedy word wrap over the atlas's cached advances; newlines force a break.
+// Empty lines are kept so blank lines in the text still take up space.
+bool text_layout_build(TextLayout* layout, const GlyphAtlas* atlas, const char* text, int max_width) {
+    layout->text = text;
+    layout->lines_count = 0;
+    if (!text) return true;
+
+    const char* p = text;
+    while (*p) {
+        while (*p == ' ') p++;
+        const char* line_start = p;
+        const char* line_end = p;
+        int line_width = 0;
+
+        while (*p && *p != '\n') {
+            const char* word_end = p;
+            while (*word_end == ' ') word_end++;
+            if (*word_end == '\0' || *word_end == '\n') {
+                p = word_end; // Trailing spaces
+                break;
+            }
+            while (*word_end && *word_end != ' ' && *word_end != '\n') word_end++;
+
+            // Measure only the new word (and the spaces before it)
+            int width = line_width + glyph_atlas_text_width(atlas, line_end, word_end - line_end);
+            if (width > max_width && line_end > line_start) break;
+
+            line_end = word_end;
+            line_width = width;
+            p = word_end;
+        }
+
+        if (!add_line(layout, line_start, line_end)) return false;
+        if (*p == '\n') p++;
+    }
+    return true;
+}
+
+// Queue the layout's lines; the caller flushes the atlas
+void text_layout_draw(const TextLayout* layout, GlyphAtlas* atlas, int x, int y, SDL_Color color) {
+    int line_y = y;
+    for (int i = 0; i < layout->lines_count; i++) {
+        const TextLine* line = &layout->lines[i];
+        if (line->length > 0) {
+            glyph_atlas_add_text(atlas, layout->text + line->start, line->length, x, line_y, color);
+        }
+        line_y += atlas->line_height + TEXT_LINE_SPACING;
+    }
+}
+
+void text_layout_free(TextLayout* layout) {
+    free(layout->lines);
+    memset(layout, 0, sizeof(*layout));
+}
+
+bool layout_cache_init(LayoutCache* cache, int locations_count) {
+    cache->layouts = calloc(locations_count > 0 ? locations_count : 1, sizeof(LocationLayout));
+    if (!cache->layouts) {
+        printf("Error: Could not allocate layout cache\n");
+        cache->layouts_count = 0;
+        return false;
+    }
+    cache->layouts_count = locations_count;
+    return true;
+}
+
+static bool build_location_layout(LocationLayout* layout, const GlyphAtlas* atlas, const World* world,
+                                  const Location* location, int max_width) {
+    const char* title = location->title;
+    const char* description = location->description;
+
+    // Layouts borrow their text, and lazily decoded text can be evicted
+    if (world->text_offsets) {
+        size_t title_size = strlen(title) + 1;
+        size_t description_size = strlen(description) + 1;
+        layout->text = malloc(title_size + description_size);
+        if (!layout->text) return false;
+        memcpy(layout->text, title, title_size);
+        memcpy(layout->text + title_size, description, description_size);
+        title = layout->text;
+        description = layout->text + title_size;
+    }
+
+    layout->exits_text[0] = '\0';
+    if (location->exits_count > 0) {
+        size_t exits_length = snprintf(layout->exits_text, sizeof(layout->exits_text), "Exits: ");
+        for (int i = 0; i < location->exits_count && exits_length < sizeof(layout->exits_text) - 1; i++) {
+            // Exit counts are no longer capped, so append within the buffer
+            exits_length += snprintf(layout->exits_text + exits_length, sizeof(layout->exits_text) - exits_length,
+                                     "%s%s", i > 0 ? ", " : "", location->exits[i].direction);
+        }
+    }
+
+    return text_layout_build(&layout->title, atlas, title, max_width) &&
+           text_layout_build(&layout->description, atlas, description, max_width) &&
+           text_layout_build(&layout->exits, atlas, layout->exits_text, max_width);
+}
+
+// Locations never change their text, so a layout is built at most once
+const LocationLayout* layout_cache_get(LayoutCache* cache, const GlyphAtlas* atlas, const World* world,
+                                       LocationTextCache* text, int location_index, int max_width) {
+    if (location_index < 0 || location_index >= cache->layouts_count || location_index >= world->locations_count) {
+        return NULL;
+    }
+
+    LocationLayout* layout = &cache->layouts[location_index];
+    if (layout->built) {
+        cache->hits++;
+    } else {
+        cache->misses++;
+        if (!build_location_layout(layout, atlas, world, location_text(text, world, location_index), max_width)) {
+            printf("Error: Could not lay out location %s\n", world->locations[location_index].id);
+            return NULL;
+        }
+        layout->built = true;
+    }
+    return layout;
+}
+
+bool layout_cache_rebase(LayoutCache* cache, const World* world, const WorldDiff* diff) {
+    LayoutCache rebased = {0};
+    if (!layout_cache_init(&rebased, world->locations_count)) return false;
+    rebased.hits = cache->hits;
+    rebased.misses = cache->misses;
+
+    for (int i = 0; i < cache->layouts_count && i < diff->old_locations_count; i++) {
+        LocationLayout* layout = &cache->layouts[i];
+        int j = diff->locations[i];
+        if (!layout->built || j == INVALID_LOCATION || BIT_TEST(diff->changed, i)) continue;
+        if ((layout->text != NULL) != (world->text_offsets != NULL)) continue;
+
+        // Line ranges still hold for the same text; borrowed text moves to the new record
+        LocationLayout* moved = &rebased.layouts[j];
+        *moved = *layout;
+        memset(layout, 0, sizeof(*layout));
+        moved->exits.text = moved->exits_text;
+        if (!moved->text) {
+            moved->title.text = world->locations[j].title;
+            moved->description.text = world->locations[j].description;
+        }
+    }
+    layout_cache_destroy(cache);
+    *cache = rebased;
+    return true;
+}
+
+static size_t text_layout_bytes(const TextLayout* layout) {
+    return layout->lines_capacity * sizeof(TextLine);
+}
+
+// The per-location table, which is allocated up front, and every built layout
+size_t layout_cache_bytes(const LayoutCache* cache) {
+    size_t bytes = cache->layouts_count * sizeof(LocationLayout);
+    for (int i = 0; i < cache->layouts_count; i++) {
+        const LocationLayout* layout = &cache->layouts[i];
+        if (!layout->built) continue;
+        bytes += text_layout_bytes(&layout->title) + text_layout_bytes(&layout->description) +
+                 text_layout_bytes(&layout->exits);
+        if (layout->text) bytes += strlen(layout->title.text) + strlen(layout->description.text) + 2;
+    }
+    return bytes;
+}
+
+void layout_cache_destroy(LayoutCache* cache) {
+    for (int i = 0; i < cache->layouts_count; i++) {
+        text_layout_free(&cache->layouts[i].title);
+        text_layout_free(&cache->layouts[i].description);
+        text_layout_free(&cache->layouts[i].exits);
+        free(cache->layouts[i].text);
+    }
+    free(cache->layouts);
+    cache->layouts = NULL;
+    cache->layouts_count = 0;
+}
@@ -0,0 +1,59 @@
+#ifndef RENDER_CACHE_H
+#define RENDER_CACHE_H
+
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+#include "adventure_engine.h"
+#include "glyph_atlas.h"
+#include "world_reload.h"
+
+#define TEXT_LINE_SPACING 2
+#define EXITS_TEXT_LENGTH 256
+
+// One wrapped line, as a byte range of the laid-out text
+typedef struct {
+    int start;
+    int length;
+} TextLine;
+
+// Word-wrapped text; the text itself is borrowed, not copied
+typedef struct {
+    const char* text;
+    TextLine* lines;
+    int lines_count;
+    int lines_capacity;
+} TextLayout;
+
+// Wrapped title, description and exits of one location, built the first time it is shown
+typedef struct {
+    bool built;
+    char exits_text[EXITS_TEXT_LENGTH];
+    char* text; // Own copy of the title and description when they were decoded lazily, else NULL
+    TextLayout title;
+    TextLayout description;
+    TextLayout exits;
+} LocationLayout;
+
+typedef struct {
+    LocationLayout* layouts; // Indexed like World.locations
+    int layouts_count;
+    unsigned long hits;
+    unsigned long misses;
+} LayoutCache;
+
+// Text layout functions
+bool text_layout_build(TextLayout* layout, const GlyphAtlas* atlas, const char* text, int max_width);
+void text_layout_draw(const TextLayout* layout, GlyphAtlas* atlas, int x, int y, SDL_Color color);
+void text_layout_free(TextLayout* layout);
+
+// Per-location layout cache
+bool layout_cache_init(LayoutCache* cache, int locations_count);
+const LocationLayout* layout_cache_get(LayoutCache* cache, const GlyphAtlas* atlas, const World* world,
+                                       LocationTextCache* text, int location_index, int max_width);
+// Keep the layouts of locations a reload left unchanged, under their new
+// indices, and drop the rest
+bool layout_cache_rebase(LayoutCache* cache, const World* world, const WorldDiff* diff);
+size_t layout_cache_bytes(const LayoutCache* cache);
+void layout_cache_destroy(LayoutCache* cache);
+
+#endif // RENDER_CACHE_H
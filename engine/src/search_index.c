@@ -0,0 +1,428 @@
+// Inverted index over the text of a world's locations and items. Words are
+// interned once into a term table; each term lists the documents it occurs in
+// as ascending ids, stored as varint gaps.
+#include "adventure_engine.h"
+#include "location_text.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SEARCH_TERM_LENGTH 32 // Longer words are indexed and looked up by their first bytes
+#define SEARCH_QUERY_TERMS 16 // Query words past this many are ignored
+#define SEARCH_SKIP_INTERVAL 64 // Documents between skip entries of a long list
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME 16777619u
+
+// Where block k + 1 of a term's list starts: the document before it, which
+// its first gap counts from, and its byte offset into the term's postings
+typedef struct {
+    int document;
+    unsigned int offset;
+} SkipEntry;
+
+// Documents are numbered locations first, then inventory items
+struct SearchIndex {
+    int locations_count;
+    int documents_count;
+
+    int terms_count;
+    int terms_capacity;
+    char* term_text; // Terms back to back, each NUL terminated
+    size_t term_text_length;
+    size_t* term_offsets; // Term t starts at term_text[term_offsets[t]]
+    int* slots; // Term id + 1, 0 marks an empty slot
+    unsigned int slot_mask; // Slot count - 1 (power of two, >= 2 * terms)
+
+    int* document_counts; // Documents each term occurs in
+    size_t* posting_offsets; // Term t's gaps are postings[posting_offsets[t], posting_offsets[t + 1])
+    unsigned char* postings;
+    size_t* skip_offsets; // Term t's skip entries are skips[skip_offsets[t], skip_offsets[t + 1])
+    SkipEntry* skips;
+};
+
+typedef struct {
+    int term;
+    int document;
+} Posting;
+
+// Growable state while the index is built
+typedef struct {
+    SearchIndex* index;
+    size_t text_capacity;
+    int* last_document; // Per term, the last document it was recorded for
+    Posting* postings; // In document order, one per distinct term of each document
+    size_t postings_count;
+    size_t postings_capacity;
+    bool failed;
+} IndexBuilder;
+
+static unsigned char lower(unsigned char c) {
+    return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+// ASCII letters and digits, and every byte of a UTF-8 sequence, make up words
+static bool is_word_byte(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c >= 0x80;
+}
+
+// Copy the next word of text into term, lowercased and NUL terminated. Returns
+// where the scan continues, or NULL when text has no more words.
+static const char* next_term(const char* text, char* term, size_t* length) {
+    if (!text) return NULL;
+    while (*text && !is_word_byte((unsigned char)*text)) text++;
+    if (!*text) return NULL;
+
+    size_t n = 0;
+    for (; is_word_byte((unsigned char)*text); text++) {
+        if (n < SEARCH_TERM_LENGTH) term[n++] = (char)lower((unsigned char)*text);
+    }
+    term[n] = '\0';
+    *length = n;
+    return text;
+}
+
+static unsigned int hash_term(const char* term, size_t length) {
+    unsigned int hash = FNV_OFFSET;
+    for (size_t i = 0; i < length; i++) hash = (hash ^ (unsigned char)term[i]) * FNV_PRIME;
+    return hash;
+}
+
+static const char* term_name(const SearchIndex* index, int term) {
+    return index->term_text + index->term_offsets[term];
+}
+
+// The slot holding term, or the empty slot it would go in
+static unsigned int term_slot(const SearchIndex* index, const char* term, size_t length) {
+    unsigned int slot = hash_term(term, length) & index->slot_mask;
+    while (index->slots[slot]) {
+        const char* name = term_name(index, index->slots[slot] - 1);
+        if (strncmp(name, term, length) == 0 && name[length] == '\0') break;
+        slot = (slot + 1) & index->slot_mask;
+    }
+    return slot;
+}
+
+static int find_term(const SearchIndex* index, const char* term, size_t length) {
+    if (!index->slots) return -1;
+    return index->slots[term_slot(index, term, length)] - 1;
+}
+
+static bool grow_terms(IndexBuilder* builder) {
+    SearchIndex* index = builder->index;
+    int capacity = index->terms_capacity ? index->terms_capacity * 2 : 1024;
+    size_t* offsets = realloc(index->term_offsets, capacity * sizeof(size_t));
+    if (offsets) index->term_offsets = offsets;
+    int* last = realloc(builder->last_document, capacity * sizeof(int));
+    if (last) builder->last_document = last;
+    unsigned int slot_count = 2u * (unsigned int)capacity;
+    int* slots = calloc(slot_count, sizeof(int));
+    if (!offsets || !last || !slots) {
+        free(slots);
+        return false;
+    }
+
+    // Rehash into the larger table
+    free(index->slots);
+    index->slots = slots;
+    index->slot_mask = slot_count - 1;
+    for (int term = 0; term < index->terms_count; term++) {
+        const char* name = term_name(index, term);
+        index->slots[term_slot(index, name, strlen(name))] = term + 1;
+    }
+    index->terms_capacity = capacity;
+    return true;
+}
+
+static int intern_term(IndexBuilder* builder, const char* term, size_t length) {
+    SearchIndex* index = builder->index;
+    int existing = find_term(index, term, length);
+    if (existing >= 0) return existing;
+
+    if (index->terms_count == index->terms_capacity && !grow_terms(builder)) return -1;
+    if (index->term_text_length + length + 1 > builder->text_capacity) {
+        size_t capacity = builder->text_capacity ? builder->text_capacity * 2 : 16384;
+        while (capacity < index->term_text_length + length + 1) capacity *= 2;
+        char* text = realloc(index->term_text, capacity);
+        if (!text) return -1;
+        index->term_text = text;
+        builder->text_capacity = capacity;
+    }
+
+    int id = index->terms_count++;
+    index->term_offsets[id] = index->term_text_length;
+    memcpy(index->term_text + index->term_text_length, term, length + 1);
+    index->term_text_length += length + 1;
+    builder->last_document[id] = -1;
+    index->slots[term_slot(index, term, length)] = id + 1;
+    return id;
+}
+
+// Record every distinct word of text for the document
+static void index_text(IndexBuilder* builder, int document, const char* text) {
+    char term[SEARCH_TERM_LENGTH + 1];
+    size_t length;
+    while (!builder->failed && (text = next_term(text, term, &length))) {
+        int id = intern_term(builder, term, length);
+        if (id < 0) {
+            builder->failed = true;
+            return;
+        }
+        if (builder->last_document[id] == document) continue;
+        builder->last_document[id] = document;
+
+        if (builder->postings_count == builder->postings_capacity) {
+            size_t capacity = builder->postings_capacity ? builder->postings_capacity * 2 : 4096;
+            Posting* postings = realloc(builder->postings, capacity * sizeof(Posting));
+            if (!postings) {
+                builder->failed = true;
+                return;
+            }
+            builder->postings = postings;
+            builder->postings_capacity = capacity;
+        }
+        builder->postings[builder->postings_count++] = (Posting){id, document};
+    }
+}
+
+static size_t varint_size(unsigned int value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+static unsigned char* put_varint(unsigned char* out, unsigned int value) {
+    while (value >= 0x80) {
+        *out++ = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (unsigned char)value;
+    return out;
+}
+
+static const unsigned char* get_varint(const unsigned char* in, unsigned int* value) {
+    unsigned int result = 0;
+    int shift = 0;
+    while (*in & 0x80) {
+        result |= (unsigned int)(*in++ & 0x7F) << shift;
+        shift += 7;
+    }
+    *value = result | (unsigned int)*in++ << shift;
+    return in;
+}
+
+// Group the document-ordered postings by term, so each term's documents come
+// out ascending, and encode every list as gaps
+static bool encode_postings(IndexBuilder* builder) {
+    SearchIndex* index = builder->index;
+    int terms = index->terms_count;
+    index->document_counts = calloc(terms > 0 ? terms : 1, sizeof(int));
+    index->posting_offsets = malloc((terms + 1) * sizeof(size_t));
+    index->skip_offsets = malloc((terms + 1) * sizeof(size_t));
+    int* starts = malloc((terms + 1) * sizeof(int));
+    int* documents = malloc((builder->postings_count > 0 ? builder->postings_count : 1) * sizeof(int));
+    if (!index->document_counts || !index->posting_offsets || !index->skip_offsets || !starts || !documents) {
+        free(starts);
+        free(documents);
+        return false;
+    }
+
+    for (size_t i = 0; i < builder->postings_count; i++) index->document_counts[builder->postings[i].term]++;
+    starts[0] = 0;
+    for (int term = 0; term < terms; term++) starts[term + 1] = starts[term] + index->document_counts[term];
+    for (size_t i = 0; i < builder->postings_count; i++) {
+        const Posting* posting = &builder->postings[i];
+        documents[starts[posting->term]++] = posting->document;
+    }
+
+    // starts[t] now ends term t's documents, which begin where term t - 1's end
+    size_t bytes = 0;
+    size_t skips = 0;
+    for (int term = 0, first = 0; term < terms; first = starts[term++]) {
+        index->posting_offsets[term] = bytes;
+        index->skip_offsets[term] = skips;
+        for (int i = first, previous = -1; i < starts[term]; previous = documents[i++]) {
+            bytes += varint_size((unsigned int)(documents[i] - previous - 1));
+        }
+        if (starts[term] > first) skips += (starts[term] - first - 1) / SEARCH_SKIP_INTERVAL;
+    }
+    index->posting_offsets[terms] = bytes;
+    index->skip_offsets[terms] = skips;
+
+    index->postings = malloc(bytes > 0 ? bytes : 1);
+    index->skips = malloc((skips > 0 ? skips : 1) * sizeof(SkipEntry));
+    if (index->postings && index->skips) {
+        unsigned char* out = index->postings;
+        SkipEntry* skip = index->skips;
+        for (int term = 0, first = 0; term < terms; first = starts[term++]) {
+            const unsigned char* list = out;
+            for (int i = first, previous = -1; i < starts[term]; previous = documents[i++]) {
+                if (i > first && (i - first) % SEARCH_SKIP_INTERVAL == 0) {
+                    *skip++ = (SkipEntry){previous, (unsigned int)(out - list)};
+                }
+                out = put_varint(out, (unsigned int)(documents[i] - previous - 1));
+            }
+        }
+    }
+    free(starts);
+    free(documents);
+    return index->postings && index->skips;
+}
+
+SearchIndex* build_search_index(const World* world) {
+    SearchIndex* index = calloc(1, sizeof(SearchIndex));
+    IndexBuilder builder = {index, 0, NULL, NULL, 0, 0, index == NULL};
+    if (index) {
+        index->locations_count = world->locations_count;
+        index->documents_count = world->locations_count + world->inventory_items_count;
+        builder.failed = !grow_terms(&builder);
+    }
+
+    // A lazily loaded world's text is decoded one location at a time
+    LocationTextCache* text = world->text_offsets ? create_location_text_cache(1, 0) : NULL;
+    if (world->text_offsets && !text) builder.failed = true;
+    for (int i = 0; i < world->locations_count && !builder.failed; i++) {
+        const Location* location = location_text(text, world, i);
+        index_text(&builder, i, location->title);
+        index_text(&builder, i, location->description);
+        index_text(&builder, i, location->first_visit_text);
+    }
+    free_location_text_cache(text);
+
+    for (int i = 0; i < world->inventory_items_count && !builder.failed; i++) {
+        const InventoryItem* item = &world->inventory_items[i];
+        int document = world->locations_count + i;
+        index_text(&builder, document, item->name);
+        index_text(&builder, document, item->description);
+        index_text(&builder, document, item->use_text);
+    }
+
+    if (!builder.failed) builder.failed = !encode_postings(&builder);
+    if (!builder.failed && index->term_text_length < builder.text_capacity) {
+        char* text = realloc(index->term_text, index->term_text_length);
+        if (text) index->term_text = text;
+    }
+    free(builder.last_document);
+    free(builder.postings);
+    if (builder.failed) {
+        printf("Error: Could not allocate the search index\n");
+        free_search_index(index);
+        return NULL;
+    }
+    return index;
+}
+
+void free_search_index(SearchIndex* index) {
+    if (!index) return;
+    free(index->term_text);
+    free(index->term_offsets);
+    free(index->slots);
+    free(index->document_counts);
+    free(index->posting_offsets);
+    free(index->postings);
+    free(index->skip_offsets);
+    free(index->skips);
+    free(index);
+}
+
+// Keep the candidates that also appear in term's list; both are ascending.
+// Skip entries jump over blocks that end before the next candidate.
+static int intersect_term(const SearchIndex* index, int term, int* candidates, int count) {
+    const unsigned char* list = index->postings + index->posting_offsets[term];
+    const SkipEntry* skip = index->skips + index->skip_offsets[term];
+    const SkipEntry* skips_end = index->skips + index->skip_offsets[term + 1];
+    const unsigned char* in = list;
+    int remaining = index->document_counts[term];
+    int document = -1;
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        int wanted = candidates[i];
+        if (document < wanted) {
+            const SkipEntry* block = NULL;
+            while (skip < skips_end && skip->document < wanted) block = skip++;
+            if (block && block->document > document) {
+                int blocks_passed = (int)(block - (index->skips + index->skip_offsets[term])) + 1;
+                in = list + block->offset;
+                document = block->document;
+                remaining = index->document_counts[term] - blocks_passed * SEARCH_SKIP_INTERVAL;
+            }
+        }
+        while (document < wanted && remaining > 0) {
+            unsigned int gap;
+            in = get_varint(in, &gap);
+            document += (int)gap + 1;
+            remaining--;
+        }
+        if (document == wanted) candidates[kept++] = document;
+        else if (document < wanted) break; // The list ran out
+    }
+    return kept;
+}
+
+// Documents containing every word of the query, ascending; the rarest word's
+// list is decoded and the others only filter it
+int search_world(const SearchIndex* index, const char* query, SearchHit* hits, int max_hits) {
+    if (!index || !query) return 0;
+
+    int terms[SEARCH_QUERY_TERMS];
+    int terms_count = 0;
+    char term[SEARCH_TERM_LENGTH + 1];
+    size_t length;
+    while (terms_count < SEARCH_QUERY_TERMS && (query = next_term(query, term, &length))) {
+        int id = find_term(index, term, length);
+        if (id < 0) return 0;
+
+        // Insertion sort by list length, dropping repeated words
+        int at = terms_count;
+        bool repeated = false;
+        for (int i = 0; i < terms_count; i++) repeated |= terms[i] == id;
+        if (repeated) continue;
+        while (at > 0 && index->document_counts[terms[at - 1]] > index->document_counts[id]) {
+            terms[at] = terms[at - 1];
+            at--;
+        }
+        terms[at] = id;
+        terms_count++;
+    }
+    if (terms_count == 0) return 0;
+
+    int count = index->document_counts[terms[0]];
+    int* candidates = malloc((count > 0 ? count : 1) * sizeof(int));
+    if (!candidates) {
+        printf("Error: Out of memory searching the world\n");
+        return 0;
+    }
+    const unsigned char* in = index->postings + index->posting_offsets[terms[0]];
+    for (int i = 0, document = -1; i < count; i++) {
+        unsigned int gap;
+        in = get_varint(in, &gap);
+        document += (int)gap + 1;
+        candidates[i] = document;
+    }
+    for (int t = 1; t < terms_count && count > 0; t++) count = intersect_term(index, terms[t], candidates, count);
+
+    for (int i = 0; i < count && i < max_hits; i++) {
+        bool location = candidates[i] < index->locations_count;
+        hits[i].type = location ? SEARCH_LOCATION : SEARCH_ITEM;
+        hits[i].index = location ? candidates[i] : candidates[i] - index->locations_count;
+    }
+    free(candidates);
+    return count;
+}
+
+SearchIndexStats search_index_stats(const SearchIndex* index) {
+    SearchIndexStats stats = {0};
+    if (!index) return stats;
+
+    stats.documents = index->documents_count;
+    stats.terms = index->terms_count;
+    stats.postings_bytes = index->posting_offsets[index->terms_count];
+    for (int term = 0; term < index->terms_count; term++) stats.postings += index->document_counts[term];
+    stats.bytes = sizeof(SearchIndex) + index->term_text_length + index->terms_capacity * sizeof(size_t) +
+                  (index->slot_mask + 1) * sizeof(int) + index->terms_count * sizeof(int) +
+                  2 * (index->terms_count + 1) * sizeof(size_t) + stats.postings_bytes +
+                  index->skip_offsets[index->terms_count] * sizeof(SkipEntry);
+    return stats;
+}
@@ -0,0 +1,567 @@
+// Multi-session server: one shared, read-only World and a small GameState per
+// connection. Players speak a line protocol over TCP (telnet and netcat work);
+// each worker thread runs its own poll() loop over a shard of the connections
+// and the main thread accepts sockets and hands them out round-robin.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "adventure_engine.h"
+#include "text_output.h"
+
+#define DEFAULT_PORT 4000
+#define DEFAULT_MAX_SESSIONS 4096
+#define INPUT_LINE_LENGTH 256
+#define READ_CHUNK_SIZE 4096
+#define OUTPUT_LIMIT (64 * 1024) // Drop clients that stop reading once this much is pending
+#define PROMPT "> "
+
+typedef struct {
+    int fd;
+    GameState* game;
+    TextOutput output; // Bytes not yet accepted by the socket
+    int input_length;
+    bool discarding; // The current input line overflowed and is skipped
+    bool closing; // Disconnect once the pending output is flushed
+    bool failed; // Socket error or output overflow: disconnect now
+    char input[INPUT_LINE_LENGTH];
+} Connection;
+
+struct Server;
+
+typedef struct {
+    struct Server* server;
+    pthread_t thread;
+    int wake_pipe[2]; // The acceptor writes a byte after queueing sockets or stopping
+
+    pthread_mutex_t lock; // Guards pending and stopping
+    int* pending;
+    int pending_count;
+    int pending_capacity;
+    bool stopping;
+
+    // Owned by the worker thread only
+    Connection** connections;
+    struct pollfd* pollfds; // Slot 0 is the wake pipe, slot i + 1 is connections[i]
+    int connections_count;
+    int connections_capacity;
+} Worker;
+
+typedef struct Server {
+    const World* world;
+    const WrappedText* wrapped; // Location descriptions at the server's width
+    Worker* workers;
+    int workers_count;
+    int max_sessions;
+
+    pthread_mutex_t lock; // Guards sessions
+    int sessions;
+} Server;
+
+static volatile sig_atomic_t running = 1;
+
+static void handle_signal(int signal_number) {
+    (void)signal_number;
+    running = 0;
+}
+
+static bool set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static void connection_print(Connection* connection, const char* text) {
+    text_output_print(&connection->output, text);
+}
+
+// Everything a command printed goes out in one writev; a full socket keeps
+// the rest queued until poll reports it writable
+static void connection_flush(Connection* connection) {
+    text_output_flush(&connection->output);
+    if (connection->output.failed) connection->failed = true;
+}
+
+static void run_line(Server* server, Connection* connection, char* line) {
+    size_t length = strlen(line);
+    while (length > 0 && (line[length - 1] == '\r' || line[length - 1] == ' ')) line[--length] = '\0';
+
+    if (length > 0) {
+        CommandResult result = execute_command(connection->game, line);
+        switch (result.type) {
+            case COMMAND_MOVE:
+                if (result.succeeded) text_output_describe(&connection->output, server->wrapped, connection->game);
+                break;
+            case COMMAND_LOOK:
+                text_output_describe(&connection->output, server->wrapped, connection->game);
+                break;
+            case COMMAND_QUIT:
+                connection_print(connection, "Goodbye.\n");
+                connection->closing = true;
+                return;
+            default:
+                break;
+        }
+    }
+    connection_print(connection, PROMPT);
+}
+
+// Split received bytes into lines; overlong lines are dropped with a warning
+static void connection_receive(Server* server, Connection* connection, const char* data, int length) {
+    for (int i = 0; i < length && !connection->closing; i++) {
+        char c = data[i];
+        if (c == '\n') {
+            if (connection->discarding) {
+                connection_print(connection, "Command too long.\n" PROMPT);
+            } else {
+                connection->input[connection->input_length] = '\0';
+                run_line(server, connection, connection->input);
+            }
+            connection->input_length = 0;
+            connection->discarding = false;
+        } else if (connection->input_length < INPUT_LINE_LENGTH - 1) {
+            connection->input[connection->input_length++] = c;
+        } else {
+            connection->discarding = true;
+        }
+    }
+    if (connection->output.failed) connection->failed = true;
+}
+
+static void connection_read(Server* server, Connection* connection) {
+    char data[READ_CHUNK_SIZE];
+    for (;;) {
+        ssize_t received = read(connection->fd, data, sizeof(data));
+        if (received > 0) {
+            connection_receive(server, connection, data, (int)received);
+            if (connection->closing || connection->failed) return;
+            continue;
+        }
+        if (received < 0 && errno == EINTR) continue;
+        if (received == 0) {
+            connection->closing = true; // Client finished sending; flush the replies first
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            connection->failed = true;
+        }
+        return;
+    }
+}
+
+static void release_session(Server* server) {
+    pthread_mutex_lock(&server->lock);
+    server->sessions--;
+    pthread_mutex_unlock(&server->lock);
+}
+
+static void close_connection(Server* server, Connection* connection) {
+    close(connection->fd);
+    cleanup_session(connection->game);
+    text_output_free(&connection->output);
+    free(connection);
+    release_session(server);
+}
+
+static bool open_connection(Worker* worker, int fd) {
+    Server* server = worker->server;
+
+    if (worker->connections_count == worker->connections_capacity) {
+        int capacity = worker->connections_capacity ? worker->connections_capacity * 2 : 64;
+        Connection** connections = realloc(worker->connections, capacity * sizeof(Connection*));
+        if (!connections) return false;
+        worker->connections = connections;
+
+        struct pollfd* pollfds = realloc(worker->pollfds, (capacity + 1) * sizeof(struct pollfd));
+        if (!pollfds) return false;
+        worker->pollfds = pollfds;
+        worker->connections_capacity = capacity;
+    }
+
+    Connection* connection = calloc(1, sizeof(Connection));
+    GameState* game = create_session(server->world);
+    if (!connection || !game) {
+        free(connection);
+        cleanup_session(game);
+        return false;
+    }
+
+    connection->fd = fd;
+    connection->game = game;
+    text_output_init(&connection->output, fd, OUTPUT_LIMIT);
+    game->output = text_output_game;
+    game->output_context = &connection->output;
+
+    const GameMeta* meta = &server->world->meta;
+    char welcome[GAME_MESSAGE_LENGTH];
+    snprintf(welcome, sizeof(welcome), "Welcome to %s by %s\n\n", meta->title ? meta->title : "AdventureGPT",
+             meta->author ? meta->author : "unknown");
+    connection_print(connection, welcome);
+    text_output_describe(&connection->output, server->wrapped, game);
+    connection_print(connection, PROMPT);
+    connection_flush(connection);
+
+    worker->connections[worker->connections_count++] = connection;
+    return true;
+}
+
+// Take over the sockets the acceptor queued; returns false once asked to stop
+static bool take_pending(Worker* worker) {
+    char drain[64];
+    while (read(worker->wake_pipe[0], drain, sizeof(drain)) > 0) {
+    }
+
+    pthread_mutex_lock(&worker->lock);
+    bool stopping = worker->stopping;
+    int* pending = worker->pending;
+    int pending_count = worker->pending_count;
+    worker->pending = NULL;
+    worker->pending_count = 0;
+    worker->pending_capacity = 0;
+    pthread_mutex_unlock(&worker->lock);
+
+    for (int i = 0; i < pending_count; i++) {
+        if (stopping || !open_connection(worker, pending[i])) {
+            if (!stopping) printf("Error: Could not allocate session\n");
+            close(pending[i]);
+            release_session(worker->server);
+        }
+    }
+    free(pending);
+    return !stopping;
+}
+
+static void* worker_main(void* argument) {
+    Worker* worker = argument;
+    Server* server = worker->server;
+    bool active = true;
+
+    while (active) {
+        int count = worker->connections_count;
+        worker->pollfds[0].fd = worker->wake_pipe[0];
+        worker->pollfds[0].events = POLLIN;
+        for (int i = 0; i < count; i++) {
+            worker->pollfds[i + 1].fd = worker->connections[i]->fd;
+            worker->pollfds[i + 1].events = POLLIN | (worker->connections[i]->output.pending > 0 ? POLLOUT : 0);
+            worker->pollfds[i + 1].revents = 0;
+        }
+
+        if (poll(worker->pollfds, count + 1, -1) < 0) {
+            if (errno == EINTR) continue;
+            printf("Error: poll failed: %s\n", strerror(errno));
+            break;
+        }
+        bool woken = (worker->pollfds[0].revents & POLLIN) != 0;
+
+        // Serve every ready connection, then compact out the ones that closed
+        int kept = 0;
+        for (int i = 0; i < count; i++) {
+            Connection* connection = worker->connections[i];
+            short revents = worker->pollfds[i + 1].revents;
+
+            if (revents & (POLLIN | POLLHUP | POLLERR)) connection_read(server, connection);
+            if (connection->output.pending > 0) connection_flush(connection);
+
+            if (connection->failed || (connection->closing && connection->output.pending == 0)) {
+                close_connection(server, connection);
+            } else {
+                worker->connections[kept++] = connection;
+            }
+        }
+        worker->connections_count = kept;
+
+        if (woken) active = take_pending(worker);
+    }
+
+    for (int i = 0; i < worker->connections_count; i++) {
+        connection_print(worker->connections[i], "Server shutting down.\n");
+        connection_flush(worker->connections[i]);
+        close_connection(server, worker->connections[i]);
+    }
+    worker->connections_count = 0;
+    return NULL;
+}
+
+static void wake_worker(Worker* worker) {
+    char byte = 1;
+    // A full pipe already guarantees a wakeup
+    while (write(worker->wake_pipe[1], &byte, 1) < 0 && errno == EINTR) {
+    }
+}
+
+static bool hand_off(Worker* worker, int fd) {
+    pthread_mutex_lock(&worker->lock);
+    if (worker->pending_count == worker->pending_capacity) {
+        int capacity = worker->pending_capacity ? worker->pending_capacity * 2 : 16;
+        int* pending = realloc(worker->pending, capacity * sizeof(int));
+        if (!pending) {
+            pthread_mutex_unlock(&worker->lock);
+            return false;
+        }
+        worker->pending = pending;
+        worker->pending_capacity = capacity;
+    }
+    worker->pending[worker->pending_count++] = fd;
+    pthread_mutex_unlock(&worker->lock);
+
+    wake_worker(worker);
+    return true;
+}
+
+static bool reserve_session(Server* server) {
+    pthread_mutex_lock(&server->lock);
+    bool reserved = server->sessions < server->max_sessions;
+    if (reserved) server->sessions++;
+    pthread_mutex_unlock(&server->lock);
+    return reserved;
+}
+
+static int open_listener(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        printf("Error: Could not create socket: %s\n", strerror(errno));
+        return -1;
+    }
+
+    int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons((unsigned short)port);
+
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0 ||
+        !set_nonblocking(fd)) {
+        printf("Error: Could not listen on port %d: %s\n", port, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Accept until interrupted, spreading connections over the workers
+static void accept_loop(Server* server, int listener) {
+    int next_worker = 0;
+    struct pollfd pollfd = {listener, POLLIN, 0};
+
+    while (running) {
+        if (poll(&pollfd, 1, -1) < 0) {
+            if (errno == EINTR) continue;
+            printf("Error: poll failed: %s\n", strerror(errno));
+            return;
+        }
+
+        for (;;) {
+            int fd = accept(listener, NULL, NULL);
+            if (fd < 0) {
+                if (errno == EINTR) continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK) printf("Error: accept failed: %s\n", strerror(errno));
+                break;
+            }
+
+            int enable = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+            if (!set_nonblocking(fd)) {
+                close(fd);
+                continue;
+            }
+
+            if (!reserve_session(server)) {
+                static const char full[] = "Server full, try again later.\n";
+                if (write(fd, full, sizeof(full) - 1) < 0) {
+                    // The client is turned away either way
+                }
+                close(fd);
+                continue;
+            }
+
+            if (!hand_off(&server->workers[next_worker], fd)) {
+                close(fd);
+                release_session(server);
+            }
+            next_worker = (next_worker + 1) % server->workers_count;
+        }
+    }
+}
+
+static bool start_worker(Server* server, Worker* worker) {
+    memset(worker, 0, sizeof(*worker));
+    worker->server = server;
+    worker->pollfds = malloc(sizeof(struct pollfd));
+    if (!worker->pollfds) return false;
+
+    if (pipe(worker->wake_pipe) != 0) {
+        free(worker->pollfds);
+        return false;
+    }
+    set_nonblocking(worker->wake_pipe[0]);
+    set_nonblocking(worker->wake_pipe[1]);
+    pthread_mutex_init(&worker->lock, NULL);
+
+    if (pthread_create(&worker->thread, NULL, worker_main, worker) != 0) {
+        pthread_mutex_destroy(&worker->lock);
+        close(worker->wake_pipe[0]);
+        close(worker->wake_pipe[1]);
+        free(worker->pollfds);
+        return false;
+    }
+    return true;
+}
+
+static void stop_worker(Worker* worker) {
+    pthread_mutex_lock(&worker->lock);
+    worker->stopping = true;
+    pthread_mutex_unlock(&worker->lock);
+    wake_worker(worker);
+    pthread_join(worker->thread, NULL);
+
+    // Sockets queued after the worker's last look
+    for (int i = 0; i < worker->pending_count; i++) {
+        close(worker->pending[i]);
+        release_session(worker->server);
+    }
+    free(worker->pending);
+    free(worker->connections);
+    free(worker->pollfds);
+    pthread_mutex_destroy(&worker->lock);
+    close(worker->wake_pipe[0]);
+    close(worker->wake_pipe[1]);
+}
+
+static void print_usage(const char* program) {
+    printf("Usage: %s [--port <n>] [--threads <n>] [--max-sessions <n>] [--width <columns>] [--lazy] [--stats] "
+           "<game_file>\n", program);
+    printf("--width wraps location descriptions (default %d, 0 to leave them unwrapped).\n", TEXT_OUTPUT_WIDTH);
+    printf("--lazy leaves location text in the game file until a session shows the location.\n");
+    printf("--stats breaks down the world's memory use and a new session's at startup.\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char* game_file = NULL;
+    int port = DEFAULT_PORT;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus > 0 ? (int)cpus : 1;
+    int max_sessions = DEFAULT_MAX_SESSIONS;
+    int width = TEXT_OUTPUT_WIDTH;
+    bool lazy = false;
+    bool stats = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-sessions") == 0 && i + 1 < argc) {
+            max_sessions = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--lazy") == 0) {
+            lazy = true;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats = true;
+        } else if (!game_file) {
+            game_file = argv[i];
+        } else {
+            game_file = NULL;
+            break;
+        }
+    }
+
+    if (!game_file || port <= 0 || port > 65535 || threads < 1 || max_sessions < 1 || width < 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    World* world = lazy ? load_world_lazy(game_file) : load_world(game_file);
+    if (!world) {
+        printf("Failed to load game: %s\n", game_file);
+        return 1;
+    }
+
+    WrappedText* wrapped = wrap_world_text(world, width);
+    if (!wrapped) {
+        cleanup_world(world);
+        return 1;
+    }
+
+    GameState* sample = stats ? create_session(world) : NULL;
+    if (sample) {
+        EngineMemoryStats memory = engine_memory_stats(sample);
+        print_memory_stats(&memory);
+        printf("  Wrapped descriptions: %zu bytes shared by every session\n",
+               wrapped->offsets ? wrapped->offsets[wrapped->locations_count] : 0);
+        cleanup_session(sample);
+    }
+
+    int listener = open_listener(port);
+    if (listener < 0) {
+        free_wrapped_text(wrapped);
+        cleanup_world(world);
+        return 1;
+    }
+
+    Server server;
+    memset(&server, 0, sizeof(server));
+    server.world = world;
+    server.wrapped = wrapped;
+    server.max_sessions = max_sessions;
+    server.workers = calloc(threads, sizeof(Worker));
+    pthread_mutex_init(&server.lock, NULL);
+    if (!server.workers) {
+        printf("Error: Could not allocate worker threads\n");
+        close(listener);
+        free_wrapped_text(wrapped);
+        cleanup_world(world);
+        return 1;
+    }
+
+    // Workers inherit a mask without SIGINT/SIGTERM so the acceptor's poll is the one interrupted
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_signal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    sigset_t blocked, previous;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGINT);
+    sigaddset(&blocked, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+    for (int i = 0; i < threads; i++) {
+        if (!start_worker(&server, &server.workers[i])) {
+            printf("Error: Could not start worker thread %d\n", i);
+            break;
+        }
+        server.workers_count++;
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+    if (server.workers_count > 0) {
+        printf("Serving %s on port %d (%d threads, up to %d sessions)\n", game_file, port, server.workers_count,
+               max_sessions);
+        printf("Per-session state: %zu bytes game session + %zu bytes connection, plus a delta per changed room\n",
+               session_size(world), sizeof(Connection));
+        fflush(stdout);
+        accept_loop(&server, listener);
+        printf("Shutting down\n");
+    }
+
+    close(listener);
+    for (int i = 0; i < server.workers_count; i++) {
+        stop_worker(&server.workers[i]);
+    }
+    free(server.workers);
+    pthread_mutex_destroy(&server.lock);
+    free_wrapped_text(wrapped);
+    cleanup_world(world);
+    return server.workers_count > 0 ? 0 : 1;
+}
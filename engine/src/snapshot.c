@@ -0,0 +1,263 @@
+#include "snapshot.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SNAPSHOT_NONE 0xFFFFFFFFu
+
+// Snapshot fields are little-endian on disk
+static uint32_t snapshot_u32(uint32_t value) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap32(value);
+#else
+    return value;
+#endif
+}
+
+static unsigned char* put_words(unsigned char* out, const unsigned int* words, int count) {
+    for (int i = 0; i < count; i++) {
+        uint32_t word = snapshot_u32(words[i]);
+        memcpy(out, &word, sizeof(word));
+        out += sizeof(word);
+    }
+    return out;
+}
+
+static const unsigned char* get_words(const unsigned char* in, unsigned int* words, int count) {
+    for (int i = 0; i < count; i++) {
+        uint32_t word;
+        memcpy(&word, in, sizeof(word));
+        words[i] = snapshot_u32(word);
+        in += sizeof(word);
+    }
+    return in;
+}
+
+static int inventory_words(const World* world) {
+    return BITSET_WORDS(world->item_symbols.count);
+}
+
+static int flag_words(const World* world) {
+    return BITSET_WORDS(world->flag_symbols.count);
+}
+
+static int taken_words(const World* world, const LocationDelta* delta) {
+    return delta->taken ? BITSET_WORDS(world->locations[delta->location].items_count) : 0;
+}
+
+// Clear bits past the last symbol so a damaged snapshot can't invent items
+static void mask_tail(unsigned int* words, int bits) {
+    if (bits % 32) words[bits / 32] &= (1u << (bits % 32)) - 1;
+}
+
+size_t snapshot_size(const GameState* game) {
+    const World* world = game->world;
+    size_t words = inventory_words(world) + flag_words(world);
+
+    const LocationOverlay* overlay = &game->overlay;
+    for (int i = 0; i < overlay->capacity; i++) {
+        const LocationDelta* delta = &overlay->deltas[i];
+        if (delta->location == INVALID_LOCATION) continue;
+        words += sizeof(SnapshotDelta) / sizeof(uint32_t) + taken_words(world, delta);
+    }
+    return sizeof(SnapshotHeader) + words * sizeof(uint32_t);
+}
+
+// Returns the bytes written, or 0 if the buffer is smaller than snapshot_size
+size_t snapshot_write(const GameState* game, void* buffer, size_t size) {
+    size_t needed = snapshot_size(game);
+    if (size < needed) return 0;
+
+    const World* world = game->world;
+    const LocationOverlay* overlay = &game->overlay;
+    int current = game->player.current_location_index;
+
+    SnapshotHeader header;
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = snapshot_u32(SNAPSHOT_VERSION);
+    header.locations_count = snapshot_u32((uint32_t)world->locations_count);
+    header.item_symbols_count = snapshot_u32((uint32_t)world->item_symbols.count);
+    header.flag_symbols_count = snapshot_u32((uint32_t)world->flag_symbols.count);
+    header.world_fingerprint = snapshot_u32(world->fingerprint);
+    header.tick = snapshot_u32(game->tick);
+    header.current_location = snapshot_u32(current == INVALID_LOCATION ? SNAPSHOT_NONE : (uint32_t)current);
+    header.deltas_count = snapshot_u32((uint32_t)overlay->count);
+
+    unsigned char* out = buffer;
+    memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+    out = put_words(out, game->player.inventory, inventory_words(world));
+    out = put_words(out, game->player.flags, flag_words(world));
+
+    for (int i = 0; i < overlay->capacity; i++) {
+        const LocationDelta* delta = &overlay->deltas[i];
+        if (delta->location == INVALID_LOCATION) continue;
+
+        unsigned int record[3] = {(unsigned int)delta->location, delta->state,
+                                  (unsigned int)taken_words(world, delta)};
+        out = put_words(out, record, 3);
+        if (delta->taken) out = put_words(out, delta->taken, record[2]);
+    }
+    return needed;
+}
+
+// Restores the session from a snapshot of the same world. The session is only
+// changed if the whole snapshot is valid.
+bool snapshot_read(GameState* game, const void* data, size_t size) {
+    const World* world = game->world;
+    SnapshotHeader header;
+    if (size < sizeof(header)) {
+        printf("Error: Snapshot is truncated\n");
+        return false;
+    }
+
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        snapshot_u32(header.version) != SNAPSHOT_VERSION) {
+        printf("Error: Not a version %d game snapshot\n", SNAPSHOT_VERSION);
+        return false;
+    }
+
+    uint32_t current = snapshot_u32(header.current_location);
+    uint32_t deltas_count = snapshot_u32(header.deltas_count);
+    if (snapshot_u32(header.locations_count) != (uint32_t)world->locations_count ||
+        snapshot_u32(header.item_symbols_count) != (uint32_t)world->item_symbols.count ||
+        snapshot_u32(header.flag_symbols_count) != (uint32_t)world->flag_symbols.count ||
+        snapshot_u32(header.world_fingerprint) != world->fingerprint ||
+        (current != SNAPSHOT_NONE && current >= (uint32_t)world->locations_count)) {
+        printf("Error: Snapshot was saved from a different game world\n");
+        return false;
+    }
+
+    const unsigned char* in = (const unsigned char*)data + sizeof(header);
+    const unsigned char* end = (const unsigned char*)data + size;
+    size_t bitset_bytes = (inventory_words(world) + flag_words(world)) * sizeof(uint32_t);
+    if ((size_t)(end - in) < bitset_bytes) {
+        printf("Error: Snapshot is truncated\n");
+        return false;
+    }
+
+    // Rebuild into a scratch session so a bad delta leaves the game untouched
+    GameState* restored = create_session(world);
+    if (!restored) return false;
+
+    in = get_words(in, restored->player.inventory, inventory_words(world));
+    in = get_words(in, restored->player.flags, flag_words(world));
+    mask_tail(restored->player.inventory, world->item_symbols.count);
+    mask_tail(restored->player.flags, world->flag_symbols.count);
+
+    restored->player.current_location_index = current == SNAPSHOT_NONE ? INVALID_LOCATION : (int)current;
+    restored->player.inventory_count = 0;
+    for (int i = 0; i < inventory_words(world); i++) {
+        restored->player.inventory_count += __builtin_popcount(restored->player.inventory[i]);
+    }
+
+    // Each delta record is at least three words, which bounds a damaged count
+    bool ok = deltas_count <= (size_t)(end - in) / sizeof(SnapshotDelta) &&
+              reserve_location_deltas(restored, (int)deltas_count);
+    for (uint32_t i = 0; i < deltas_count && ok; i++) {
+        unsigned int record[3];
+        ok = (size_t)(end - in) >= sizeof(record);
+        if (!ok) break;
+        in = get_words(in, record, 3);
+
+        ok = record[0] < (uint32_t)world->locations_count;
+        if (!ok) break;
+        const Location* location = &world->locations[record[0]];
+        unsigned int words = record[2];
+        ok = (words == 0 || words == (unsigned int)BITSET_WORDS(location->items_count)) &&
+             (size_t)(end - in) >= words * sizeof(uint32_t);
+        if (!ok) break;
+
+        LocationDelta* delta = touch_location(restored, (int)record[0]);
+        if (!delta) {
+            ok = false;
+            break;
+        }
+        delta->state = record[1];
+        if (words > 0) {
+            if (!delta->taken) delta->taken = calloc(words, sizeof(unsigned int));
+            if (!delta->taken) {
+                printf("Error: Could not allocate location state\n");
+                ok = false;
+                break;
+            }
+            in = get_words(in, delta->taken, words);
+        }
+    }
+
+    if (!ok) {
+        printf("Error: Snapshot is damaged\n");
+        cleanup_session(restored);
+        return false;
+    }
+
+    // Move the restored state into the caller's session, keeping its output settings
+    memcpy(game->player.inventory, restored->player.inventory, world->item_words * sizeof(unsigned int));
+    memcpy(game->player.flags, restored->player.flags, world->flag_words * sizeof(unsigned int));
+    game->player.inventory_count = restored->player.inventory_count;
+    game->player.current_location_index = restored->player.current_location_index;
+    game->tick = snapshot_u32(header.tick);
+    game->gate_version++; // The flags may differ from the ones cached routes were found with
+
+    LocationOverlay previous = game->overlay;
+    game->overlay = restored->overlay;
+    restored->overlay = previous;
+    cleanup_session(restored);
+    return true;
+}
+
+// Written to a temporary file and renamed over the old save, so a crash
+// mid-save never leaves a half-written snapshot behind
+bool save_snapshot(const GameState* game, const char* filename) {
+    size_t size = snapshot_size(game);
+    void* buffer = malloc(size);
+    if (!buffer) {
+        printf("Error: Could not allocate snapshot buffer\n");
+        return false;
+    }
+    snapshot_write(game, buffer, size);
+
+    char temporary[1024];
+    snprintf(temporary, sizeof(temporary), "%s.tmp", filename);
+    FILE* file = fopen(temporary, "wb");
+    bool ok = file && fwrite(buffer, 1, size, file) == size;
+    if (file && fclose(file) != 0) ok = false;
+    free(buffer);
+
+#ifdef _WIN32
+    if (ok) remove(filename); // rename does not replace existing files on Windows
+#endif
+    if (!ok || rename(temporary, filename) != 0) {
+        printf("Error: Could not write snapshot %s\n", filename);
+        remove(temporary);
+        return false;
+    }
+    return true;
+}
+
+bool load_snapshot(GameState* game, const char* filename) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        printf("Error: Could not open snapshot %s\n", filename);
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    void* data = size > 0 ? malloc(size) : NULL;
+    bool ok = data && fread(data, 1, size, file) == (size_t)size;
+    fclose(file);
+
+    if (!ok) {
+        printf("Error: Could not read snapshot %s\n", filename);
+        free(data);
+        return false;
+    }
+
+    ok = snapshot_read(game, data, size);
+    free(data);
+    return ok;
+}
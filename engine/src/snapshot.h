@@ -0,0 +1,45 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "adventure_engine.h"
+
+// Binary save of one session's mutable state. Every field is a little-endian
+// uint32: the header, then the inventory and flag bitsets (sized by the world's
+// symbol counts), then one SnapshotDelta per changed location, each followed
+// by taken_words words of its taken-items bitset. The inventory count is
+// recounted from the bitset on restore.
+#define SNAPSHOT_MAGIC "AGPS"
+#define SNAPSHOT_VERSION 2
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+
+    // The world the snapshot was taken in; restoring into one with other
+    // counts or other location, item or flag names in symbol order is refused
+    uint32_t locations_count;
+    uint32_t item_symbols_count;
+    uint32_t flag_symbols_count;
+    uint32_t world_fingerprint; // World.fingerprint
+
+    uint32_t tick; // GameState.tick, where replaying a journal picks up
+    uint32_t current_location; // 0xFFFFFFFF when the player is nowhere
+    uint32_t deltas_count;
+} SnapshotHeader;
+
+typedef struct {
+    uint32_t location;
+    uint32_t state;
+    uint32_t taken_words; // 0 when nothing was taken here
+} SnapshotDelta;
+
+size_t snapshot_size(const GameState* game);
+size_t snapshot_write(const GameState* game, void* buffer, size_t size);
+bool snapshot_read(GameState* game, const void* data, size_t size);
+bool save_snapshot(const GameState* game, const char* filename);
+bool load_snapshot(GameState* game, const char* filename);
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,319 @@
+#include "text_output.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define FLUSH_SEGMENTS 64 // Vectors per writev, well under any IOV_MAX
+#define IDLE_BUFFER_BYTES 4096 // Larger buffers are released once drained
+#define NO_SPACE ((size_t)-1)
+
+void text_output_init(TextOutput* output, int fd, size_t limit) {
+    memset(output, 0, sizeof(*output));
+    output->fd = fd;
+    output->limit = limit;
+}
+
+void text_output_free(TextOutput* output) {
+    free(output->buffer);
+    free(output->segments);
+    output->buffer = NULL;
+    output->segments = NULL;
+    output->buffer_capacity = 0;
+    output->segments_capacity = 0;
+}
+
+static bool accept_bytes(TextOutput* output, size_t length) {
+    if (output->failed) return false;
+    if (output->limit && output->pending + length > output->limit) {
+        output->failed = true;
+        return false;
+    }
+    return true;
+}
+
+static TextSegment* add_segment(TextOutput* output) {
+    if (output->segments_count == output->segments_capacity) {
+        int capacity = output->segments_capacity ? output->segments_capacity * 2 : 16;
+        TextSegment* segments = realloc(output->segments, capacity * sizeof(TextSegment));
+        if (!segments) {
+            output->failed = true;
+            return NULL;
+        }
+        output->segments = segments;
+        output->segments_capacity = capacity;
+    }
+    return &output->segments[output->segments_count++];
+}
+
+// Room for length more bytes at the end of the buffer, merged into the last
+// segment when that one ends there too
+static char* reserve_bytes(TextOutput* output, size_t length) {
+    if (!accept_bytes(output, length)) return NULL;
+
+    if (output->buffer_length + length > output->buffer_capacity) {
+        size_t capacity = output->buffer_capacity ? output->buffer_capacity : 256;
+        while (capacity < output->buffer_length + length) capacity *= 2;
+        char* buffer = realloc(output->buffer, capacity);
+        if (!buffer) {
+            output->failed = true;
+            return NULL;
+        }
+        output->buffer = buffer;
+        output->buffer_capacity = capacity;
+    }
+
+    TextSegment* last = output->segments_count > output->head ? &output->segments[output->segments_count - 1] : NULL;
+    if (last && !last->text && last->offset + last->length == output->buffer_length) {
+        last->length += length;
+    } else {
+        TextSegment* segment = add_segment(output);
+        if (!segment) return NULL;
+        segment->text = NULL;
+        segment->offset = output->buffer_length;
+        segment->length = length;
+    }
+
+    char* bytes = output->buffer + output->buffer_length;
+    output->buffer_length += length;
+    output->pending += length;
+    return bytes;
+}
+
+void text_output_write(TextOutput* output, const char* text, size_t length) {
+    if (length == 0) return;
+    char* bytes = reserve_bytes(output, length);
+    if (bytes) memcpy(bytes, text, length);
+}
+
+void text_output_print(TextOutput* output, const char* text) {
+    text_output_write(output, text, strlen(text));
+}
+
+// Queue text without copying it; the caller keeps it alive until the output
+// is flushed or freed
+void text_output_reference(TextOutput* output, const char* text, size_t length) {
+    if (length == 0 || !accept_bytes(output, length)) return;
+
+    TextSegment* segment = add_segment(output);
+    if (!segment) return;
+    segment->text = text;
+    segment->offset = 0;
+    segment->length = length;
+    output->pending += length;
+}
+
+void text_output_game(void* context, const char* text) {
+    text_output_print(context, text);
+}
+
+static void consume_bytes(TextOutput* output, size_t written) {
+    output->pending -= written;
+    while (written > 0) {
+        TextSegment* segment = &output->segments[output->head];
+        size_t left = segment->length - output->head_written;
+        if (written < left) {
+            output->head_written += written;
+            return;
+        }
+        written -= left;
+        output->head++;
+        output->head_written = 0;
+    }
+}
+
+// Write as much pending output as the descriptor takes without blocking.
+// Returns true once everything is out; on a non-blocking socket that is full,
+// the rest stays queued for the next flush.
+bool text_output_flush(TextOutput* output) {
+    while (output->pending > 0 && !output->failed) {
+        struct iovec vectors[FLUSH_SEGMENTS];
+        int count = 0;
+        for (int i = output->head; i < output->segments_count && count < FLUSH_SEGMENTS; i++) {
+            const TextSegment* segment = &output->segments[i];
+            const char* text = segment->text ? segment->text : output->buffer + segment->offset;
+            size_t skip = i == output->head ? output->head_written : 0;
+            vectors[count].iov_base = (void*)(text + skip);
+            vectors[count].iov_len = segment->length - skip;
+            count++;
+        }
+
+        ssize_t written = writev(output->fd, vectors, count);
+        output->writes++;
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) output->failed = true;
+            break;
+        }
+        consume_bytes(output, (size_t)written);
+    }
+
+    if (output->pending == 0) {
+        output->segments_count = 0;
+        output->head = 0;
+        output->head_written = 0;
+        output->buffer_length = 0;
+
+        // Idle sessions should not keep a large buffer around
+        if (output->buffer_capacity > IDLE_BUFFER_BYTES) {
+            free(output->buffer);
+            output->buffer = NULL;
+            output->buffer_capacity = 0;
+        }
+    }
+    return output->pending == 0 && !output->failed;
+}
+
+// Greedy word wrapping, one character at a time. Runs of spaces collapse to
+// one and a word longer than the width is split. Writes nothing when out is
+// NULL, so the same calls measure the wrapped length first.
+typedef struct {
+    char* out;
+    size_t length;
+    int width;
+    int column; // Columns on the current line, counting the word in progress
+    bool in_word;
+    bool pending_space; // A space separates the next word from the line so far
+    size_t space; // Offset of the last space on this line, NO_SPACE if none
+    int space_column; // Columns before that space
+} Wrapper;
+
+static void put_byte(Wrapper* wrapper, char c) {
+    if (wrapper->out) wrapper->out[wrapper->length] = c;
+    wrapper->length++;
+}
+
+static void wrap_char(Wrapper* wrapper, char c) {
+    if (wrapper->width <= 0) {
+        put_byte(wrapper, c);
+        return;
+    }
+
+    if (c == '\n') {
+        put_byte(wrapper, '\n');
+        wrapper->column = 0;
+        wrapper->in_word = false;
+        wrapper->pending_space = false;
+        wrapper->space = NO_SPACE;
+        return;
+    }
+    if (c == ' ' || c == '\t' || c == '\r') {
+        wrapper->in_word = false;
+        wrapper->pending_space = wrapper->column > 0;
+        return;
+    }
+
+    // UTF-8 continuation bytes belong to the character before them
+    if (((unsigned char)c & 0xC0) == 0x80) {
+        put_byte(wrapper, c);
+        return;
+    }
+
+    if (!wrapper->in_word) {
+        wrapper->in_word = true;
+        if (wrapper->pending_space) {
+            wrapper->space = wrapper->length;
+            wrapper->space_column = wrapper->column;
+            put_byte(wrapper, ' ');
+            wrapper->column++;
+            wrapper->pending_space = false;
+        }
+    }
+
+    if (wrapper->column >= wrapper->width) {
+        if (wrapper->space != NO_SPACE) {
+            // Move the word so far to a new line by turning its space into the break
+            if (wrapper->out) wrapper->out[wrapper->space] = '\n';
+            wrapper->column -= wrapper->space_column + 1;
+            wrapper->space = NO_SPACE;
+        }
+        if (wrapper->column >= wrapper->width) {
+            put_byte(wrapper, '\n');
+            wrapper->column = 0;
+        }
+    }
+    put_byte(wrapper, c);
+    wrapper->column++;
+}
+
+static void wrap_text(Wrapper* wrapper, const char* text) {
+    while (text && *text) wrap_char(wrapper, *text++);
+}
+
+// What describe_location prints for the location, wrapped; returns its length
+static size_t wrap_location(char* out, const Location* location, int width) {
+    Wrapper wrapper = {out, 0, width, 0, false, false, NO_SPACE, 0};
+
+    wrap_text(&wrapper, location->title);
+    wrap_char(&wrapper, '\n');
+    wrap_text(&wrapper, location->description);
+    wrap_char(&wrapper, '\n');
+
+    if (location->exits_count > 0) {
+        wrap_text(&wrapper, "Exits:");
+        for (int i = 0; i < location->exits_count; i++) {
+            wrap_text(&wrapper, i > 0 ? ", " : " ");
+            wrap_text(&wrapper, location->exits[i].direction);
+        }
+        wrap_char(&wrapper, '\n');
+    }
+    return wrapper.length;
+}
+
+WrappedText* wrap_world_text(const World* world, int width) {
+    WrappedText* wrapped = calloc(1, sizeof(WrappedText));
+    if (!wrapped) {
+        printf("Error: Could not allocate wrapped text\n");
+        return NULL;
+    }
+    wrapped->width = width > 0 ? width : 0;
+    wrapped->locations_count = world->locations_count;
+    if (world->text_offsets) return wrapped;
+
+    size_t total = 0;
+    wrapped->offsets = malloc((world->locations_count + 1) * sizeof(size_t));
+    if (wrapped->offsets) {
+        for (int i = 0; i < world->locations_count; i++) {
+            wrapped->offsets[i] = total;
+            total += wrap_location(NULL, &world->locations[i], wrapped->width);
+        }
+        wrapped->offsets[world->locations_count] = total;
+        wrapped->text = malloc(total > 0 ? total : 1);
+    }
+    if (!wrapped->offsets || !wrapped->text) {
+        printf("Error: Could not allocate wrapped text\n");
+        free_wrapped_text(wrapped);
+        return NULL;
+    }
+
+    for (int i = 0; i < world->locations_count; i++) {
+        wrap_location(wrapped->text + wrapped->offsets[i], &world->locations[i], wrapped->width);
+    }
+    return wrapped;
+}
+
+void free_wrapped_text(WrappedText* wrapped) {
+    if (!wrapped) return;
+    free(wrapped->offsets);
+    free(wrapped->text);
+    free(wrapped);
+}
+
+void text_output_describe(TextOutput* output, const WrappedText* wrapped, GameState* game) {
+    if (game->quiet) return;
+
+    int index = game->player.current_location_index;
+    if (wrapped->offsets && index >= 0 && index < wrapped->locations_count) {
+        size_t offset = wrapped->offsets[index];
+        text_output_reference(output, wrapped->text + offset, wrapped->offsets[index + 1] - offset);
+        return;
+    }
+
+    const Location* location = get_current_location(game);
+    if (!location) return;
+    size_t length = wrap_location(NULL, location, wrapped->width);
+    char* bytes = length > 0 ? reserve_bytes(output, length) : NULL;
+    if (bytes) wrap_location(bytes, location, wrapped->width);
+}
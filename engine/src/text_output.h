@@ -0,0 +1,65 @@
+#ifndef TEXT_OUTPUT_H
+#define TEXT_OUTPUT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "adventure_engine.h"
+
+// Terminal width text frontends wrap to unless told otherwise; 0 turns wrapping off
+#define TEXT_OUTPUT_WIDTH 80
+
+// A piece of pending output: bytes copied into the output's own buffer, or
+// borrowed text that must stay valid until the output is flushed or freed
+typedef struct {
+    const char* text; // NULL for copied bytes, which live at offset in buffer
+    size_t offset;
+    size_t length;
+} TextSegment;
+
+// Buffered output for one file descriptor or socket. Everything one command
+// prints is queued and goes out with a single writev per flush.
+typedef struct {
+    int fd;
+    size_t limit; // Pending bytes past which the output fails, 0 for no limit
+    char* buffer;
+    size_t buffer_length;
+    size_t buffer_capacity;
+    TextSegment* segments;
+    int segments_count;
+    int segments_capacity;
+    int head; // First segment not fully written
+    size_t head_written; // Bytes of segments[head] already written
+    size_t pending;
+    long writes; // System calls made so far
+    bool failed; // Write error, allocation failure or over the limit
+} TextOutput;
+
+void text_output_init(TextOutput* output, int fd, size_t limit);
+void text_output_free(TextOutput* output);
+void text_output_write(TextOutput* output, const char* text, size_t length);
+void text_output_print(TextOutput* output, const char* text);
+void text_output_reference(TextOutput* output, const char* text, size_t length);
+bool text_output_flush(TextOutput* output);
+
+// GameOutput adapter: set game->output to this and output_context to the TextOutput
+void text_output_game(void* context, const char* text);
+
+// Location descriptions word-wrapped to a fixed width. For a fully loaded world
+// every location is wrapped up front into one read-only block that any number
+// of threads and sessions can share; a lazily loaded world keeps only the width
+// and wraps each description as it is shown, so its text stays in the file.
+typedef struct {
+    int width; // Columns, 0 for unwrapped
+    int locations_count;
+    size_t* offsets; // Location i is text[offsets[i], offsets[i + 1]), NULL for lazy worlds
+    char* text;
+} WrappedText;
+
+WrappedText* wrap_world_text(const World* world, int width);
+void free_wrapped_text(WrappedText* wrapped);
+
+// Queue what describe_location prints for the session's current location,
+// wrapped to wrapped->width, without copying it for fully loaded worlds
+void text_output_describe(TextOutput* output, const WrappedText* wrapped, GameState* game);
+
+#endif // TEXT_OUTPUT_H
@@ -0,0 +1,106 @@
+#include "texture_cache.h"
+#include <stdlib.h>
+#include <string.h>
+
+void texture_cache_init(TextureCache* cache, size_t budget) {
+    memset(cache, 0, sizeof(*cache));
+    cache->budget = budget;
+}
+
+void texture_cache_destroy(TextureCache* cache) {
+    for (int i = 0; i < cache->count; i++) {
+        SDL_DestroyTexture(cache->entries[i].texture);
+        free(cache->entries[i].path);
+    }
+    free(cache->entries);
+    memset(cache, 0, sizeof(*cache));
+}
+
+static int find_entry(const TextureCache* cache, const char* path) {
+    for (int i = 0; i < cache->count; i++) {
+        if (strcmp(cache->entries[i].path, path) == 0) return i;
+    }
+    return -1;
+}
+
+static size_t texture_bytes(SDL_Texture* texture) {
+    Uint32 format;
+    int width, height;
+    if (SDL_QueryTexture(texture, &format, NULL, &width, &height) != 0) return 0;
+    return (size_t)width * height * SDL_BYTESPERPIXEL(format);
+}
+
+static void remove_entry(TextureCache* cache, int index) {
+    CachedTexture* entry = &cache->entries[index];
+    SDL_DestroyTexture(entry->texture);
+    free(entry->path);
+    cache->bytes -= entry->bytes;
+    cache->entries[index] = cache->entries[--cache->count];
+}
+
+// Evict least recently used textures until the cache fits its budget
+static void evict(TextureCache* cache, SDL_Texture* keep) {
+    while (cache->bytes > cache->budget) {
+        int oldest = -1;
+        for (int i = 0; i < cache->count; i++) {
+            SDL_Texture* texture = cache->entries[i].texture;
+            if (texture == keep || texture == cache->pinned) continue;
+            if (oldest < 0 || cache->entries[i].last_used < cache->entries[oldest].last_used) {
+                oldest = i;
+            }
+        }
+        if (oldest < 0) break; // Only protected textures left
+        remove_entry(cache, oldest);
+    }
+}
+
+SDL_Texture* texture_cache_get(TextureCache* cache, const char* path) {
+    int index = find_entry(cache, path);
+    if (index < 0) return NULL;
+
+    cache->entries[index].last_used = ++cache->clock;
+    return cache->entries[index].texture;
+}
+
+bool texture_cache_contains(const TextureCache* cache, const char* path) {
+    return find_entry(cache, path) >= 0;
+}
+
+// Take ownership of texture under path; returns it, or NULL if it couldn't be stored
+SDL_Texture* texture_cache_put(TextureCache* cache, const char* path, SDL_Texture* texture) {
+    int index = find_entry(cache, path);
+    if (index >= 0 && cache->entries[index].texture != cache->pinned) {
+        remove_entry(cache, index);
+    } else if (index >= 0) {
+        // The on-screen copy stays; this duplicate isn't needed
+        SDL_DestroyTexture(texture);
+        return texture_cache_get(cache, path);
+    }
+
+    if (cache->count == cache->capacity) {
+        int capacity = cache->capacity ? cache->capacity * 2 : 16;
+        CachedTexture* entries = realloc(cache->entries, capacity * sizeof(CachedTexture));
+        if (!entries) {
+            SDL_DestroyTexture(texture);
+            return NULL;
+        }
+        cache->entries = entries;
+        cache->capacity = capacity;
+    }
+
+    char* key = strdup(path);
+    if (!key) {
+        SDL_DestroyTexture(texture);
+        return NULL;
+    }
+
+    CachedTexture* entry = &cache->entries[cache->count++];
+    entry->path = key;
+    entry->texture = texture;
+    entry->bytes = texture_bytes(texture);
+    entry->last_used = ++cache->clock;
+    cache->bytes += entry->bytes;
+
+    evict(cache, texture);
+    return texture;
+}
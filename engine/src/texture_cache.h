@@ -0,0 +1,34 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <SDL2/SDL.h>
+
+#define TEXTURE_CACHE_DEFAULT_BUDGET_MB 64
+
+typedef struct {
+    char* path;
+    SDL_Texture* texture;
+    size_t bytes;
+    unsigned long last_used;
+} CachedTexture;
+
+// Location textures keyed by image path, evicted least recently used first
+typedef struct {
+    CachedTexture* entries;
+    int count;
+    int capacity;
+    size_t bytes; // Estimated texture memory of all entries
+    size_t budget;
+    unsigned long clock;
+    SDL_Texture* pinned; // On screen; never evicted
+} TextureCache;
+
+void texture_cache_init(TextureCache* cache, size_t budget);
+void texture_cache_destroy(TextureCache* cache);
+SDL_Texture* texture_cache_get(TextureCache* cache, const char* path);
+bool texture_cache_contains(const TextureCache* cache, const char* path);
+SDL_Texture* texture_cache_put(TextureCache* cache, const char* path, SDL_Texture* texture);
+
+#endif // TEXTURE_CACHE_H
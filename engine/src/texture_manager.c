@@ -0,0 +1,97 @@
+#include "texture_manager.h"
+#include <stdio.h>
+
+static bool renderer_supports_format(SDL_Renderer* renderer, Uint32 format) {
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer, &info) != 0) return false;
+
+    for (Uint32 i = 0; i < info.num_texture_formats; i++) {
+        if (info.texture_formats[i] == format) return true;
+    }
+    return false;
+}
+
+bool texture_manager_init(TextureManager* manager, SDL_Renderer* renderer, int width, int height,
+                          size_t budget, bool low_color) {
+    manager->renderer = renderer;
+    manager->format = SDL_PIXELFORMAT_RGB888;
+
+    // Halves texture memory; only worth it if the GPU stores 16-bit textures natively
+    if (low_color) {
+        if (renderer_supports_format(renderer, SDL_PIXELFORMAT_RGB565)) {
+            manager->format = SDL_PIXELFORMAT_RGB565;
+        } else {
+            printf("Warning: Renderer has no RGB565 textures, using RGB888\n");
+        }
+    }
+
+    // Decode location art off the main thread, leaving one core for rendering
+    if (!image_loader_init(&manager->loader, SDL_GetCPUCount() - 1, width, height, manager->format)) {
+        return false;
+    }
+    texture_cache_init(&manager->cache, budget);
+    return true;
+}
+
+void texture_manager_destroy(TextureManager* manager) {
+    image_loader_destroy(&manager->loader);
+    texture_cache_destroy(&manager->cache);
+}
+
+// Upload on the render thread; the surface is already in the manager's format and size
+static SDL_Texture* upload_image(TextureManager* manager, const char* path, SDL_Surface* surface) {
+    SDL_Texture* texture = SDL_CreateTexture(manager->renderer, manager->format, SDL_TEXTUREACCESS_STATIC,
+                                             surface->w, surface->h);
+    if (texture && SDL_UpdateTexture(texture, NULL, surface->pixels, surface->pitch) != 0) {
+        SDL_DestroyTexture(texture);
+        texture = NULL;
+    }
+    SDL_FreeSurface(surface);
+
+    if (!texture) {
+        printf("Unable to create texture from %s! SDL Error: %s\n", path, SDL_GetError());
+        return NULL;
+    }
+
+    return texture_cache_put(&manager->cache, path, texture);
+}
+
+static void upload_prefetched_image(void* context, const char* path, SDL_Surface* surface) {
+    upload_image(context, path, surface);
+}
+
+// Returns a cached texture; only decodes on this thread if no prefetch got to it first
+SDL_Texture* texture_manager_get(TextureManager* manager, const char* path) {
+    if (!path || path[0] == '\0') return NULL;
+
+    SDL_Texture* texture = texture_cache_get(&manager->cache, path);
+    if (texture) {
+        manager->hits++;
+        return texture;
+    }
+    manager->misses++;
+
+    SDL_Surface* surface = image_loader_take(&manager->loader, path);
+    if (!surface) return NULL;
+
+    return upload_image(manager, path, surface);
+}
+
+void texture_manager_prefetch(TextureManager* manager, const char* path) {
+    if (!path || path[0] == '\0' || texture_cache_contains(&manager->cache, path)) return;
+    image_loader_request(&manager->loader, path);
+}
+
+void texture_manager_cancel_prefetch(TextureManager* manager) {
+    image_loader_cancel_queued(&manager->loader);
+}
+
+// Upload everything the workers finished; call when loader.done_event arrives
+void texture_manager_collect(TextureManager* manager) {
+    image_loader_collect(&manager->loader, upload_prefetched_image, manager);
+}
+
+// The pinned texture is on screen and survives eviction
+void texture_manager_pin(TextureManager* manager, SDL_Texture* texture) {
+    manager->cache.pinned = texture;
+}
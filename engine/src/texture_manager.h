@@ -0,0 +1,29 @@
+#ifndef TEXTURE_MANAGER_H
+#define TEXTURE_MANAGER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <SDL2/SDL.h>
+#include "image_loader.h"
+#include "texture_cache.h"
+
+// Location art, decoded in the background at display size and kept under a memory budget
+typedef struct {
+    SDL_Renderer* renderer;
+    ImageLoader loader;
+    TextureCache cache;
+    Uint32 format; // RGB888, or RGB565 in low color mode
+    unsigned long hits; // texture_manager_get calls answered from the cache
+    unsigned long misses; // Calls that waited on or started a decode
+} TextureManager;
+
+bool texture_manager_init(TextureManager* manager, SDL_Renderer* renderer, int width, int height,
+                          size_t budget, bool low_color);
+void texture_manager_destroy(TextureManager* manager);
+SDL_Texture* texture_manager_get(TextureManager* manager, const char* path);
+void texture_manager_prefetch(TextureManager* manager, const char* path);
+void texture_manager_cancel_prefetch(TextureManager* manager);
+void texture_manager_collect(TextureManager* manager);
+void texture_manager_pin(TextureManager* manager, SDL_Texture* texture);
+
+#endif // TEXTURE_MANAGER_H
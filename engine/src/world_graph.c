@@ -0,0 +1,161 @@
+#include "world_graph.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Breadth-first search state from one source. Distances are final as soon as
+// a location is discovered, so a query only expands the frontier until its
+// target turns up and the next query carries on from there.
+struct RouteCache {
+    int source; // INVALID_LOCATION until the first query
+    unsigned int gate_version; // The session's gate_version the search ran under
+    int* distance; // Moves from source, -1 while undiscovered
+    int* previous; // Location each discovered one was reached from
+    int* queue; // Discovered locations in order; [head, tail) are not expanded yet
+    int head;
+    int tail;
+};
+
+size_t world_graph_size(const WorldSizes* sizes) {
+    return ARENA_ALIGN((sizes->locations + 1) * sizeof(int)) + ARENA_ALIGN(sizes->exits * sizeof(int)) +
+           ARENA_ALIGN(BITSET_WORDS(sizes->locations) * sizeof(unsigned int)) +
+           ARENA_ALIGN(BITSET_WORDS(sizes->flag_names) * sizeof(unsigned int));
+}
+
+void world_graph_init(WorldGraph* graph, Arena* arena, const WorldSizes* sizes) {
+    graph->offsets = arena_alloc(arena, (sizes->locations + 1) * sizeof(int));
+    graph->targets = arena_alloc(arena, sizes->exits * sizeof(int));
+    graph->edges_count = 0;
+    graph->edges_capacity = sizes->exits;
+    graph->gated = arena_alloc(arena, BITSET_WORDS(sizes->locations) * sizeof(unsigned int));
+    graph->gate_flags = arena_alloc(arena, BITSET_WORDS(sizes->flag_names) * sizeof(unsigned int));
+}
+
+// Exits must already be resolved to target indices. Fails if the locations
+// hold more exits than the loader counted, which only a damaged file can cause.
+bool build_world_graph(World* world) {
+    WorldGraph* graph = &world->graph;
+    int edges = 0;
+
+    for (int i = 0; i < world->locations_count; i++) {
+        const Location* location = &world->locations[i];
+        graph->offsets[i] = edges;
+        for (int j = 0; j < location->exits_count; j++) {
+            if (location->exits[j].target_index == INVALID_LOCATION) continue;
+            if (edges == graph->edges_capacity) return false;
+            graph->targets[edges++] = location->exits[j].target_index;
+        }
+
+        if (location->flags_required_count > 0) BIT_SET(graph->gated, i);
+        for (int t = 0; t < location->flags_required_count; t++) {
+            graph->gate_flags[location->flags_required[t].word] |= location->flags_required[t].mask;
+        }
+    }
+    graph->offsets[world->locations_count] = edges;
+    graph->edges_count = edges;
+    return true;
+}
+
+size_t route_cache_bytes(const RouteCache* routes, const World* world) {
+    return routes ? sizeof(RouteCache) + 3 * world->locations_count * sizeof(int) : 0;
+}
+
+void free_route_cache(RouteCache* routes) {
+    if (!routes) return;
+    free(routes->distance);
+    free(routes->previous);
+    free(routes->queue);
+    free(routes);
+}
+
+// The session's search from `from`, restarted if it was for another source or
+// a gating flag changed since
+static RouteCache* prepare_routes(GameState* game, int from) {
+    const World* world = game->world;
+    if (from < 0 || from >= world->locations_count) return NULL;
+
+    RouteCache* routes = game->routes;
+    if (!routes) {
+        routes = calloc(1, sizeof(RouteCache));
+        if (routes) {
+            routes->distance = malloc(world->locations_count * sizeof(int));
+            routes->previous = malloc(world->locations_count * sizeof(int));
+            routes->queue = malloc(world->locations_count * sizeof(int));
+        }
+        if (!routes || !routes->distance || !routes->previous || !routes->queue) {
+            printf("Error: Could not allocate route search\n");
+            free_route_cache(routes);
+            return NULL;
+        }
+        routes->source = INVALID_LOCATION;
+        game->routes = routes;
+    }
+
+    if (routes->source != from || routes->gate_version != game->gate_version) {
+        memset(routes->distance, 0xFF, world->locations_count * sizeof(int));
+        routes->source = from;
+        routes->gate_version = game->gate_version;
+        routes->distance[from] = 0;
+        routes->previous[from] = INVALID_LOCATION;
+        routes->queue[0] = from;
+        routes->head = 0;
+        routes->tail = 1;
+    }
+    return routes;
+}
+
+// Expand the frontier until `to` is discovered, or everything reachable is
+// when to is INVALID_LOCATION
+static void search_until(GameState* game, RouteCache* routes, int to) {
+    const World* world = game->world;
+    const WorldGraph* graph = &world->graph;
+
+    while (routes->head < routes->tail && (to == INVALID_LOCATION || routes->distance[to] < 0)) {
+        int location = routes->queue[routes->head++];
+        for (int e = graph->offsets[location]; e < graph->offsets[location + 1]; e++) {
+            int target = graph->targets[e];
+            if (routes->distance[target] >= 0) continue;
+            if (BIT_TEST(graph->gated, target) && !check_location_requirements(game, &world->locations[target])) {
+                continue;
+            }
+
+            routes->distance[target] = routes->distance[location] + 1;
+            routes->previous[target] = location;
+            routes->queue[routes->tail++] = target;
+        }
+    }
+}
+
+int route_distance(GameState* game, int from, int to) {
+    if (!game || to < 0 || to >= game->world->locations_count) return -1;
+
+    RouteCache* routes = prepare_routes(game, from);
+    if (!routes) return -1;
+    search_until(game, routes, to);
+    return routes->distance[to];
+}
+
+// Fills path with the locations after `from` up to and including `to`.
+// Returns the number of moves, or -1 if there is no route of at most max_steps.
+int find_route(GameState* game, int from, int to, int* path, int max_steps) {
+    int steps = route_distance(game, from, to);
+    if (steps < 0 || steps > max_steps) return -1;
+
+    const RouteCache* routes = game->routes;
+    int location = to;
+    for (int i = steps - 1; i >= 0; i--) {
+        path[i] = location;
+        location = routes->previous[location];
+    }
+    return steps;
+}
+
+// Locations reachable from `from`, counting itself; -1 if from is not a location
+int count_reachable(GameState* game, int from) {
+    if (!game) return -1;
+
+    RouteCache* routes = prepare_routes(game, from);
+    if (!routes) return -1;
+    search_until(game, routes, INVALID_LOCATION);
+    return routes->tail;
+}
@@ -0,0 +1,23 @@
+#ifndef WORLD_GRAPH_H
+#define WORLD_GRAPH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "adventure_engine.h"
+
+// Building: loaders reserve world_graph_size bytes, allocate_world carves the
+// arrays out of the arena, and load_world fills them once exits are resolved
+size_t world_graph_size(const WorldSizes* sizes);
+void world_graph_init(WorldGraph* graph, Arena* arena, const WorldSizes* sizes);
+bool build_world_graph(World* world);
+
+// Route queries for a session, over exits whose target's flags_required the
+// session currently meets. Breadth-first from the source, resumed as far as each
+// query needs and reused until the source or a gating flag changes.
+int route_distance(GameState* game, int from, int to); // Moves needed, -1 if unreachable
+int find_route(GameState* game, int from, int to, int* path, int max_steps);
+int count_reachable(GameState* game, int from);
+size_t route_cache_bytes(const RouteCache* routes, const World* world);
+void free_route_cache(RouteCache* routes);
+
+#endif // WORLD_GRAPH_H
@@ -0,0 +1,296 @@
+#include "world_regions.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Targets without POSIX threads load their regions one after another
+#if !defined(_WIN32) && !defined(ENGINE_NO_THREADS)
+#define REGION_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+static int configured_threads;
+
+// Files handed out to the pool, claimed one at a time so a large region does
+// not hold up the others
+typedef struct {
+    const char* const* files; // The manifest, then its regions
+    World** worlds;
+    int count;
+    int next;
+} RegionQueue;
+
+// Region symbol -> merged symbol, per symbol table
+typedef struct {
+    int* items;
+    int* flags;
+} RegionMap;
+
+void set_region_threads(int threads) {
+    configured_threads = threads > 0 ? threads : 0;
+}
+
+static int pool_size(int files) {
+    int threads = configured_threads;
+#ifdef REGION_THREADS
+    if (threads == 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (threads < 1) threads = 1;
+    if (threads > REGION_THREADS_MAX) threads = REGION_THREADS_MAX;
+    return threads < files ? threads : files;
+}
+
+static void* region_worker(void* context) {
+    RegionQueue* queue = context;
+    int i;
+    while ((i = __atomic_fetch_add(&queue->next, 1, __ATOMIC_RELAXED)) < queue->count) {
+        queue->worlds[i] = load_region_world(queue->files[i]);
+    }
+    return NULL;
+}
+
+static void load_files(RegionQueue* queue) {
+#ifdef REGION_THREADS
+    pthread_t workers[REGION_THREADS_MAX];
+    int threads = pool_size(queue->count);
+    int started = 0;
+    while (started < threads - 1 && pthread_create(&workers[started], NULL, region_worker, queue) == 0) {
+        started++;
+    }
+    region_worker(queue); // The calling thread loads too, and alone if no worker started
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+#else
+    region_worker(queue);
+#endif
+}
+
+static int count_bits(unsigned int bits) {
+    int count = 0;
+    for (; bits; bits &= bits - 1) count++;
+    return count;
+}
+
+// Flags named by the location's conditions, an upper bound on its merged terms
+static int condition_flags(const Location* location) {
+    int flags = 0;
+    for (int i = 0; i < location->flags_required_count; i++) flags += count_bits(location->flags_required[i].mask);
+    for (int i = 0; i < location->flags_set_count; i++) flags += count_bits(location->flags_set[i].mask);
+    return flags;
+}
+
+// Recompile a region's condition over merged flag symbols, taking its terms
+// from the shared array at *next
+static void remap_condition(FlagTerm** terms, int* count, const int* flags, FlagTerm** next) {
+    FlagTerm* merged = *next;
+    int merged_count = 0;
+    for (int i = 0; i < *count; i++) {
+        const FlagTerm* term = &(*terms)[i];
+        for (int bit = 0; bit < 32; bit++) {
+            if (!(term->mask >> bit & 1u)) continue;
+            merged_count = add_flag_term(merged, merged_count, flags[term->word * 32 + bit], term->values >> bit & 1u);
+        }
+    }
+    *terms = merged_count > 0 ? merged : NULL;
+    *count = merged_count;
+    *next += merged_count;
+}
+
+// Symbols of every region in list order: all defined items first, so merged
+// item symbols still match inventory_items indices, then the other item names
+// and the flags
+static bool merge_symbols(World* world, World** regions, int count, RegionMap* maps) {
+    for (int r = 0; r < count; r++) {
+        const World* region = regions[r];
+        for (int k = 0; k < region->inventory_items_count; k++) {
+            int symbol = symbol_intern_static(&world->item_symbols, symbol_name(&region->item_symbols, k));
+            if (symbol == INVALID_SYMBOL) return false;
+            if (symbol == world->inventory_items_count) {
+                world->inventory_items[world->inventory_items_count++] = region->inventory_items[k];
+            }
+            maps[r].items[k] = symbol;
+        }
+    }
+    for (int r = 0; r < count; r++) {
+        const World* region = regions[r];
+        for (int k = region->inventory_items_count; k < region->item_symbols.count; k++) {
+            maps[r].items[k] = symbol_intern_static(&world->item_symbols, symbol_name(&region->item_symbols, k));
+            if (maps[r].items[k] == INVALID_SYMBOL) return false;
+        }
+        for (int k = 0; k < region->flag_symbols.count; k++) {
+            maps[r].flags[k] = symbol_intern_static(&world->flag_symbols, symbol_name(&region->flag_symbols, k));
+            if (maps[r].flags[k] == INVALID_SYMBOL) return false;
+        }
+    }
+    return true;
+}
+
+// Copy each region's locations in, skipping ids an earlier region defined.
+// Exits and item lists stay in the region's arena; item lists are remapped in
+// place and conditions recompiled into the merged arena.
+static bool merge_locations(World* world, World** regions, int count, const RegionMap* maps, FlagTerm* terms) {
+    for (int r = 0; r < count; r++) {
+        World* region = regions[r];
+        for (int i = 0; i < region->locations_count; i++) {
+            const Location* source = &region->locations[i];
+            int symbol = symbol_intern_static(&world->location_symbols, source->id);
+            if (symbol == INVALID_SYMBOL) return false;
+            if (symbol != world->locations_count) continue;
+
+            Location* location = &world->locations[world->locations_count++];
+            *location = *source;
+            for (int j = 0; j < location->items_count; j++) {
+                location->items[j] = maps[r].items[location->items[j]];
+            }
+            remap_condition(&location->flags_required, &location->flags_required_count, maps[r].flags, &terms);
+            remap_condition(&location->flags_set, &location->flags_set_count, maps[r].flags, &terms);
+        }
+    }
+    return true;
+}
+
+// Game flag defaults from every region; the manifest supplies the game's meta,
+// start location and player, whose flags override the defaults where the
+// manifest's own player differs from its game_flags
+static void merge_start(World* world, World** regions, int count, const RegionMap* maps) {
+    for (int r = 0; r < count; r++) {
+        const World* region = regions[r];
+        for (int k = 0; k < region->flag_symbols.count; k++) {
+            if (BIT_TEST(region->game_flags, k)) BIT_SET(world->game_flags, maps[r].flags[k]);
+        }
+    }
+    memcpy(world->start.flags, world->game_flags, world->flag_words * sizeof(unsigned int));
+
+    const World* manifest = regions[0];
+    for (int k = 0; k < manifest->flag_symbols.count; k++) {
+        bool value = BIT_TEST(manifest->start.flags, k);
+        if (value == (bool)BIT_TEST(manifest->game_flags, k)) continue;
+        if (value) {
+            BIT_SET(world->start.flags, maps[0].flags[k]);
+        } else {
+            BIT_CLEAR(world->start.flags, maps[0].flags[k]);
+        }
+    }
+    for (int k = 0; k < manifest->item_symbols.count; k++) {
+        int symbol = maps[0].items[k];
+        if (BIT_TEST(manifest->start.inventory, k) && !BIT_TEST(world->start.inventory, symbol)) {
+            BIT_SET(world->start.inventory, symbol);
+            world->start.inventory_count++;
+        }
+    }
+
+    world->meta = manifest->meta;
+    world->start_location = manifest->start_location;
+    for (int r = 1; r < count && !world->start_location[0]; r++) {
+        world->start_location = regions[r]->start_location;
+    }
+
+    // The manifest's player location only resolved if the manifest defines it
+    int current = manifest->start.current_location_index;
+    if (current != INVALID_LOCATION) {
+        world->start.current_location_index = symbol_lookup(&world->location_symbols, manifest->locations[current].id);
+    } else {
+        world->start.current_location_index = symbol_lookup(&world->location_symbols, world->start_location);
+    }
+}
+
+// Takes ownership of the regions, which the merged world frees with itself
+static World* merge_regions(World** regions, int count) {
+    WorldSizes sizes = {0};
+    int terms = 0;
+    size_t regions_peak = 0;
+    for (int r = 0; r < count; r++) {
+        const World* region = regions[r];
+        sizes.locations += region->locations_count;
+        sizes.inventory_items += region->inventory_items_count;
+        sizes.item_names += region->item_symbols.count;
+        sizes.flag_names += region->flag_symbols.count;
+        for (int i = 0; i < region->locations_count; i++) {
+            sizes.exits += region->locations[i].exits_count;
+            sizes.item_refs += region->locations[i].items_count;
+            terms += condition_flags(&region->locations[i]);
+        }
+        regions_peak += region->load_peak;
+    }
+    sizes.bytes = ARENA_ALIGN(terms * sizeof(FlagTerm)) + ARENA_ALIGN(count * sizeof(World*));
+    world_sizes_finish(&sizes);
+
+    World* world = allocate_world(&sizes);
+    RegionMap* maps = calloc(count, sizeof(RegionMap));
+    bool ok = world && maps;
+    if (world) {
+        world->regions = arena_alloc(&world->arena, count * sizeof(World*));
+        memcpy(world->regions, regions, count * sizeof(World*));
+        world->regions_count = count;
+    }
+    for (int r = 0; r < count && ok; r++) {
+        maps[r].items = malloc((regions[r]->item_symbols.count + 1) * sizeof(int));
+        maps[r].flags = malloc((regions[r]->flag_symbols.count + 1) * sizeof(int));
+        ok = maps[r].items && maps[r].flags;
+    }
+    if (!ok) printf("Error: Could not allocate memory for game world\n");
+
+    if (ok) {
+        world->meta.title = world->meta.author = world->meta.description = world->meta.version = "";
+        FlagTerm* merged_terms = arena_alloc(&world->arena, terms * sizeof(FlagTerm));
+        ok = merge_symbols(world, regions, count, maps) && merge_locations(world, regions, count, maps, merged_terms);
+        if (!ok) printf("Error: Game regions define more symbols than they were measured for\n");
+    }
+    if (ok) {
+        merge_start(world, regions, count, maps);
+        resolve_exits(world);
+        world->load_peak = world->arena.size + regions_peak;
+    }
+
+    for (int r = 0; r < count && maps; r++) {
+        free(maps[r].items);
+        free(maps[r].flags);
+    }
+    free(maps);
+
+    if (!ok) {
+        if (world) {
+            cleanup_world(world);
+        } else {
+            for (int r = 0; r < count; r++) cleanup_world(regions[r]);
+        }
+        return NULL;
+    }
+    return world;
+}
+
+World* load_world_regions(const char* manifest, const char* const* paths, int count) {
+    int files_count = count + 1;
+    const char** files = malloc(files_count * sizeof(const char*));
+    World** worlds = calloc(files_count, sizeof(World*));
+    if (!files || !worlds) {
+        printf("Error: Could not allocate memory for game world\n");
+        free(files);
+        free(worlds);
+        return NULL;
+    }
+    files[0] = manifest;
+    memcpy(files + 1, paths, count * sizeof(const char*));
+
+    RegionQueue queue = {files, worlds, files_count, 0};
+    load_files(&queue);
+
+    bool loaded = true;
+    for (int i = 0; i < files_count; i++) {
+        if (worlds[i]) continue;
+        printf("Error: Could not load region %s\n", files[i]);
+        loaded = false;
+    }
+
+    World* world = NULL;
+    if (loaded) {
+        world = merge_regions(worlds, files_count);
+    } else {
+        for (int i = 0; i < files_count; i++) cleanup_world(worlds[i]);
+    }
+    free(files);
+    free(worlds);
+    return world;
+}
@@ -0,0 +1,22 @@
+#ifndef WORLD_REGIONS_H
+#define WORLD_REGIONS_H
+
+#include "adventure_engine.h"
+
+// Most loader threads one manifest uses, however many cores there are
+#define REGION_THREADS_MAX 64
+
+// A manifest is a game file with a "regions" list of further game files:
+//     {"meta": {...}, "start_location": "gate", "player": {...},
+//      "regions": ["regions/town.advgpt", "regions/forest.advgpt"]}
+// The manifest and every region are parsed in parallel, each into a world of
+// its own, then merged in list order. An id defined by several files keeps
+// its first definition, exits are resolved across all of them at the end, and
+// symbol ids follow list order alone, so the merged world and snapshots of it
+// come out the same on any number of threads.
+World* load_world_regions(const char* manifest, const char* const* paths, int count);
+
+// Threads region loading may use; 0, the default, means one per online core
+void set_region_threads(int threads);
+
+#endif // WORLD_REGIONS_H
@@ -0,0 +1,256 @@
+#include "world_reload.h"
+#include "location_text.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool same_text(const char* a, const char* b) {
+    return strcmp(a ? a : "", b ? b : "") == 0;
+}
+
+static int count_terms(const FlagTerm* terms, int count) {
+    int flags = 0;
+    for (int i = 0; i < count; i++) {
+        for (unsigned int bits = terms[i].mask; bits; bits &= bits - 1) flags++;
+    }
+    return flags;
+}
+
+// Whether a condition names the flag with this value
+static bool has_term(const FlagTerm* terms, int count, int flag_symbol, bool value) {
+    if (flag_symbol == INVALID_SYMBOL) return false;
+    for (int i = 0; i < count; i++) {
+        if (terms[i].word != flag_symbol >> 5) continue;
+        unsigned int bit = 1u << (flag_symbol & 31);
+        return (terms[i].mask & bit) && (bool)(terms[i].values & bit) == value;
+    }
+    return false;
+}
+
+// Conditions compiled over two worlds' flag symbols, compared by flag name
+static bool same_condition(const World* previous, const FlagTerm* a, int a_count,
+                           const World* next, const FlagTerm* b, int b_count) {
+    if (count_terms(a, a_count) != count_terms(b, b_count)) return false;
+    for (int i = 0; i < a_count; i++) {
+        for (int bit = 0; bit < 32; bit++) {
+            if (!(a[i].mask >> bit & 1u)) continue;
+            const char* name = symbol_name(&previous->flag_symbols, a[i].word * 32 + bit);
+            if (!has_term(b, b_count, symbol_lookup(&next->flag_symbols, name), a[i].values >> bit & 1u)) return false;
+        }
+    }
+    return true;
+}
+
+static bool same_location(const World* previous, const Location* a, const World* next, const Location* b) {
+    if (!same_text(a->title, b->title) || !same_text(a->description, b->description) ||
+        !same_text(a->image_path, b->image_path) || !same_text(a->first_visit_text, b->first_visit_text) ||
+        a->visited != b->visited || a->exits_count != b->exits_count || a->items_count != b->items_count) {
+        return false;
+    }
+    for (int i = 0; i < a->exits_count; i++) {
+        if (!same_text(a->exits[i].direction, b->exits[i].direction) ||
+            !same_text(a->exits[i].target_location, b->exits[i].target_location)) {
+            return false;
+        }
+    }
+    for (int i = 0; i < a->items_count; i++) {
+        if (strcmp(symbol_name(&previous->item_symbols, a->items[i]), symbol_name(&next->item_symbols, b->items[i])) != 0) {
+            return false;
+        }
+    }
+    return same_condition(previous, a->flags_required, a->flags_required_count, next, b->flags_required, b->flags_required_count) &&
+           same_condition(previous, a->flags_set, a->flags_set_count, next, b->flags_set, b->flags_set_count);
+}
+
+static bool same_item(const InventoryItem* a, const InventoryItem* b) {
+    return same_text(a->name, b->name) && same_text(a->description, b->description) &&
+           a->takeable == b->takeable && a->useable == b->useable && same_text(a->use_text, b->use_text);
+}
+
+// Two bitsets over two worlds' symbol tables hold the same names
+static bool same_bits(const SymbolTable* a_table, const unsigned int* a, const SymbolTable* b_table, const unsigned int* b) {
+    int matched = 0;
+    for (int k = 0; k < a_table->count; k++) {
+        if (!BIT_TEST(a, k)) continue;
+        int symbol = symbol_lookup(b_table, symbol_name(a_table, k));
+        if (symbol == INVALID_SYMBOL || !BIT_TEST(b, symbol)) return false;
+        matched++;
+    }
+    for (int k = 0; k < b_table->count; k++) {
+        if (BIT_TEST(b, k)) matched--;
+    }
+    return matched == 0;
+}
+
+static const char* location_id(const World* world, int location_index) {
+    return location_index == INVALID_LOCATION ? "" : world->locations[location_index].id;
+}
+
+static bool same_start(const World* previous, const World* next) {
+    return same_text(previous->start_location, next->start_location) &&
+           strcmp(location_id(previous, previous->start.current_location_index),
+                  location_id(next, next->start.current_location_index)) == 0 &&
+           same_bits(&previous->item_symbols, previous->start.inventory, &next->item_symbols, next->start.inventory) &&
+           same_bits(&previous->flag_symbols, previous->start.flags, &next->flag_symbols, next->start.flags) &&
+           same_bits(&previous->flag_symbols, previous->game_flags, &next->flag_symbols, next->game_flags);
+}
+
+static void diff_items(const World* previous, const World* next, WorldDiff* diff) {
+    int kept = 0;
+    for (int k = 0; k < previous->inventory_items_count; k++) {
+        int symbol = symbol_lookup(&next->item_symbols, previous->inventory_items[k].id);
+        if (symbol == INVALID_SYMBOL || symbol >= next->inventory_items_count) {
+            diff->items_changed++;
+            continue;
+        }
+        kept++;
+        if (!same_item(&previous->inventory_items[k], &next->inventory_items[symbol])) diff->items_changed++;
+    }
+    diff->items_changed += next->inventory_items_count - kept;
+}
+
+bool diff_worlds(const World* previous, const World* next, WorldDiff* diff) {
+    memset(diff, 0, sizeof(*diff));
+    int count = previous->locations_count;
+    diff->locations = malloc((count > 0 ? count : 1) * sizeof(int));
+    diff->changed = calloc(BITSET_WORDS(count) + 1, sizeof(unsigned int));
+
+    // Text left in the file is decoded a room at a time, one cache per world
+    LocationTextCache* previous_text = previous->text_offsets ? create_location_text_cache(1, 0) : NULL;
+    LocationTextCache* next_text = next->text_offsets ? create_location_text_cache(1, 0) : NULL;
+    bool ok = diff->locations && diff->changed && (previous_text || !previous->text_offsets) &&
+              (next_text || !next->text_offsets);
+    if (!ok) printf("Error: Could not allocate memory for world diff\n");
+
+    int kept = 0;
+    for (int i = 0; i < count && ok; i++) {
+        int j = symbol_lookup(&next->location_symbols, previous->locations[i].id);
+        diff->locations[i] = j;
+        if (j == INVALID_LOCATION) {
+            diff->locations_removed++;
+            continue;
+        }
+        kept++;
+
+        const Location* a = location_text(previous_text, previous, i);
+        const Location* b = location_text(next_text, next, j);
+        if (!a || !b) {
+            ok = false;
+        } else if (!same_location(previous, a, next, b)) {
+            BIT_SET(diff->changed, i);
+            diff->locations_changed++;
+        }
+    }
+    free_location_text_cache(previous_text);
+    free_location_text_cache(next_text);
+    if (!ok) {
+        free_world_diff(diff);
+        return false;
+    }
+
+    diff->old_locations_count = count;
+    diff->locations_added = next->locations_count - kept;
+    diff_items(previous, next, diff);
+    diff->start_changed = !same_start(previous, next);
+    return true;
+}
+
+void free_world_diff(WorldDiff* diff) {
+    free(diff->locations);
+    free(diff->changed);
+    memset(diff, 0, sizeof(*diff));
+}
+
+// Carry taken entries over by item id, so an edit that reorders or extends a
+// room's item list still leaves the same items gone
+static bool rebase_taken(LocationDelta* delta, const World* previous, const Location* a,
+                         const unsigned int* taken, const World* next, const Location* b) {
+    for (int i = 0; i < a->items_count; i++) {
+        if (!BIT_TEST(taken, i)) continue;
+        const char* item_id = symbol_name(&previous->item_symbols, a->items[i]);
+        for (int j = 0; j < b->items_count; j++) {
+            if (delta->taken && BIT_TEST(delta->taken, j)) continue;
+            if (strcmp(symbol_name(&next->item_symbols, b->items[j]), item_id) != 0) continue;
+
+            if (!delta->taken) {
+                delta->taken = calloc(BITSET_WORDS(b->items_count), sizeof(unsigned int));
+                if (!delta->taken) {
+                    printf("Error: Could not allocate location state\n");
+                    return false;
+                }
+            }
+            BIT_SET(delta->taken, j);
+            break;
+        }
+    }
+    return true;
+}
+
+static bool rebase_deltas(GameState* rebased, const GameState* game, const WorldDiff* diff) {
+    const World* previous = game->world;
+    const World* next = rebased->world;
+    if (!reserve_location_deltas(rebased, game->overlay.count)) return false;
+
+    for (int i = 0; i < game->overlay.capacity; i++) {
+        const LocationDelta* delta = &game->overlay.deltas[i];
+        if (delta->location == INVALID_LOCATION) continue;
+        int j = diff->locations[delta->location];
+        if (j == INVALID_LOCATION) continue;
+
+        LocationDelta* moved = touch_location(rebased, j);
+        if (!moved) return false;
+        moved->state = delta->state;
+        if (delta->taken && !rebase_taken(moved, previous, &previous->locations[delta->location], delta->taken,
+                                          next, &next->locations[j])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Set each named bit the old session had set wherever next still has the name
+static int rebase_bits(const SymbolTable* previous_table, const unsigned int* previous,
+                       const SymbolTable* next_table, unsigned int* next) {
+    int count = 0;
+    for (int k = 0; k < previous_table->count; k++) {
+        int symbol = symbol_lookup(next_table, symbol_name(previous_table, k));
+        if (symbol == INVALID_SYMBOL) continue;
+        if (BIT_TEST(previous, k)) {
+            BIT_SET(next, symbol);
+            count++;
+        } else {
+            BIT_CLEAR(next, symbol);
+        }
+    }
+    return count;
+}
+
+GameState* rebase_session(const GameState* game, const World* next, const WorldDiff* diff) {
+    GameState* rebased = create_session(next);
+    if (!rebased) return NULL;
+
+    const World* previous = game->world;
+    int current = game->player.current_location_index;
+    if (current != INVALID_LOCATION && diff->locations[current] != INVALID_LOCATION) {
+        rebased->player.current_location_index = diff->locations[current];
+    }
+
+    // The player keeps what they carry, not next's starting inventory
+    memset(rebased->player.inventory, 0, next->item_words * sizeof(unsigned int));
+    rebased->player.inventory_count = rebase_bits(&previous->item_symbols, game->player.inventory,
+                                                  &next->item_symbols, rebased->player.inventory);
+
+    // Flags next introduces keep their defaults
+    rebase_bits(&previous->flag_symbols, game->player.flags, &next->flag_symbols, rebased->player.flags);
+
+    rebased->tick = game->tick;
+    rebased->quiet = game->quiet;
+    rebased->output = game->output;
+    rebased->output_context = game->output_context;
+
+    if (!rebase_deltas(rebased, game, diff)) {
+        cleanup_session(rebased);
+        return NULL;
+    }
+    return rebased;
+}
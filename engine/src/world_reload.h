@@ -0,0 +1,31 @@
+#ifndef WORLD_RELOAD_H
+#define WORLD_RELOAD_H
+
+#include <stdbool.h>
+#include "adventure_engine.h"
+
+// How a reloaded world differs from the one a session is playing, by id
+typedef struct {
+    int* locations; // Old location index -> new index, INVALID_LOCATION if the id is gone
+    unsigned int* changed; // Bit per old location whose record or text differs in the new world
+    int old_locations_count;
+    int locations_changed;
+    int locations_added;
+    int locations_removed;
+    int items_changed; // Inventory item definitions added, removed or edited
+    bool start_changed; // Start location, player or game flag defaults differ
+} WorldDiff;
+
+// Compare every location and item of next against previous. Lazily loaded
+// worlds have their text decoded one location at a time to compare it.
+bool diff_worlds(const World* previous, const World* next, WorldDiff* diff);
+void free_world_diff(WorldDiff* diff);
+
+// A session on next that carries on from game: the player's location,
+// inventory and flags, the tick and every location delta move over by id.
+// Ids next no longer defines are dropped, and a player whose location is gone
+// goes back to next's start. The output settings are copied, ownership of the
+// world is not, and game itself is left as it was.
+GameState* rebase_session(const GameState* game, const World* next, const WorldDiff* diff);
+
+#endif // WORLD_RELOAD_H
@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""Check that a game and the bundle compiled from it load as the same world.
+
+Snapshots and journals record a fingerprint of the world's symbol names, so
+a save made while playing the .advgpt must resume in the .advgptb, and the
+other way round. The headless driver refuses a snapshot from another world,
+which makes each resume below a comparison of the two fingerprints. Run by
+`make check-formats`.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "editor"))
+from advgpt_format import AdvGPTFormat  # noqa: E402
+from generate_world import generate_world  # noqa: E402
+
+
+def condition_order_world():
+    """Flags named only by conditions, with flags_set before flags_required in one room."""
+    game = AdvGPTFormat.create_empty_game()
+    start = game["locations"]["start"]
+    start["exits"] = {"north": "hall"}
+    del start["flags_required"], start["flags_set"]
+    start["flags_set"] = {"zeta": True}
+    start["flags_required"] = {"alpha": True}
+    game["locations"]["hall"] = {
+        "id": "hall", "title": "Hall", "description": "A hall.", "image": "",
+        "items": ["lamp"], "exits": {"south": "start"},
+        "flags_required": {"beta": False}, "flags_set": {"alpha": True, "zeta": False},
+    }
+    return game
+
+
+def worlds():
+    yield "conditions", condition_order_world()
+    yield "generated", generate_world(200, fanout=3, item_density=0.3, flag_density=0.2, description_words=8, seed=7)
+
+
+def resume(engine, snapshot, *args):
+    result = subprocess.run([engine, "--quiet", "--walk", "200", "--save", snapshot, *args],
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    return result.returncode == 0, result.stdout
+
+
+def check(engine, workdir, name, game):
+    source = os.path.join(workdir, f"{name}.advgpt")
+    bundle = os.path.join(workdir, f"{name}.advgptb")
+    with open(source, "w") as f:
+        json.dump(game, f)
+    if not AdvGPTFormat.save_bundle(game, bundle):
+        return [f"{name}: could not compile the bundle"]
+
+    failures = []
+    for first, second in ((source, bundle), (bundle, source), (source, "--lazy " + source)):
+        snapshot = os.path.join(workdir, f"{name}.snapshot")
+        if os.path.exists(snapshot):
+            os.remove(snapshot)
+        for path in (first, second):
+            ok, output = resume(engine, snapshot, *path.split(" "))
+            if not ok:
+                failures.append(f"{name}: {os.path.basename(first)} -> {path}\n{output.strip()}")
+                break
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--engine", required=True, help="path of the headless driver")
+    parser.add_argument("--workdir", required=True, help="directory for the generated games")
+    args = parser.parse_args()
+
+    os.makedirs(args.workdir, exist_ok=True)
+    failures = []
+    for name, game in worlds():
+        failures += check(args.engine, args.workdir, name, game)
+
+    for failure in failures:
+        print(f"FAIL {failure}")
+    if failures:
+        return 1
+    print("Game files and bundles load as the same worlds")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""Generate engine/src/command_words.h, the perfect-hash table of command words.
+
+Every verb, verb alias and direction alias the parser knows is listed below.
+The script searches for a hash seed under which no two words share a slot, so
+a lookup is one hash, one slot and one compare. Run `make command-words` after
+editing the vocabulary and commit the regenerated header.
+"""
+
+import argparse
+import sys
+
+# word -> (verb, direction); a bare direction word means "go <direction>"
+VERBS = {
+    "VERB_GO": ["go", "move", "walk"],
+    "VERB_TAKE": ["take", "get", "grab"],
+    "VERB_LOOK": ["look", "l"],
+    "VERB_INVENTORY": ["inventory", "inv", "i"],
+    "VERB_HELP": ["help", "?"],
+    "VERB_QUIT": ["quit", "exit", "q"],
+}
+
+DIRECTIONS = {
+    "DIRECTION_NORTH": ["north", "n"],
+    "DIRECTION_SOUTH": ["south", "s"],
+    "DIRECTION_EAST": ["east", "e"],
+    "DIRECTION_WEST": ["west", "w"],
+    "DIRECTION_NORTHEAST": ["northeast", "ne"],
+    "DIRECTION_NORTHWEST": ["northwest", "nw"],
+    "DIRECTION_SOUTHEAST": ["southeast", "se"],
+    "DIRECTION_SOUTHWEST": ["southwest", "sw"],
+    "DIRECTION_UP": ["up", "u"],
+    "DIRECTION_DOWN": ["down", "d"],
+    "DIRECTION_IN": ["in", "inside"],
+    "DIRECTION_OUT": ["out", "outside"],
+}
+
+SLOT_BITS = 7
+SLOTS = 1 << SLOT_BITS
+MAX_SEED_TRIES = 1 << 24
+
+
+def vocabulary():
+    words = {}
+    for verb, aliases in VERBS.items():
+        for word in aliases:
+            words[word] = (verb, "DIRECTION_NONE")
+    for direction, aliases in DIRECTIONS.items():
+        for word in aliases:
+            if word in words:
+                sys.exit(f"error: '{word}' is listed twice")
+            words[word] = ("VERB_NONE", direction)
+    return words
+
+
+# Must match hash_step in src/command_parser.c: FNV-1a over the lowercased
+# word, starting from the seed instead of the usual offset basis
+def word_hash(word, seed):
+    value = seed
+    for byte in word.encode("ascii"):
+        value ^= byte
+        value = (value * 16777619) & 0xFFFFFFFF
+    return value
+
+
+# The top bits: FNV's low bits only depend on the low bits of the seed
+def word_slot(word, seed):
+    return word_hash(word, seed) >> (32 - SLOT_BITS)
+
+
+def find_seed(words):
+    for seed in range(1, MAX_SEED_TRIES):
+        slots = {word_slot(word, seed) for word in words}
+        if len(slots) == len(words):
+            return seed
+    sys.exit(f"error: no perfect seed for {len(words)} words in {SLOTS} slots")
+
+
+def render(words, seed):
+    table = {word_slot(word, seed): word for word in words}
+    lines = [
+        "// Generated by tools/gen_command_words.py; edit the vocabulary there and",
+        "// run `make command-words` instead of changing this file by hand.",
+        "#ifndef COMMAND_WORDS_H",
+        "#define COMMAND_WORDS_H",
+        "",
+        '#include "command_parser.h"',
+        "",
+        f"#define COMMAND_WORD_SEED {seed}u",
+        f"#define COMMAND_WORD_SLOT_BITS {SLOT_BITS}",
+        f"#define COMMAND_WORD_SLOTS {SLOTS}",
+        "",
+        "static const CommandWord command_words[COMMAND_WORD_SLOTS] = {",
+    ]
+    for slot in sorted(table):
+        word = table[slot]
+        verb, direction = words[word]
+        lines.append(f'    [{slot}] = {{"{word}", {len(word)}, {verb}, {direction}}},')
+    lines += ["};", "", "#endif // COMMAND_WORDS_H", ""]
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--output", default="src/command_words.h", help="Header to write")
+    args = parser.parse_args()
+
+    words = vocabulary()
+    seed = find_seed(words)
+    with open(args.output, "w", newline="\n") as out:
+        out.write(render(words, seed))
+    print(f"Wrote {args.output}: {len(words)} words in {SLOTS} slots, seed {seed}")
+
+
+if __name__ == "__main__":
+    main()